@@ -12,6 +12,7 @@
 #include "OpenGL2ShaderColorPos.hpp"
 #include "OpenGL2ShaderPosClr.hpp"
 #include "OpenGL2ShaderColorPosTex.hpp"
+#include "OpenGL2ShaderColorPosTexSdf.hpp"
 #include "OpenGL2FrameBuffer.hpp"
 
 
@@ -114,6 +115,7 @@ std::unique_ptr<morda::Factory::Shaders> OpenGL2Factory::createShaders() {
 	ret->colorPos = utki::makeUnique<OpenGL2ShaderColorPos>();
 	ret->posClr = utki::makeUnique<OpenGL2ShaderPosClr>();
 	ret->colorPosTex = utki::makeUnique<OpenGL2ShaderColorPosTex>();
+	ret->colorPosTexSdf = utki::makeUnique<OpenGL2ShaderColorPosTexSdf>();
 	return ret;
 }
 
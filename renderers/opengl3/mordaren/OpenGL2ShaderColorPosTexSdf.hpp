@@ -0,0 +1,16 @@
+#pragma once
+
+#include <morda/render/ShaderColorPosTex.hpp>
+
+#include "OpenGL2Shader.hpp"
+
+class OpenGL2ShaderColorPosTexSdf : public morda::ShaderColorPosTex, public OpenGL2Shader{
+	GLint colorUniform;
+public:
+	OpenGL2ShaderColorPosTexSdf();
+	
+	OpenGL2ShaderColorPosTexSdf(const OpenGL2ShaderColorPosTexSdf&) = delete;
+	OpenGL2ShaderColorPosTexSdf& operator=(const OpenGL2ShaderColorPosTexSdf&) = delete;
+	
+	void render(const kolme::Matr4f& m, const morda::Texture2D& tex, kolme::Vec4f color, const morda::VertexArray& va) override;
+};
@@ -42,10 +42,10 @@ Inflater::Inflater(){
 
 
 
-void Inflater::addWidgetFactory(const std::string& widgetName, decltype(widgetFactories)::value_type::second_type factory){
+void Inflater::addWidgetFactory(const std::string& widgetName, Factory factory){
 	auto ret = this->widgetFactories.insert(std::make_pair(
 			widgetName,
-			std::move(factory)
+			factory
 		));
 	if(!ret.second){
 		throw Inflater::Exc("Failed registering widget type, widget type with given name is already added");
@@ -73,10 +73,14 @@ std::shared_ptr<morda::Widget> Inflater::inflate(papki::File& fi) {
 
 namespace{
 const char* defs_c = "defs";
+
+//maximum number of prototypes compiled from strings to keep in cache
+const size_t maxCachedPrototypes_c = 256;
 }
 
 namespace{
-void substituteVars(stob::Node* to, const std::function<const stob::Node*(const std::string&)>& findVar){
+//If 'intoWidgets' is false then variables are only substituted in properties, but not in child widgets.
+void substituteVars(stob::Node* to, const std::function<const stob::Node*(const std::string&)>& findVar, bool intoWidgets = true){
 	if(!to || !findVar){
 		return;
 	}
@@ -104,7 +108,7 @@ void substituteVars(stob::Node* to, const std::function<const stob::Node*(const
 				continue;
 			}
 		}else{
-			if(to->child()){
+			if(to->child() && (intoWidgets || to->isProperty())){
 				substituteVars(to->child(), findVar);
 			}
 		}
@@ -180,65 +184,234 @@ std::unique_ptr<stob::Node> mergeGUIChain(const stob::Node* tmplChain, const std
 }
 }
 
-const decltype(Inflater::widgetFactories)::value_type::second_type* Inflater::findFactory(const std::string& widgetName) {
+Inflater::Factory Inflater::findFactory(const std::string& widgetName)const{
 	auto i = this->widgetFactories.find(widgetName);
 
 	if(i == this->widgetFactories.end()){
 		return nullptr;
 	}
 	
-	return &i->second;
+	return i->second;
 }
 
 
-std::shared_ptr<morda::Widget> Inflater::inflate(const char* str){
-	return this->inflate(*stob::parse(str));
+namespace{
+//calls given function for each widget of the chain and their child widgets
+void forEachWidget(const stob::Node* chain, const std::function<void(const stob::Node&)>& f){
+	for(auto n = chain; n; n = n->next()){
+		if(n->isProperty()){
+			continue;
+		}
+		f(*n);
+		forEachWidget(n->child(), f);
+	}
+}
 }
 
 
-std::shared_ptr<morda::Widget> Inflater::inflate(const stob::Node& chain){
-//	TODO:
-//	if(!App::inst().thisIsUIThread()){
-//		throw Exc("Inflate called not from UI thread");
-//	}
+
+Inflater::Prototype::Prototype(Inflater& inflater, std::unique_ptr<stob::Node> tree) :
+		inflater(&inflater),
+		tree(std::move(tree)),
+		chain_v(this->tree.get())
+{}
+
+
+
+Inflater::Prototype::Prototype(std::shared_ptr<const Prototype> root, const stob::Node* chain) :
+		inflater(nullptr),
+		root(std::move(root)),
+		chain_v(chain)
+{}
+
+
+
+Inflater::Prototype::~Prototype()noexcept{
+	if(!this->inflater){
+		return;
+	}
+	
+	forEachWidget(
+			this->tree.get(),
+			[this](const stob::Node& n){
+				this->inflater->compiledNodes.erase(&n);
+			}
+		);
+}
+
+
+
+Inflater::~Inflater()noexcept{
+	{
+		std::lock_guard<std::mutex> lock(this->asyncMutex);
+		this->asyncQuit = true;
+	}
+	this->asyncCondVar.notify_one();
+	
+	//NOTE: Morda is still alive here, so the GUI script being expanded can still be posted to UI thread
+	if(this->asyncThread.joinable()){
+		this->asyncThread.join();
+	}
+	
+	//prototypes can outlive the inflater
+	for(auto& p : this->compiledNodes){
+		const_cast<Prototype*>(p.second.prototype)->inflater = nullptr;
+	}
+}
+
+
+
+std::shared_ptr<const Inflater::Prototype> Inflater::makePrototype(std::unique_ptr<stob::Node> tree){
+	M_MORDA_PROFILE_SCOPE("inflate", "Inflater::compile")
+	
+	auto ret = std::shared_ptr<Prototype>(new Prototype(*this, std::move(tree)));
 	
+	forEachWidget(
+			ret->chain(),
+			[this, &ret](const stob::Node& n){
+				auto fac = this->findFactory(n.value());
+				if(!fac){
+					TRACE(<< "Inflater::makePrototype(): n.value() = " << n.value() << std::endl)
+					std::stringstream ss;
+					ss << "Failed to inflate, no matching factory found for requested widget name: " << n.value();
+					throw Exc(ss.str());
+				}
+				this->compiledNodes.insert(std::make_pair(&n, CompiledWidget{ret.get(), fac, PropertyTable(n.child())}));
+			}
+		);
+	
+	return ret;
+}
+
+
+
+std::unique_ptr<stob::Node> Inflater::Definitions::expand(std::unique_ptr<stob::Node> w){
+	ASSERT(w)
+	ASSERT(!w->isProperty())
+	ASSERT(!w->next())
+	
+	if(auto tmpl = this->findTemplate(w->value())){
+		auto children = w->removeChildren();
+		w->setValue(tmpl->t->value());
+		w->setChildren(mergeGUIChain(tmpl->t->child(), tmpl->vars, std::move(children)));
+	}
+	
+	unsigned numPopDefs = 0;
+	utki::ScopeExit scopeExit([this, &numPopDefs](){
+		for(unsigned i = 0; i != numPopDefs; ++i){
+			this->popDefs();
+		}
+	});
+	
+	//apply definitions and remove them from the widget description
+	auto head = utki::makeUnique<stob::Node>();
+	{
+		auto last = head.get();
+		for(auto c = w->removeChildren(); c;){
+			auto tail = c->chopNext();
+			if(*c == defs_c){
+				if(c->child()){
+					this->pushDefs(*c->child());
+					++numPopDefs;
+				}
+			}else{
+				last->insertNext(std::move(c));
+				last = last->next();
+			}
+			c = std::move(tail);
+		}
+	}
+	
+	//child widgets will have the variables substituted when expanding them
+	this->substituteVariables(head->next(), false);
+	
+	//expand child widgets
+	{
+		auto last = head.get();
+		for(auto c = head->chopNext(); c;){
+			auto tail = c->chopNext();
+			if(!c->isProperty()){
+				c = this->expand(std::move(c));
+			}
+			last->insertNext(std::move(c));
+			last = last->next();
+			c = std::move(tail);
+		}
+	}
+	
+	w->setChildren(head->chopNext());
+	
+	return w;
+}
+
+
+
+std::shared_ptr<morda::Widget> Inflater::instantiate(const stob::Node& w, const CompiledWidget& compiled){
+	ASSERT(compiled.factory)
+	ASSERT(compiled.properties.chain() == w.child())
+	
+	M_MORDA_PROFILE_SCOPE("inflate", "Inflater::inflate", w.value())
+	
+	//widget constructors will read properties from the table
+	PropertyTable::Scope scope(compiled.properties);
+	
+	return compiled.factory(w.child());
+}
+
+
+
+std::shared_ptr<morda::Widget> Inflater::instantiate(const Prototype& prototype){
+	if(!prototype.chain()){
+		return nullptr;
+	}
+	
+	auto i = this->compiledNodes.find(prototype.chain());
+	ASSERT(i != this->compiledNodes.end())
+	
+	return this->instantiate(*prototype.chain(), i->second);
+}
+
+
+
+const stob::Node* Inflater::applyDefs(const stob::Node& chain){
 	const stob::Node* n = &chain;
 	for(; n && n->isProperty(); n = n->next()){
 		if(*n == defs_c){
 			if(n->child()){
-				this->pushDefs(*n->child());
+				this->defs.pushDefs(*n->child());
+				
+				//cached prototypes were compiled without these definitions
+				this->clearCache();
 			}
 		}else{
 			throw Exc("Inflater::Inflate(): unknown declaration encountered before first widget");
 		}
 	}
+	return n;
+}
+
+
+
+std::shared_ptr<const Inflater::Prototype> Inflater::compile(const stob::Node& chain){
+	const stob::Node* n = this->applyDefs(chain);
 	
 	if(!n){
-		return nullptr;
+		return this->makePrototype(nullptr);
 	}
 	
-	ASSERT(!n->isProperty())
-	
-	std::unique_ptr<stob::Node> cloned;
-//	TRACE(<< "inflating = " << n->value() << std::endl)
-	if(auto tmpl = this->findTemplate(n->value())){
-//		TRACE(<< "template name = " << n->value() << std::endl)
-		cloned = utki::makeUnique<stob::Node>(tmpl->t->value());
-		cloned->setChildren(mergeGUIChain(tmpl->t->child(), tmpl->vars, n->cloneChildren()));
-		n = cloned.get();
-//		TRACE(<< "n = " << n->chainToString(true) << std::endl)
+	auto i = this->compiledNodes.find(n);
+	if(i != this->compiledNodes.end()){
+		return std::shared_ptr<const Prototype>(new Prototype(i->second.prototype->sharedFromThis(i->second.prototype), n));
 	}
 	
-	
-	auto fac = this->findFactory(n->value());
-	
-	if(!fac){
-		TRACE(<< "Inflater::Inflate(): n->value() = " << n->value() << std::endl)
-		std::stringstream ss;
-		ss << "Failed to inflate, no matching factory found for requested widget name: " << n->value();
-		throw Exc(ss.str());
-	}
+	return this->makePrototype(this->defs.expandChain(*n));
+}
+
+
 
+std::unique_ptr<stob::Node> Inflater::Definitions::expandChain(const stob::Node& chain){
+	const stob::Node* n = chain.thisOrNextNonProperty().node();
+	
 	unsigned numPopDefs = 0;
 	utki::ScopeExit scopeExit([this, &numPopDefs](){
 		for(unsigned i = 0; i != numPopDefs; ++i){
@@ -246,24 +419,223 @@ std::shared_ptr<morda::Widget> Inflater::inflate(const stob::Node& chain){
 		}
 	});
 	
-	for(auto v = n->child(defs_c).node(); v; v = v->next(defs_c).node()){
-		if(v->child()){
-			this->pushDefs(*v->child());
+	for(auto d = &chain; d != n; d = d->next()){
+		if(*d == defs_c && d->child()){
+			this->pushDefs(*d->child());
 			++numPopDefs;
 		}
 	}
+	
+	auto head = utki::makeUnique<stob::Node>();
+	auto last = head.get();
+	for(; n; n = n->nextNonProperty().node()){
+		last->insertNext(this->expand(n->clone()));
+		last = last->next();
+	}
+	
+	return head->chopNext();
+}
+
+
+
+std::shared_ptr<const Inflater::Prototype> Inflater::compile(const char* str){
+	{
+		auto i = this->prototypesCache.find(str);
+		if(i != this->prototypesCache.end()){
+			//move to the front of the last used order
+			this->prototypesLastUsedOrder.splice(this->prototypesLastUsedOrder.begin(), this->prototypesLastUsedOrder, i->second.lastUsedIter);
+			return i->second.prototype;
+		}
+	}
+	
+	auto chain = stob::parse(str);
+	
+	if(!chain){
+		return this->makePrototype(nullptr);
+	}
+	
+	auto ret = this->compile(*chain);
+	
+	if(chain->isProperty()){
+		//definitions preceding the first widget are applied globally, so compiling such GUI script has side effect, do not cache it
+		return ret;
+	}
+	
+	if(this->prototypesCache.size() == maxCachedPrototypes_c){
+		auto last = this->prototypesLastUsedOrder.back();
+		this->prototypesLastUsedOrder.pop_back();
+		this->prototypesCache.erase(*last);
+	}
+	
+	auto i = this->prototypesCache.insert(std::make_pair(std::string(str), CachedPrototype{ret, this->prototypesLastUsedOrder.end()})).first;
+	this->prototypesLastUsedOrder.push_front(&i->first);
+	i->second.lastUsedIter = this->prototypesLastUsedOrder.begin();
+	
+	return ret;
+}
+
+
+
+std::shared_ptr<morda::Widget> Inflater::inflate(const char* str){
+	//hold the prototype while inflating, as it can be dropped from the cache meanwhile
+	auto p = this->compile(str);
+	
+	return this->instantiate(*p);
+}
+
+
+std::shared_ptr<morda::Widget> Inflater::inflate(const stob::Node& chain){
+//	TODO:
+//	if(!App::inst().thisIsUIThread()){
+//		throw Exc("Inflate called not from UI thread");
+//	}
+	
+	{
+		auto i = this->compiledNodes.find(&chain);
+		if(i != this->compiledNodes.end()){
+			return this->instantiate(chain, i->second);
+		}
+	}
+	
+	const stob::Node* n = this->applyDefs(chain);
+	
+	if(!n){
+		return nullptr;
+	}
+	
+	ASSERT(!n->isProperty())
+	
+	{
+		auto i = this->compiledNodes.find(n);
+		if(i != this->compiledNodes.end()){
+			return this->instantiate(*n, i->second);
+		}
+	}
+	
+	auto p = this->makePrototype(this->defs.expand(n->clone()));
+	ASSERT(p->chain())
+	
+	return this->instantiate(*p);
+}
+
 
-	if(cloned){
-		cloned = cloned->removeChildren();
-	}else{
-		if(n->child()){
-			cloned = n->child()->cloneChain();
+
+void Inflater::asyncThreadMain(){
+	for(;;){
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(this->asyncMutex);
+			this->asyncCondVar.wait(lock, [this](){
+				return this->asyncQuit || this->asyncQueue.size() != 0;
+			});
+			
+			//pending jobs are dropped
+			if(this->asyncQuit){
+				return;
+			}
+			
+			job = std::move(this->asyncQueue.front());
+			this->asyncQueue.pop_front();
 		}
+		
+		job();
 	}
+}
+
+
+
+void Inflater::inflateAsync(std::function<std::unique_ptr<stob::Node>()>&& load, std::function<void(std::shared_ptr<morda::Widget>)>&& done){
+	//copy definitions here on UI thread, so that worker thread does not access the inflater
+	auto defs = std::make_shared<Definitions>(this->defs);
+	
+	std::weak_ptr<bool> alive = this->asyncAliveToken;
 	
-	this->substituteVariables(cloned.get());
+	auto job = [this, defs, alive, load, done](){
+		auto tree = std::make_shared<std::unique_ptr<stob::Node>>();
+		
+		//definitions preceding the first widget, to be applied globally on UI thread
+		auto leadingDefs = std::make_shared<std::vector<std::unique_ptr<stob::Node>>>();
+		
+		try{
+			if(auto chain = load()){
+				for(auto d = chain.get(); d && d->isProperty(); d = d->next()){
+					if(*d == defs_c && d->child()){
+						leadingDefs->push_back(d->cloneChildren());
+					}
+				}
+				*tree = defs->expandChain(*chain);
+			}
+		}catch(std::exception& e){
+			TRACE(<< "Inflater::inflateAsync(): failed to expand GUI script: " << e.what() << std::endl)
+			tree->reset();
+		}
+		
+		//the inflater joins this thread before being destroyed, so Morda is alive here
+		morda::Morda::inst().postToUiThread([this, alive, tree, leadingDefs, done](){
+			//the inflater, and Morda with it, could have been destroyed before UI thread got to this
+			if(alive.expired()){
+				return;
+			}
+			
+			std::shared_ptr<morda::Widget> w;
+			
+			if(leadingDefs->size() != 0){
+				for(auto& d : *leadingDefs){
+					this->defs.pushDefs(*d);
+				}
+				this->clearCache();
+			}
+			
+			if(*tree){
+				try{
+					w = this->instantiate(*this->makePrototype(std::move(*tree)));
+				}catch(std::exception& e){
+					TRACE(<< "Inflater::inflateAsync(): failed to inflate GUI script: " << e.what() << std::endl)
+					w.reset();
+				}
+			}
+			
+			done(std::move(w));
+		});
+	};
+	
+	{
+		std::lock_guard<std::mutex> lock(this->asyncMutex);
+		this->asyncQueue.push_back(std::move(job));
+	}
+	this->asyncCondVar.notify_one();
+	
+	if(!this->asyncThread.joinable()){
+		this->asyncThread = std::thread([this](){
+			this->asyncThreadMain();
+		});
+	}
+}
+
 
-	return fac->operator()(cloned.get());
+
+void Inflater::inflateAsync(std::string&& str, std::function<void(std::shared_ptr<morda::Widget>)>&& done){
+	auto s = std::make_shared<std::string>(std::move(str));
+	
+	this->inflateAsync(
+			[s](){
+				return stob::parse(s->c_str());
+			},
+			std::move(done)
+		);
+}
+
+
+
+void Inflater::inflateAsync(std::unique_ptr<papki::File> fi, std::function<void(std::shared_ptr<morda::Widget>)>&& done){
+	std::shared_ptr<papki::File> f(std::move(fi));
+	
+	this->inflateAsync(
+			[f](){
+				return load(*f);
+			},
+			std::move(done)
+		);
 }
 
 
@@ -276,7 +648,7 @@ std::unique_ptr<stob::Node> Inflater::load(papki::File& fi){
 	return ret;
 }
 
-Inflater::Template Inflater::parseTemplate(const stob::Node& chain){
+Inflater::Definitions::Template Inflater::Definitions::parseTemplate(const stob::Node& chain){
 	Template ret;
 	
 	for(auto n = &chain; n; n = n->next()){
@@ -320,20 +692,20 @@ Inflater::Template Inflater::parseTemplate(const stob::Node& chain){
 	return ret;
 }
 
-void Inflater::pushDefs(const stob::Node& chain) {
+void Inflater::Definitions::pushDefs(const stob::Node& chain) {
 	this->pushVariables(chain);
 	this->pushTemplates(chain);
 }
 
-void Inflater::popDefs() {
+void Inflater::Definitions::popDefs() {
 	this->popVariables();
 	this->popTemplates();
 }
 
 
 
-void Inflater::pushTemplates(const stob::Node& chain){
-	decltype(this->templates)::value_type m;
+void Inflater::Definitions::pushTemplates(const stob::Node& chain){
+	std::map<std::string, Template> m;
 	
 	for(auto c = &chain; c; c = c->next()){
 		if(c->isProperty()){
@@ -341,7 +713,7 @@ void Inflater::pushTemplates(const stob::Node& chain){
 		}
 		
 		if(!c->child()){
-			throw Exc("Inflater::pushTemplates(): template name has no children, error.");
+			throw Exc("Inflater::Definitions::pushTemplates(): template name has no children, error.");
 		}
 //		TRACE(<< "pushing template = " << c->value() << std::endl)
 		if(!m.insert(std::make_pair(c->value(), parseTemplate(c->up()))).second){
@@ -349,7 +721,11 @@ void Inflater::pushTemplates(const stob::Node& chain){
 		}
 	}
 	
-	this->templates.push_front(std::move(m));
+	this->templates.push_front(std::make_shared<const decltype(m)>(std::move(m)));
+	
+	for(auto& t : *this->templates.front()){
+		this->templatesIndex[t.first].push_back(&t.second);
+	}
 	
 //#ifdef DEBUG
 //	TRACE(<< "Templates Stack:" << std::endl)
@@ -364,47 +740,67 @@ void Inflater::pushTemplates(const stob::Node& chain){
 
 
 
-void Inflater::popTemplates(){
+void Inflater::Definitions::popTemplates(){
 	ASSERT(this->templates.size() != 0)
+	
+	for(auto& t : *this->templates.front()){
+		auto i = this->templatesIndex.find(t.first);
+		ASSERT(i != this->templatesIndex.end())
+		ASSERT(i->second.size() != 0 && i->second.back() == &t.second)
+		i->second.pop_back();
+		if(i->second.size() == 0){
+			this->templatesIndex.erase(i);
+		}
+	}
+	
 	this->templates.pop_front();
 }
 
 
 
-const Inflater::Template* Inflater::findTemplate(const std::string& name)const{
-	for(auto& i : this->templates){
-		auto r = i.find(name);
-		if(r != i.end()){
-			return &r->second;
-		}
+const Inflater::Definitions::Template* Inflater::Definitions::findTemplate(const std::string& name)const{
+	auto i = this->templatesIndex.find(name);
+	if(i == this->templatesIndex.end()){
+//		TRACE(<< "Inflater::FindTemplate(): template '" << name <<"' not found!!!" << std::endl)
+		return nullptr;
 	}
-//	TRACE(<< "Inflater::FindTemplate(): template '" << name <<"' not found!!!" << std::endl)
-	return nullptr;
+	ASSERT(i->second.size() != 0)
+	return i->second.back();
 }
 
 
 
-const stob::Node* Inflater::findVariable(const std::string& name)const{
-	for(auto& i : this->variables){
-		auto r = i.find(name);
-		if(r != i.end()){
-			return r->second.get();
-		}
+const stob::Node* Inflater::Definitions::findVariable(const std::string& name)const{
+	auto i = this->variablesIndex.find(name);
+	if(i == this->variablesIndex.end()){
+//		TRACE(<< "Inflater::Definitions::findVariable(): variable '" << name <<"' not found!!!" << std::endl)
+		return nullptr;
 	}
-//	TRACE(<< "Inflater::findVariable(): variable '" << name <<"' not found!!!" << std::endl)
-	return nullptr;
+	ASSERT(i->second.size() != 0)
+	return i->second.back();
 }
 
 
 
-void Inflater::popVariables(){
+void Inflater::Definitions::popVariables(){
 	ASSERT(this->variables.size() != 0)
+	
+	for(auto& v : *this->variables.front()){
+		auto i = this->variablesIndex.find(v.first);
+		ASSERT(i != this->variablesIndex.end())
+		ASSERT(i->second.size() != 0 && i->second.back() == v.second.get())
+		i->second.pop_back();
+		if(i->second.size() == 0){
+			this->variablesIndex.erase(i);
+		}
+	}
+	
 	this->variables.pop_front();
 }
 
 
-void Inflater::pushVariables(const stob::Node& chain){
-	decltype(this->variables)::value_type m;
+void Inflater::Definitions::pushVariables(const stob::Node& chain){
+	std::map<std::string, std::unique_ptr<stob::Node>> m;
 	
 	for(auto n = &chain; n; n = n->next()){
 		if(!n->isProperty()){
@@ -423,7 +819,11 @@ void Inflater::pushVariables(const stob::Node& chain){
 		}
 	}
 	
-	this->variables.push_front(std::move(m));
+	this->variables.push_front(std::make_shared<const decltype(m)>(std::move(m)));
+	
+	for(auto& v : *this->variables.front()){
+		this->variablesIndex[v.first].push_back(v.second.get());
+	}
 	
 //#ifdef DEBUG
 //	TRACE(<< "Variables Stack:" << std::endl)
@@ -436,11 +836,12 @@ void Inflater::pushVariables(const stob::Node& chain){
 //#endif
 }
 
-void Inflater::substituteVariables(stob::Node* to)const{
+void Inflater::Definitions::substituteVariables(stob::Node* to, bool intoWidgets)const{
 	substituteVars(
 			to,
 			[this](const std::string& name) -> const stob::Node*{
 				return this->findVariable(name);
-			}
+			},
+			intoWidgets
 		);
 }
@@ -1,12 +1,21 @@
 #pragma once
 
 #include <map>
+#include <list>
+#include <deque>
 #include <memory>
+#include <unordered_map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "Exc.hpp"
 
 #include "widgets/Widget.hpp"
 
+#include "util/PropertyTable.hpp"
+
 
 
 namespace morda{
@@ -25,6 +34,9 @@ class Inflater{
 
 	Inflater();
 public:
+	~Inflater()noexcept;
+	
+
 	/**
 	 * @brief Basic Inflater Exception class.
 	 * @param message
@@ -37,11 +49,17 @@ public:
 	};
 
 private:
-	std::map<std::string, std::function<std::shared_ptr<morda::Widget>(const stob::Node*)> > widgetFactories;
+	typedef std::shared_ptr<morda::Widget> (*Factory)(const stob::Node* chain);
+	
+	template <class T_Widget> static std::shared_ptr<morda::Widget> makeWidget(const stob::Node* chain){
+		return std::make_shared<T_Widget>(chain);
+	}
+	
+	std::unordered_map<std::string, Factory> widgetFactories;
 
-	const decltype(widgetFactories)::value_type::second_type* findFactory(const std::string& widgetName);
+	Factory findFactory(const std::string& widgetName)const;
 	
-	void addWidgetFactory(const std::string& widgetName, decltype(widgetFactories)::value_type::second_type factory);
+	void addWidgetFactory(const std::string& widgetName, Factory factory);
 
 public:
 	//TODO: remove deprecated method
@@ -57,24 +75,88 @@ public:
 	 * @param widgetName - name of the widget as it appears in GUI script.
 	 */
 	template <class T_Widget> void registerType(const std::string& widgetName){
-		this->addWidgetFactory(
-				widgetName,
-				[](const stob::Node* chain) -> std::shared_ptr<morda::Widget> {
-					return std::make_shared<T_Widget>(chain);
-				}
-			);
+		this->addWidgetFactory(widgetName, &makeWidget<T_Widget>);
 	}
 
 	/**
 	 * @brief Remove previously registered widget type.
+	 * Prototypes which have already been compiled keep using the removed widget type.
 	 * @param widgetName - widget name as it appears in GUI script.
 	 * @return true if factory was successfully removed.
 	 * @return false if the factory with given widget name was not found in the list of registered factories.
 	 */
 	bool removeWidget(const std::string& widgetName)noexcept;
 
+	/**
+	 * @brief Compiled GUI script.
+	 * Prototype holds a GUI script with all templates expanded, all variables substituted
+	 * and all definition blocks removed. Prototype is immutable.
+	 * Widgets are inflated from prototype without any copying of the GUI script, so
+	 * compiling the GUI script once and inflating it many times is cheap.
+	 */
+	class Prototype : public utki::Shared{
+		friend class Inflater;
+		
+		Inflater* inflater;
+		
+		//root prototype owns the expanded GUI script, sub-prototype holds its root prototype
+		std::unique_ptr<stob::Node> tree;
+		std::shared_ptr<const Prototype> root;
+		
+		const stob::Node* chain_v;
+		
+		Prototype(Inflater& inflater, std::unique_ptr<stob::Node> tree);
+		
+		Prototype(std::shared_ptr<const Prototype> root, const stob::Node* chain);
+	public:
+		Prototype(const Prototype&) = delete;
+		Prototype& operator=(const Prototype&) = delete;
+		
+		~Prototype()noexcept;
+		
+		/**
+		 * @brief Get compiled GUI script.
+		 * The returned chain can be passed to inflate() or to Container::add().
+		 * @return Chain of expanded widget descriptions.
+		 */
+		const stob::Node* chain()const noexcept{
+			return this->chain_v;
+		}
+	};
+	
+	/**
+	 * @brief Compile GUI script.
+	 * Definition blocks preceding the first widget are applied to all subsequently compiled and inflated GUI scripts.
+	 * Compiling a chain which is a part of another prototype is cheap, the returned prototype
+	 * refers to the already compiled GUI script.
+	 * @param chain - GUI script to compile.
+	 * @return Compiled GUI script.
+	 */
+	std::shared_ptr<const Prototype> compile(const stob::Node& chain);
+	
+	/**
+	 * @brief Compile GUI script.
+	 * Compiled prototypes of recently used GUI scripts are cached, so compiling same GUI script again returns the cached prototype.
+	 * GUI scripts starting with definition blocks are not cached, since those definitions are applied to all
+	 * subsequently compiled and inflated GUI scripts, see compile(const stob::Node&).
+	 * @param str - string containing GUI script.
+	 * @return Compiled GUI script.
+	 */
+	std::shared_ptr<const Prototype> compile(const char* str);
+	
+	/**
+	 * @brief Drop cached prototypes.
+	 */
+	void clearCache()noexcept{
+		this->prototypesCache.clear();
+		this->prototypesLastUsedOrder.clear();
+	}
+	
 	/**
 	 * @brief Create widgets hierarchy from GUI script.
+	 * If the given chain is a part of compiled prototype, then the widget is created from it
+	 * straight away. Otherwise, the GUI script is compiled first.
+	 * Definition blocks preceding the first widget are applied to all subsequently inflated GUI scripts.
 	 * @param chain - GUI script to use.
 	 * @return reference to the inflated widget.
 	 */
@@ -92,6 +174,8 @@ public:
 	
 	/**
 	 * @brief Create widgets hierarchy from GUI script.
+	 * The GUI script is compiled with compile(const char*), so subsequent calls with same GUI script use cached prototype.
+	 * Definition blocks preceding the first widget are applied to all subsequently inflated GUI scripts.
 	 * @param str - string containing GUI description.
 	 * @return reference to the inflated widget.
 	 */
@@ -114,6 +198,30 @@ public:
 	 */
 	std::shared_ptr<morda::Widget> inflate(papki::File& fi);
 
+	/**
+	 * @brief Inflate GUI script asynchronously.
+	 * Parsing of the GUI script, expanding of templates and substituting of variables is done
+	 * on a separate thread. Then, the widgets are created on UI thread.
+	 * Definitions which are in effect at the moment of calling this function are used.
+	 * Definition blocks preceding the first widget are applied to all GUI scripts inflated after
+	 * this inflation is finished.
+	 * Morda instance must not be destroyed until the inflation is finished.
+	 * @param str - GUI script.
+	 * @param done - callback which is called on UI thread when inflation is finished.
+	 *               It is passed the inflated widget, or nullptr if inflation has failed.
+	 */
+	void inflateAsync(std::string&& str, std::function<void(std::shared_ptr<morda::Widget>)>&& done);
+	
+	/**
+	 * @brief Inflate GUI script asynchronously.
+	 * Same as inflateAsync(std::string&&, std::function<void(std::shared_ptr<morda::Widget>)>&&), but
+	 * the GUI script is also loaded on a separate thread.
+	 * @param fi - file interface to get the GUI script.
+	 * @param done - callback which is called on UI thread when inflation is finished.
+	 *               It is passed the inflated widget, or nullptr if inflation has failed.
+	 */
+	void inflateAsync(std::unique_ptr<papki::File> fi, std::function<void(std::shared_ptr<morda::Widget>)>&& done);
+	
 	//TODO: remove includes resolution and this load() method
 	/**
 	 * @brief Load GUI script.
@@ -124,35 +232,95 @@ public:
 	static std::unique_ptr<stob::Node> load(papki::File& fi);
 	
 private:
-	struct Template{
-		std::unique_ptr<stob::Node> t;
-		std::set<std::string> vars;
+	//Stack of definition blocks. Definition blocks are never changed after being pushed,
+	//so copying the stack is cheap and the copy can be used from another thread.
+	class Definitions{
+		struct Template{
+			std::unique_ptr<stob::Node> t;
+			std::set<std::string> vars;
+		};
+		
+		Template parseTemplate(const stob::Node& chain);
+		
+		std::list<std::shared_ptr<const std::map<std::string, Template>>> templates;
+		
+		//template name - stack of templates with that name, innermost template is the last
+		std::unordered_map<std::string, std::vector<const Template*>> templatesIndex;
+		
+		const Template* findTemplate(const std::string& name)const;
+		
+		void pushTemplates(const stob::Node& chain);
+		
+		void popTemplates();
+		
+		
+		//variable name - value mapping
+		std::list<std::shared_ptr<const std::map<std::string, std::unique_ptr<stob::Node>>>> variables;
+		
+		//variable name - stack of variable values, innermost value is the last
+		std::unordered_map<std::string, std::vector<const stob::Node*>> variablesIndex;
+		
+		const stob::Node* findVariable(const std::string& name)const;
+		
+		void pushVariables(const stob::Node& chain);
+		
+		void popVariables();
+		
+		void substituteVariables(stob::Node* to, bool intoWidgets = true)const;
+	public:
+		void pushDefs(const stob::Node& chain);
+		void popDefs();
+		
+		std::unique_ptr<stob::Node> expand(std::unique_ptr<stob::Node> widget);
+		
+		//Expands widgets of the chain. Definitions preceding the first widget are only applied to this chain.
+		std::unique_ptr<stob::Node> expandChain(const stob::Node& chain);
+	};
+	
+	Definitions defs;
+	
+	
+	struct CompiledWidget{
+		const Prototype* prototype;
+		Factory factory;
+		PropertyTable properties;
 	};
 	
-	Inflater::Template parseTemplate(const stob::Node& chain);
+	std::unordered_map<const stob::Node*, CompiledWidget> compiledNodes;
 	
-	std::list<std::map<std::string, Template>> templates;
+	std::list<const std::string*> prototypesLastUsedOrder;
 	
-	const Template* findTemplate(const std::string& name)const;
+	struct CachedPrototype{
+		std::shared_ptr<const Prototype> prototype;
+		
+		decltype(prototypesLastUsedOrder)::iterator lastUsedIter;
+	};
 	
-	void pushTemplates(const stob::Node& chain);
+	//prototypes compiled from strings
+	std::unordered_map<std::string, CachedPrototype> prototypesCache;
 	
-	void popTemplates();
+	//applies definition blocks preceding the first widget, returns the first widget
+	const stob::Node* applyDefs(const stob::Node& chain);
 	
+	std::shared_ptr<const Prototype> makePrototype(std::unique_ptr<stob::Node> tree);
 	
-	//variable name - value mapping
-	std::list<std::map<std::string, std::unique_ptr<stob::Node>>> variables;
+	std::shared_ptr<morda::Widget> instantiate(const stob::Node& widget, const CompiledWidget& compiled);
 	
-	const stob::Node* findVariable(const std::string& name)const;
+	std::shared_ptr<morda::Widget> instantiate(const Prototype& prototype);
 	
-	void pushVariables(const stob::Node& chain);
+	void inflateAsync(std::function<std::unique_ptr<stob::Node>()>&& load, std::function<void(std::shared_ptr<morda::Widget>)>&& done);
 	
-	void popVariables();
+	//worker thread which loads and expands GUI scripts for asynchronous inflation, started on first use and joined by destructor
+	std::thread asyncThread;
+	std::mutex asyncMutex;
+	std::condition_variable asyncCondVar;
+	std::deque<std::function<void()>> asyncQueue;
+	bool asyncQuit = false;
 	
-	void substituteVariables(stob::Node* to)const;
+	//results posted to UI thread are dropped if this token has expired, i.e. the inflater was destroyed
+	std::shared_ptr<bool> asyncAliveToken = std::make_shared<bool>(true);
 	
-	void pushDefs(const stob::Node& chain);
-	void popDefs();
+	void asyncThreadMain();
 };
 
 
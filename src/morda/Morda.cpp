@@ -1,5 +1,8 @@
 #include "Morda.hpp"
 
+#include <cmath>
+#include <algorithm>
+
 #include <utki/config.hpp>
 
 #include "res/ResSTOB.hpp"
@@ -18,10 +21,12 @@
 
 #include "widgets/label/Color.hpp"
 #include "widgets/label/Text.hpp"
+#include "widgets/label/WrappedText.hpp"
 #include "widgets/label/Gradient.hpp"
 #include "widgets/label/MouseCursor.hpp"
 
 #include "widgets/input/TextInputLine.hpp"
+#include "widgets/input/TextInputWrap.hpp"
 
 #include "widgets/group/TreeView.hpp"
 #include "widgets/group/Window.hpp"
@@ -108,6 +113,7 @@ void Morda::initStandardWidgets(papki::File& fi) {
 	//add standard widgets to inflater
 	
 	this->inflater.registerType<Text>("Text");
+	this->inflater.registerType<WrappedText>("WrappedText");
 	this->inflater.registerType<Color>("Color");
 	this->inflater.registerType<Gradient>("Gradient");
 	this->inflater.registerType<Image>("Image");
@@ -128,6 +134,7 @@ void Morda::initStandardWidgets(papki::File& fi) {
 	this->inflater.registerType<Tabs>("Tabs");
 	this->inflater.registerType<Tab>("Tab");
 	this->inflater.registerType<TextInputLine>("TextInputLine");
+	this->inflater.registerType<TextInputWrap>("TextInputWrap");
 	
 	try{
 		auto t = morda::Morda::inst().resMan.load<ResSTOB>("morda_gui_defs");
@@ -144,6 +151,7 @@ void Morda::initStandardWidgets(papki::File& fi) {
 
 void Morda::setViewportSize(const morda::Vec2r& size){
 	this->viewportSize = size;
+	this->setFullDamage();
 	
 	if(!this->rootWidget){
 		return;
@@ -156,6 +164,7 @@ void Morda::setViewportSize(const morda::Vec2r& size){
 
 void Morda::setRootWidget(const std::shared_ptr<morda::Widget> w){
 	this->rootWidget = std::move(w);
+	this->setFullDamage();
 
 	this->rootWidget->moveTo(morda::Vec2r(0));
 	this->rootWidget->resize(this->viewportSize);
@@ -180,6 +189,7 @@ void Morda::render(const Matr4r& matrix)const{
 	if(this->rootWidget->needsRelayout()){
 		TRACE(<< "root widget re-layout needed!" << std::endl)
 		this->rootWidget->relayoutNeeded = false;
+		M_MORDA_PROFILE_SCOPE("layout", typeid(*this->rootWidget), this->rootWidget->id)
 		this->rootWidget->layOut();
 	}
 	
@@ -188,6 +198,123 @@ void Morda::render(const Matr4r& matrix)const{
 
 
 
+namespace{
+//if number of damaged regions exceeds this value, they are merged into one bounding rectangle
+const size_t maxDamageRects_c = 8;
+
+Rectr unite(const Rectr& a, const Rectr& b){
+	Rectr ret;
+	for(unsigned i = 0; i != 2; ++i){
+		ret.p[i] = std::min(a.p[i], b.p[i]);
+		ret.d[i] = std::max(a.p[i] + a.d[i], b.p[i] + b.d[i]) - ret.p[i];
+	}
+	return ret;
+}
+
+bool touches(const Rectr& a, const Rectr& b){
+	for(unsigned i = 0; i != 2; ++i){
+		if(a.p[i] > b.p[i] + b.d[i] || b.p[i] > a.p[i] + a.d[i]){
+			return false;
+		}
+	}
+	return true;
+}
+}
+
+
+
+void Morda::addDamage(const Rectr& rect)noexcept{
+	if(this->fullDamage){
+		return;
+	}
+	
+	Rectr r(rect);
+	r.intersect(Rectr(Vec2r(0), this->viewportSize));
+	if(r.d.x <= 0 || r.d.y <= 0){
+		return;
+	}
+	
+	//merge with touching regions, merged region can then touch the regions which were already checked, so start over
+	for(auto i = this->damage.begin(); i != this->damage.end();){
+		if(touches(*i, r)){
+			r = unite(*i, r);
+			this->damage.erase(i);
+			i = this->damage.begin();
+		}else{
+			++i;
+		}
+	}
+	
+	if(this->damage.size() == maxDamageRects_c){
+		for(auto& d : this->damage){
+			r = unite(r, d);
+		}
+		this->damage.clear();
+	}
+	
+	try{
+		this->damage.push_back(r);
+	}catch(...){
+		this->setFullDamage();
+	}
+}
+
+
+
+std::vector<Rectr> Morda::renderDamaged(const Matr4r& matrix){
+	std::vector<Rectr> ret;
+	
+	if(!this->rootWidget || !this->viewportSize.isPositive()){
+		return ret;
+	}
+	
+	if(this->fullDamage){
+		ret.push_back(Rectr(Vec2r(0), this->viewportSize));
+	}else{
+		ret = std::move(this->damage);
+	}
+	this->fullDamage = false;
+	this->damage.clear();
+	
+	auto& r = this->renderer();
+	
+	bool scissorTestWasEnabled = r.isScissorEnabled();
+	kolme::Recti oldScissor;
+	if(scissorTestWasEnabled){
+		oldScissor = r.getScissorRect();
+	}else{
+		r.setScissorEnabled(true);
+	}
+	
+	auto vp = r.getViewport();
+	Vec2r scale = vp.d.to<real>().compDivBy(this->viewportSize);
+	
+	for(auto& d : ret){
+		Vec2r p = d.p.compMul(scale);
+		Vec2r e = (d.p + d.d).compMul(scale);
+	
+		//viewport coordinates have Y axis directed downwards, while in framebuffer it is directed upwards
+		int x0 = int(std::floor(p.x));
+		int x1 = int(std::ceil(e.x));
+		int y0 = int(std::floor(real(vp.d.y) - e.y));
+		int y1 = int(std::ceil(real(vp.d.y) - p.y));
+	
+		r.setScissorRect(kolme::Recti(vp.p.x + x0, vp.p.y + y0, x1 - x0, y1 - y0));
+		r.clearFramebuffer();
+		this->render(matrix);
+	}
+	
+	if(scissorTestWasEnabled){
+		r.setScissorRect(oldScissor);
+	}else{
+		r.setScissorEnabled(false);
+	}
+
+	return ret;
+}
+
+
+
 void Morda::onMouseMove(const Vec2r& pos, unsigned id){
 	if(!this->rootWidget){
 		return;
@@ -7,6 +7,7 @@
 #include "util/MouseButton.hpp"
 
 #include "Updateable.hpp"
+#include "Profiler.hpp"
 
 #include "Inflater.hpp"
 #include "ResourceManager.hpp"
@@ -22,6 +23,9 @@ class Morda : public utki::IntrusiveSingleton<Morda>{
 	
 	std::shared_ptr<Renderer> renderer_v;
 	
+	//NOTE: this should go before inflater, as inflater's worker thread can post to UI thread until the inflater is destroyed
+	std::function<void(std::function<void()>&&)> postToUiThread_v;
+	
 public:
 
 	Renderer& renderer()noexcept{
@@ -47,6 +51,11 @@ public:
 	
 	virtual ~Morda()noexcept{}
 
+	/**
+	 * @brief Instantiation of the profiler.
+	 * Events are only recorded if the library is built with M_MORDA_PROFILE macro defined.
+	 */
+	Profiler profiler;
 
 private:
 	Updateable::Updater updater;
@@ -95,6 +104,50 @@ public:
 	 */
 	void render(const Matr4r& matrix = Matr4r().identity())const;
 	
+private:
+	//damaged regions of the viewport, in viewport coordinates
+	std::vector<Rectr> damage;
+	
+	//whole viewport is damaged
+	bool fullDamage = true;
+public:
+	/**
+	 * @brief Mark region of the viewport as damaged.
+	 * Damaged regions are redrawn on next call to renderDamaged().
+	 * Normally, widgets do not call this method directly, but call Widget::setRedrawNeeded().
+	 * @param r - damaged rectangle, in viewport coordinates.
+	 */
+	void addDamage(const Rectr& r)noexcept;
+	
+	/**
+	 * @brief Mark the whole viewport as damaged.
+	 */
+	void setFullDamage()noexcept{
+		this->fullDamage = true;
+		this->damage.clear();
+	}
+	
+	/**
+	 * @brief Check if the whole viewport is damaged.
+	 * @return true if the whole viewport is to be redrawn on next call to renderDamaged().
+	 * @return false otherwise.
+	 */
+	bool isFullyDamaged()const noexcept{
+		return this->fullDamage;
+	}
+	
+	/**
+	 * @brief Render damaged regions of GUI.
+	 * This is an alternative to render() for the cases when redrawing the whole GUI on every frame is too expensive.
+	 * Only the regions of the viewport which were damaged since last call to this method are redrawn,
+	 * using scissor test. Each damaged region is cleared using Renderer::clearFramebuffer() before redrawing,
+	 * so the caller should not clear the framebuffer. The rest of the framebuffer is expected to keep the previous frame.
+	 * @param matrix - use this transformation matrix.
+	 * @return List of redrawn rectangles, in viewport coordinates, with Y axis directed downwards.
+	 *         Can be used for partial presentation of the frame. Empty list means that nothing was redrawn.
+	 */
+	std::vector<Rectr> renderDamaged(const Matr4r& matrix = Matr4r().identity());
+	
 	/**
 	 * @brief Initialize standard widgets library.
 	 * In addition to core widgets it is possible to use standard widgets.
@@ -114,8 +167,21 @@ public:
 		return this->updater.update();
 	}
 	
-private:
-	std::function<void(std::function<void()>&&)> postToUiThread_v;
+	/**
+	 * @brief Update GUI in frame clock mode.
+	 * This is an alternative to update(), the program should use either one or the other.
+	 * Call this function once per presented frame, right before rendering the frame.
+	 * All updateables which are due by the time the frame is presented are updated in one batch
+	 * and all of them get the same frame timestamp as the current time.
+	 * @param framePeriodMs - period of frames presentation, in milliseconds. For example, 16 for 60 frames per second.
+	 * @return number of milliseconds to wait after next frame before rendering another one.
+	 *         Zero means that next frame is needed.
+	 *         0xffffffff means that there is nothing to animate, so no more frames are needed until some event occurs.
+	 */
+	std::uint32_t updateFrame(std::uint16_t framePeriodMs){
+		return this->updater.updateFrame(framePeriodMs);
+	}
+	
 public:
 	/**
 	 * @brief Execute code on UI thread.
@@ -0,0 +1,173 @@
+#include "Profiler.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+#include <utki/config.hpp>
+
+#if M_COMPILER == M_COMPILER_GCC || M_COMPILER == M_COMPILER_CLANG
+#	include <cxxabi.h>
+#	include <cstdlib>
+#endif
+
+#include "Morda.hpp"
+
+
+using namespace morda;
+
+
+
+namespace{
+
+void copyId(char* dst, const char* src)noexcept{
+	std::strncpy(dst, src, sizeof(Profiler::Event::id) - 1);
+	dst[sizeof(Profiler::Event::id) - 1] = 0;
+}
+
+std::string demangle(const char* name){
+#if M_COMPILER == M_COMPILER_GCC || M_COMPILER == M_COMPILER_CLANG
+	int status;
+	char* d = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+	if(d){
+		std::string ret(d);
+		std::free(d);
+		return ret;
+	}
+#endif
+	return std::string(name);
+}
+
+void writeJsonString(std::ostream& s, const std::string& str){
+	s << '"';
+	for(auto c : str){
+		switch(c){
+			case '"':
+				s << "\\\"";
+				break;
+			case '\\':
+				s << "\\\\";
+				break;
+			default:
+				if(std::uint8_t(c) < 0x20){
+					//control characters are not expected in names and IDs
+					s << ' ';
+				}else{
+					s << c;
+				}
+				break;
+		}
+	}
+	s << '"';
+}
+
+}
+
+
+
+void Profiler::start(size_t capacity){
+	this->events.resize(capacity == 0 ? 1 : capacity);
+	this->next = 0;
+	this->numEvents_v = 0;
+	this->isRecording_v = true;
+}
+
+
+
+const Profiler::Event& Profiler::event(size_t i)const noexcept{
+	ASSERT(i < this->numEvents_v)
+	size_t oldest = this->numEvents_v < this->events.size() ? 0 : this->next;
+	return this->events[(oldest + i) % this->events.size()];
+}
+
+
+
+void Profiler::record(const char* category, const char* name, const char* id, std::uint64_t start, std::uint32_t duration)noexcept{
+	if(!this->isRecording_v){
+		return;
+	}
+	
+	auto& e = this->events[this->next];
+	e.category = category;
+	e.name = name;
+	copyId(e.id, id);
+	e.start = start;
+	e.duration = duration;
+	
+	this->next = (this->next + 1) % this->events.size();
+	if(this->numEvents_v < this->events.size()){
+		++this->numEvents_v;
+	}
+}
+
+
+
+std::string Profiler::chromeTrace()const{
+	std::stringstream ss;
+	
+	ss << "{\"traceEvents\":[";
+	
+	for(size_t i = 0; i != this->numEvents_v; ++i){
+		auto& e = this->event(i);
+		
+		if(i != 0){
+			ss << ',';
+		}
+		
+		ss << "\n{\"name\":";
+		writeJsonString(ss, demangle(e.name));
+		ss << ",\"cat\":";
+		writeJsonString(ss, e.category);
+		ss << ",\"ph\":\"X\",\"ts\":" << e.start << ",\"dur\":" << e.duration << ",\"pid\":1,\"tid\":1";
+		if(e.id[0] != 0){
+			ss << ",\"args\":{\"id\":";
+			writeJsonString(ss, e.id);
+			ss << '}';
+		}
+		ss << '}';
+	}
+	
+	ss << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	
+	return ss.str();
+}
+
+
+
+void Profiler::saveChromeTrace(papki::File& fi)const{
+	auto trace = this->chromeTrace();
+	
+	papki::File::Guard fileGuard(fi, papki::File::E_Mode::CREATE);
+	
+	fi.write(utki::Buf<std::uint8_t>(reinterpret_cast<std::uint8_t*>(&trace[0]), trace.size()));
+}
+
+
+
+std::uint64_t Profiler::now()noexcept{
+	return std::uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+
+
+Profiler::Scope::Scope(const char* category, const char* name, const char* id)noexcept{
+	if(!Morda::inst().profiler.isRecording()){
+		this->category = nullptr;
+		return;
+	}
+	
+	this->category = category;
+	this->name = name;
+	copyId(this->id, id);
+	this->start = now();
+}
+
+
+
+Profiler::Scope::~Scope()noexcept{
+	if(!this->category){
+		return;
+	}
+	
+	Morda::inst().profiler.record(this->category, this->name, this->id, this->start, std::uint32_t(now() - this->start));
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <typeinfo>
+
+#include <papki/File.hpp>
+
+
+namespace morda{
+
+/**
+ * @brief Lightweight profiler.
+ * Profiler records time spent on rendering, laying out and measuring of widgets, as well as on
+ * GUI inflation, resource loading and updating of updateables.
+ * Events are recorded to a ring buffer, so only the most recent events are kept.
+ * Recorded events can be exported in Chrome trace event format, to be viewed in chrome://tracing.
+ * The instrumentation is only compiled in when M_MORDA_PROFILE macro is defined, otherwise
+ * it has no run-time cost. Recording is only done from UI thread.
+ */
+class Profiler{
+public:
+	/**
+	 * @brief Recorded event.
+	 */
+	struct Event{
+		/**
+		 * @brief Category of the event, e.g. "render", "layout", "measure".
+		 */
+		const char* category;
+		
+		/**
+		 * @brief Name of the event.
+		 * For widgets and updateables it is the type name as returned by std::type_info::name().
+		 */
+		const char* name;
+		
+		/**
+		 * @brief ID of the widget or name of the resource.
+		 * Truncated to fit the array.
+		 */
+		char id[24];
+		
+		/**
+		 * @brief Event start time, in microseconds.
+		 */
+		std::uint64_t start;
+		
+		/**
+		 * @brief Event duration, in microseconds.
+		 */
+		std::uint32_t duration;
+	};
+
+private:
+	std::vector<Event> events;
+	
+	//index of the next event to write to the ring buffer
+	size_t next = 0;
+	
+	size_t numEvents_v = 0;
+	
+	bool isRecording_v = false;
+
+public:
+	Profiler() = default;
+	
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+	
+	/**
+	 * @brief Start recording.
+	 * Clears previously recorded events.
+	 * @param capacity - size of the ring buffer, in events.
+	 */
+	void start(size_t capacity = 0x10000);
+	
+	/**
+	 * @brief Stop recording.
+	 * Recorded events are kept.
+	 */
+	void stop()noexcept{
+		this->isRecording_v = false;
+	}
+	
+	/**
+	 * @brief Check if profiler is recording.
+	 * @return true if recording.
+	 * @return false otherwise.
+	 */
+	bool isRecording()const noexcept{
+		return this->isRecording_v;
+	}
+	
+	/**
+	 * @brief Get number of recorded events.
+	 * @return Number of events in the ring buffer.
+	 */
+	size_t numEvents()const noexcept{
+		return this->numEvents_v;
+	}
+	
+	/**
+	 * @brief Get recorded event.
+	 * @param i - index of the event, 0 is the oldest one.
+	 * @return Recorded event.
+	 */
+	const Event& event(size_t i)const noexcept;
+	
+	/**
+	 * @brief Record event.
+	 * Does nothing if profiler is not recording.
+	 * @param category - category of the event. Must be a string with static storage duration.
+	 * @param name - name of the event. Must be a string with static storage duration.
+	 * @param id - ID of the event, it is copied.
+	 * @param start - start time of the event, in microseconds.
+	 * @param duration - duration of the event, in microseconds.
+	 */
+	void record(const char* category, const char* name, const char* id, std::uint64_t start, std::uint32_t duration)noexcept;
+	
+	/**
+	 * @brief Export recorded events.
+	 * @return Recorded events in Chrome trace event JSON format.
+	 */
+	std::string chromeTrace()const;
+	
+	/**
+	 * @brief Export recorded events to file.
+	 * @param fi - file to write the events to in Chrome trace event JSON format.
+	 */
+	void saveChromeTrace(papki::File& fi)const;
+	
+	/**
+	 * @brief Get current time.
+	 * @return Current time in microseconds.
+	 */
+	static std::uint64_t now()noexcept;
+	
+	/**
+	 * @brief Scope of profiled event.
+	 * Records an event to the profiler of the Morda singleton, the event lasts as long as the Scope object lives.
+	 * Normally, one does not use this class directly, but uses M_MORDA_PROFILE_SCOPE macro instead.
+	 */
+	class Scope{
+		const char* category;
+		const char* name;
+		char id[sizeof(Event::id)];
+		std::uint64_t start;
+	public:
+		/**
+		 * @brief Constructor.
+		 * @param category - category of the event. Must be a string with static storage duration.
+		 * @param type - type of the object which the event is about, type name is used as event name.
+		 * @param id - ID of the event.
+		 */
+		Scope(const char* category, const std::type_info& type, const char* id = "")noexcept :
+				Scope(category, type.name(), id)
+		{}
+		
+		/**
+		 * @brief Constructor.
+		 * @param category - category of the event. Must be a string with static storage duration.
+		 * @param type - type of the object which the event is about, type name is used as event name.
+		 * @param id - ID of the event.
+		 */
+		Scope(const char* category, const std::type_info& type, const std::string& id)noexcept :
+				Scope(category, type.name(), id.c_str())
+		{}
+		
+		/**
+		 * @brief Constructor.
+		 * @param category - category of the event. Must be a string with static storage duration.
+		 * @param name - name of the event. Must be a string with static storage duration.
+		 * @param id - ID of the event.
+		 */
+		Scope(const char* category, const char* name, const char* id = "")noexcept;
+		
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+		
+		~Scope()noexcept;
+	};
+};
+	
+}
+
+
+#ifdef M_MORDA_PROFILE
+#	define M_MORDA_PROFILE_SCOPE(...) morda::Profiler::Scope morda_profiler_scope(__VA_ARGS__);
+#else
+#	define M_MORDA_PROFILE_SCOPE(...)
+#endif
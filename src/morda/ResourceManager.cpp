@@ -1,4 +1,5 @@
 #include <papki/RootDirFile.hpp>
+#include <papki/FSFile.hpp>
 
 #include "ResourceManager.hpp"
 
@@ -60,6 +61,9 @@ void ResourceManager::mountResPack(const papki::File& fi){
 	
 	ResPackEntry rpe;
 	rpe.fi = papki::RootDirFile::makeUniqueConst(fi.spawn(), dir);
+	if(dynamic_cast<const papki::FSFile*>(&fi)){
+		rpe.nativeDir = dir;
+	}
 	rpe.resScript = resScript->chopNext();
 
 	this->resPacks.push_back(std::move(rpe));
@@ -88,6 +92,34 @@ ResourceManager::FindInScriptRet ResourceManager::findResourceInScript(const std
 
 
 
+std::string ResourceManager::nativePath(const papki::File& fi)const{
+	for(auto& rp : this->resPacks){
+		if(rp.fi.get() == &fi){
+			if(rp.nativeDir.size() == 0){
+				break;
+			}
+			return rp.nativeDir + fi.path();
+		}
+	}
+	return std::string();
+}
+
+
+
+std::string ResourceManager::resourcePath(const papki::File& fi)const{
+	//resource packs are never unmounted, so pack index identifies the pack
+	for(size_t i = 0; i != this->resPacks.size(); ++i){
+		if(this->resPacks[i].fi.get() == &fi){
+			std::stringstream ss;
+			ss << i << ":" << fi.path();
+			return ss.str();
+		}
+	}
+	return std::string();
+}
+
+
+
 void ResourceManager::addResource(const std::shared_ptr<Resource>& res, const stob::Node& node){
 	ASSERT(res)
 
@@ -7,6 +7,7 @@
 #include <stob/dom.hpp>
 
 #include "Exc.hpp"
+#include "Profiler.hpp"
 
 
 namespace morda{
@@ -57,10 +58,14 @@ class ResourceManager{
 		ResPackEntry(ResPackEntry&& r){
 			this->fi = std::move(r.fi);
 			this->resScript = std::move(r.resScript);
+			this->nativeDir = std::move(r.nativeDir);
 		}
 
 		std::unique_ptr<const papki::File> fi;
 		std::unique_ptr<const stob::Node> resScript;
+		
+		//directory of the resource pack in native file system, empty if resource pack is not in native file system
+		std::string nativeDir;
 	};
 
 	typedef std::vector<ResPackEntry> T_ResPackList;
@@ -128,6 +133,25 @@ public:
 	 */
 	template <class T> std::shared_ptr<T> load(const char* resName);
 	
+	/**
+	 * @brief Get path of the resource file in native file system.
+	 * Resource loaders can use it to access the file directly, e.g. to memory-map it.
+	 * @param fi - file interface passed to the resource loading function, pointing to the resource file.
+	 * @return Path to the file in native file system.
+	 * @return Empty string if the file does not belong to a resource pack mounted from native file system.
+	 */
+	std::string nativePath(const papki::File& fi)const;
+	
+	/**
+	 * @brief Get path of the resource file which identifies it among files of all mounted resource packs.
+	 * Resource loaders can use it as a key for sharing contents of the same file among resources,
+	 * including files from resource packs which are not in native file system, e.g. zip archives.
+	 * @param fi - file interface passed to the resource loading function, pointing to the resource file.
+	 * @return Path to the file prefixed with the index of the resource pack.
+	 * @return Empty string if the file does not belong to a mounted resource pack.
+	 */
+	std::string resourcePath(const papki::File& fi)const;
+	
 private:
 };
 
@@ -167,6 +191,8 @@ template <class T> std::shared_ptr<T> ResourceManager::load(const char* resName)
 		return r;
 	}
 
+	M_MORDA_PROFILE_SCOPE("load", typeid(T), resName)
+	
 //	TRACE(<< "ResMan::Load(): searching for resource in script..." << std::endl)
 	FindInScriptRet ret = this->findResourceInScript(resName);
 	ASSERT(ret.rp.fi)
@@ -10,126 +10,189 @@ using namespace morda;
 
 
 namespace{
-std::uint32_t getTicks(){
-	return std::uint32_t(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+//Compares timestamps taking into account that ticks counter can warp around.
+//Since update period is 16 bit, the timestamps being compared are never further than 2^31 apart.
+bool isEarlier(std::uint32_t a, std::uint32_t b){
+	return std::int32_t(a - b) < 0;
+}
 }
+
+
+
+std::uint32_t Updateable::getTicks()noexcept{
+	return std::uint32_t(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
 }
 
 
-Updateable::Updater::UpdateQueue::iterator Updateable::Updater::UpdateQueue::insertPair(const T_Pair& p){
-	if(this->size() == 0 || this->back().first <= p.first){
-		this->push_back(p);
-		return --(this->end());
+
+Updateable::Updater::~Updater()noexcept{
+	for(auto u : this->heap){
+		u->heapIndex = invalidIndex_c;
+	}
+	for(auto u : this->toAdd){
+		u->toAddIndex = invalidIndex_c;
 	}
+}
+
+
+
+void Updateable::Updater::siftUp(size_t index){
+	auto u = this->heap[index];
 	
-	//otherwise, go from the beginning
-	for(auto i = this->begin(); i != this->end(); ++i){
-		if(i->first >= p.first){
-			return this->insert(i, p); //inserts before iterator
+	while(index != 0){
+		size_t parent = (index - 1) / 2;
+		if(!isEarlier(u->endAt(), this->heap[parent]->endAt())){
+			break;
 		}
+		this->heapSet(index, this->heap[parent]);
+		index = parent;
 	}
 	
-	ASSERT(false)
-	return this->end();
+	this->heapSet(index, u);
 }
 
 
 
-void Updateable::Updater::addPending(){
-	while(this->toAdd.size() != 0){
-		T_Pair p;
-		
-		p.first = this->toAdd.front()->endAt();
-		p.second = this->toAdd.front();
-		
-		if(p.first < this->lastUpdatedTimestamp){
-//			TRACE(<< "Updateable::Updater::AddPending(): inserted to inactive queue" << std::endl)
-			this->toAdd.front()->queue = this->inactiveQueue;
-			this->toAdd.front()->iter = this->inactiveQueue->insertPair(p);
-		}else{
-//			TRACE(<< "Updateable::Updater::AddPending(): inserted to active queue" << std::endl)
-			this->toAdd.front()->queue = this->activeQueue;
-			this->toAdd.front()->iter = this->activeQueue->insertPair(p);
+void Updateable::Updater::siftDown(size_t index){
+	auto u = this->heap[index];
+	
+	for(;;){
+		size_t child = 2 * index + 1;
+		if(child >= this->heap.size()){
+			break;
 		}
-		
-		this->toAdd.front()->pendingAddition = false;
-		
-		this->toAdd.pop_front();
+		if(child + 1 < this->heap.size() && isEarlier(this->heap[child + 1]->endAt(), this->heap[child]->endAt())){
+			++child;
+		}
+		if(!isEarlier(this->heap[child]->endAt(), u->endAt())){
+			break;
+		}
+		this->heapSet(index, this->heap[child]);
+		index = child;
 	}
+	
+	this->heapSet(index, u);
 }
 
 
 
-void Updateable::Updater::updateUpdateable(const std::shared_ptr<morda::Updateable>& u){
-	//if weak ref gave invalid strong ref
-	if(!u){
+void Updateable::Updater::heapPush(Updateable* u){
+	ASSERT(u->heapIndex == invalidIndex_c)
+	this->heap.push_back(u);
+	this->siftUp(this->heap.size() - 1);
+}
+
+
+
+void Updateable::Updater::heapRemove(size_t index){
+	ASSERT(index < this->heap.size())
+	
+	this->heap[index]->heapIndex = invalidIndex_c;
+	
+	auto last = this->heap.back();
+	this->heap.pop_back();
+	
+	if(index == this->heap.size()){
 		return;
 	}
 	
-	//at this point updateable is removed from update queue, so set it to 0
-	u->queue = 0;
+	this->heapSet(index, last);
 	
-	u->update(this->lastUpdatedTimestamp - u->startedAt);
+	if(index != 0 && isEarlier(last->endAt(), this->heap[(index - 1) / 2]->endAt())){
+		this->siftUp(index);
+	}else{
+		this->siftDown(index);
+	}
+}
+
+
+
+void Updateable::Updater::pushToAdd(Updateable* u){
+	ASSERT(u->toAddIndex == invalidIndex_c)
+	u->toAddIndex = this->toAdd.size();
+	this->toAdd.push_back(u);
+}
+
+
+
+void Updateable::Updater::removeFromToAdd(Updateable* u){
+	ASSERT(u->toAddIndex < this->toAdd.size())
+	ASSERT(this->toAdd[u->toAddIndex] == u)
 	
-	//if not stopped during update, add it back
-	if(u->isUpdating()){
-		u->startedAt = this->lastUpdatedTimestamp;
-		u->pendingAddition = true;
-		this->toAdd.push_back(u);
+	auto last = this->toAdd.back();
+	this->toAdd[u->toAddIndex] = last;
+	last->toAddIndex = u->toAddIndex;
+	this->toAdd.pop_back();
+	
+	u->toAddIndex = invalidIndex_c;
+}
+
+
+
+void Updateable::Updater::addPending(){
+	for(auto u : this->toAdd){
+		u->toAddIndex = invalidIndex_c;
+		this->heapPush(u);
 	}
+	this->toAdd.clear();
 }
 
 
 
-std::uint32_t Updateable::Updater::update(){
-	std::uint32_t curTime = getTicks();
+void Updateable::Updater::updateUpdateable(Updateable* u){
+	//hold the updateable from being destroyed during update
+	auto guard = u->sharedFromThis(u);
 	
-//	TRACE(<< "Updateable::Updater::Update(): invoked" << std::endl)
+	M_MORDA_PROFILE_SCOPE("update", typeid(*u))
 	
-	this->addPending();//add pending before updating this->lastUpdatedTimestamp
+	u->update(this->lastUpdatedTimestamp - u->startedAt);
 	
-	//check if there is a warp around
-	if(curTime < this->lastUpdatedTimestamp){
-		this->lastUpdatedTimestamp = curTime;
-		
-//		TRACE(<< "Updateable::Updater::Update(): time has warped, this->activeQueue->Size() = " << this->activeQueue->size() << std::endl)
-		
-		//if time has warped, then all Updateables from active queue have expired.
-		while(this->activeQueue->size() != 0){
-			this->updateUpdateable(this->activeQueue->popFront());
-		}
-		
-		std::swap(this->activeQueue, this->inactiveQueue);
-	}else{
-		this->lastUpdatedTimestamp = curTime;
+	//if not stopped during update, add it back
+	if(u->isUpdating() && u->toAddIndex == invalidIndex_c){
+		u->startedAt = this->lastUpdatedTimestamp;
+		this->pushToAdd(u);
 	}
-	ASSERT(this->lastUpdatedTimestamp == curTime)
+}
+
+
+
+void Updateable::Updater::updateDue(std::uint32_t timestamp, std::uint32_t deadline){
+	this->addPending();
 	
-//	TRACE(<< "Updateable::Updater::Update(): this->activeQueue->Size() = " << this->activeQueue->size() << std::endl)
+	this->lastUpdatedTimestamp = timestamp;
 	
-	while(this->activeQueue->size() != 0){
-		if(this->activeQueue->front().first > curTime){
+	while(this->heap.size() != 0){
+		auto u = this->heap.front();
+		if(isEarlier(deadline, u->endAt())){
 			break;
 		}
-		this->updateUpdateable(this->activeQueue->popFront());
+		this->heapRemove(0);
+		this->updateUpdateable(u);
 	}
 	
 	this->addPending();//after updating need to add recurring Updateables if any
+}
+
+
+
+std::uint32_t Updateable::Updater::update(){
+	M_MORDA_PROFILE_SCOPE("update", "Updater::update")
+	
+	std::uint32_t curTime = getTicks();
+	
+//	TRACE(<< "Updateable::Updater::Update(): invoked" << std::endl)
+	
+	this->updateDue(curTime, curTime);
 	
 	//After updating all the stuff some time has passed, so might need to correct the time need to wait
 	
-	std::uint32_t closestTime;
-	if(this->activeQueue->size() != 0){
-		ASSERT(curTime <= this->activeQueue->front().first)
-		closestTime = this->activeQueue->front().first;
-	}else if(this->inactiveQueue->size() != 0){
-		ASSERT(curTime > this->inactiveQueue->front().first)
-		closestTime = this->inactiveQueue->front().first;
-	}else{
+	if(this->heap.size() == 0){
 		return std::uint32_t(-1);
 	}
 	
-	std::uint32_t uncorrectedDt = closestTime - curTime;
+	std::uint32_t closestTime = this->heap.front()->endAt();
+	
+	std::uint32_t uncorrectedDt = isEarlier(curTime, closestTime) ? closestTime - curTime : 0;
 	
 	std::uint32_t correction = getTicks() - curTime;
 	
@@ -148,16 +211,26 @@ std::uint32_t Updateable::Updater::update(){
 
 
 
-void Updateable::Updater::removeFromToAdd(Updateable* u){
-	ASSERT(u->pendingAddition)
-	for(T_ToAddList::iterator i = this->toAdd.begin(); i != this->toAdd.end(); ++i){
-		if((*i).operator->() == u){
-			ASSERT((*i)->pendingAddition)
-			u->pendingAddition = false;
-			this->toAdd.erase(i);
-			return;
-		}
+std::uint32_t Updateable::Updater::updateFrame(std::uint16_t framePeriodMs){
+	M_MORDA_PROFILE_SCOPE("update", "Updater::updateFrame")
+	
+	std::uint32_t frameTime = getTicks();
+	
+	//update everything which is due by the time this frame is closer than the next one
+	this->updateDue(frameTime, frameTime + framePeriodMs / 2);
+	
+	if(this->heap.size() == 0){
+		return std::uint32_t(-1);
+	}
+	
+	std::uint32_t closestTime = this->heap.front()->endAt();
+	
+	//NOTE: no correction for time spent on updating here, since frames are presented at fixed rate anyway
+	if(!isEarlier(frameTime + framePeriodMs + framePeriodMs / 2, closestTime)){
+		return 0;//next frame is needed
 	}
+	
+	return closestTime - frameTime - framePeriodMs;
 }
 
 
@@ -175,9 +248,7 @@ void Updateable::startUpdating(std::uint16_t dtMs){
 	this->startedAt = getTicks();
 	this->isUpdating_v = true;
 	
-	this->pendingAddition = true;
-	
-	Morda::inst().updater.toAdd.push_front(this->sharedFromThis(this));
+	Morda::inst().updater.pushToAdd(this);
 }
 
 
@@ -185,12 +256,18 @@ void Updateable::startUpdating(std::uint16_t dtMs){
 void Updateable::stopUpdating()noexcept{
 //	ASSERT(App::inst().thisIsUIThread())
 	
-	if(this->queue){
-		this->queue->erase(this->iter);
-		this->queue = 0;
-	}else if(this->pendingAddition){
+	if(this->heapIndex != invalidIndex_c){
+		Morda::inst().updater.heapRemove(this->heapIndex);
+	}else if(this->toAddIndex != invalidIndex_c){
 		Morda::inst().updater.removeFromToAdd(this);
 	}
 
 	this->isUpdating_v = false;
 }
+
+
+
+Updateable::~Updateable()noexcept{
+	//Updater holds plain pointers to updateables, so remove this one from there
+	this->stopUpdating();
+}
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <cstdint>
-#include <list>
+#include <vector>
 
 #include <utki/Shared.hpp>
 
@@ -25,41 +25,49 @@ private:
 	class Updater{
 		friend class morda::Updateable;
 		
-		typedef std::pair<std::uint32_t, std::weak_ptr<morda::Updateable>> T_Pair;
+		//binary min-heap of updateables ordered by the time of the next update
+		std::vector<morda::Updateable*> heap;
 		
-		class UpdateQueue : public std::list<T_Pair>{
-		public:
-			UpdateQueue::iterator insertPair(const T_Pair& p);
-
-			std::shared_ptr<morda::Updateable> popFront(){
-				auto ret = this->front().second.lock();
-				this->pop_front();
-				return ret;
-			}
-		};
+		//updateables waiting to be added to the heap
+		std::vector<morda::Updateable*> toAdd;
+		
+		std::uint32_t lastUpdatedTimestamp = 0;
 		
-		UpdateQueue q1, q2;
+		void heapPush(morda::Updateable* u);
 		
-		UpdateQueue *activeQueue, *inactiveQueue;
+		void heapRemove(size_t index);
 		
-		std::uint32_t lastUpdatedTimestamp = 0;
+		void siftUp(size_t index);
 		
-		typedef std::list<std::shared_ptr<morda::Updateable> > T_ToAddList;
-		T_ToAddList toAdd;
+		void siftDown(size_t index);
+		
+		void heapSet(size_t index, morda::Updateable* u){
+			this->heap[index] = u;
+			u->heapIndex = index;
+		}
+		
+		void pushToAdd(morda::Updateable* u);
+		
+		void removeFromToAdd(morda::Updateable* u);
 		
 		void addPending();
 		
-		void updateUpdateable(const std::shared_ptr<morda::Updateable>& u);
+		void updateUpdateable(morda::Updateable* u);
+		
+		void updateDue(std::uint32_t timestamp, std::uint32_t deadline);
 	public:
-		Updater() :
-				activeQueue(&q1),
-				inactiveQueue(&q2)
-		{}
+		Updater(){}
+		
+		Updater(const Updater&) = delete;
+		Updater& operator=(const Updater&) = delete;
 		
-		void removeFromToAdd(Updateable* u);
+		~Updater()noexcept;
 		
 		//returns dt to wait before next update
 		std::uint32_t update();
+		
+		//returns time to wait before next frame is needed
+		std::uint32_t updateFrame(std::uint16_t framePeriodMs);
 	};
 	
 private:
@@ -73,12 +81,13 @@ private:
 	
 	bool isUpdating_v = false;
 	
-	//pointer to the queue the updateable is inserted into
-	Updater::UpdateQueue* queue = nullptr;
+	static const size_t invalidIndex_c = size_t(-1);
 	
-	Updater::UpdateQueue::iterator iter; //iterator into the queue.
+	//index in the updater's heap
+	size_t heapIndex = invalidIndex_c;
 	
-	bool pendingAddition = false;
+	//index in the updater's list of updateables pending addition
+	size_t toAddIndex = invalidIndex_c;
 	
 public:
 	/**
@@ -124,6 +133,15 @@ public:
 	 * @param dtMs - actual time elapsed since the previous update.
 	 */
 	virtual void update(std::uint32_t dtMs) = 0;
+	
+	virtual ~Updateable()noexcept;
+	
+	/**
+	 * @brief Get current time.
+	 * Timestamps are from the same clock which is used for timing the updates.
+	 * @return Current time in milliseconds. The counter wraps around.
+	 */
+	static std::uint32_t getTicks()noexcept;
 };
 
 }
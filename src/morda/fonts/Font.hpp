@@ -1,8 +1,10 @@
 #pragma once
 
 #include <string>
+#include <memory>
 
 #include <utki/Buf.hpp>
+#include <utki/Unique.hpp>
 #include <unikod/utf8.hpp>
 
 #include <kolme/Matrix4.hpp>
@@ -12,6 +14,23 @@
 
 namespace morda{
 
+/**
+ * @brief String of text prepared for rendering.
+ * Holds everything needed to render the string, so that rendering it again and again
+ * does not need to look up the glyphs and position them.
+ */
+class TextMesh : public utki::Unique{
+public:
+	virtual ~TextMesh()noexcept{}
+	
+	/**
+	 * @brief Render the text.
+	 * @param matrix - transformation matrix to use when rendering the text.
+	 * @param color - text color.
+	 */
+	virtual void render(const morda::Matr4r& matrix, kolme::Vec4f color)const = 0;
+};
+
 /**
  * @brief Basic class representing a font.
  */
@@ -145,6 +164,60 @@ public:
 	 */
 	virtual real charAdvance(char32_t c)const = 0;
 	
+	/**
+	 * @brief Get kerning of the pair of characters.
+	 * Kerning is the adjustment of the advance of the left character when it is followed by the right one.
+	 * @param left - left character of the pair.
+	 * @param right - right character of the pair.
+	 * @return Kerning of the pair. Default implementation returns 0.
+	 */
+	virtual real kerning(char32_t left, char32_t right)const{
+		return 0;
+	}
+	
+	/**
+	 * @brief Get bounding box of the character's glyph.
+	 * The bounding box is relative to the pen position the glyph is rendered at.
+	 * Default implementation measures a string of the single character.
+	 * @param c - character to get bounding box for.
+	 * @return Bounding box of the character's glyph.
+	 */
+	virtual morda::Rectr charBoundingBox(char32_t c)const{
+		return this->stringBoundingBoxInternal(std::u32string(1, c));
+	}
+	
+	/**
+	 * @brief Prepare glyphs of the characters in advance.
+	 * Makes sure the glyphs of the given characters are ready to be rendered,
+	 * so that those are not prepared in the middle of rendering.
+	 * @param chars - characters to prepare glyphs for.
+	 */
+	virtual void prewarm(const std::u32string& chars)const{}
+	
+	/**
+	 * @brief Prepare string of text for rendering.
+	 * Default implementation returns a mesh which renders the string with renderString().
+	 * @param str - string of text.
+	 * @return Mesh of the text, rendering it gives the same result as rendering the string with renderString().
+	 */
+	virtual std::unique_ptr<TextMesh> makeMesh(const std::u32string& str)const{
+		class StringMesh : public TextMesh{
+			const Font& font;
+			std::u32string str;
+		public:
+			StringMesh(const Font& font, const std::u32string& str) :
+					font(font),
+					str(str)
+			{}
+			
+			void render(const morda::Matr4r& matrix, kolme::Vec4f color)const override{
+				this->font.renderString(matrix, color, this->str);
+			}
+		};
+		
+		return std::unique_ptr<TextMesh>(new StringMesh(*this, str));
+	}
+	
 	
 	/**
 	 * @brief Get bounding box of the string.
@@ -0,0 +1,160 @@
+#include "FreeType.hxx"
+
+#include <map>
+
+#include <utki/config.hpp>
+#include <utki/Exc.hpp>
+#include <utki/debug.hpp>
+
+#include <papki/FSFile.hpp>
+
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#	define MORDA_FONT_FILE_MMAP
+#endif
+
+#include "../Morda.hpp"
+
+
+using namespace morda;
+
+
+
+namespace{
+std::mutex cacheMutex;
+
+std::weak_ptr<FreeTypeLibWrapper> sharedLib;
+
+//font files, by native path, or by resource path for files which are not in native file system
+std::map<std::pair<std::string, std::string>, std::weak_ptr<const FontFile>> fontFiles;
+}
+
+
+
+FreeTypeLibWrapper::FreeTypeLibWrapper() {
+	if (FT_Init_FreeType(&this->lib)) {
+		throw utki::Exc("FreeTypeLibWrapper::FreeTypeLibWrapper(): unable to init freetype library");
+	}
+}
+
+FreeTypeLibWrapper::~FreeTypeLibWrapper()noexcept{
+	FT_Done_FreeType(this->lib);
+}
+
+std::shared_ptr<FreeTypeLibWrapper> FreeTypeLibWrapper::inst(){
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	
+	if(auto ret = sharedLib.lock()){
+		return ret;
+	}
+	
+	auto ret = std::make_shared<FreeTypeLibWrapper>();
+	sharedLib = ret;
+	return ret;
+}
+
+
+
+FontFile::~FontFile()noexcept{
+#ifdef MORDA_FONT_FILE_MMAP
+	if(this->isMapped){
+		munmap(const_cast<std::uint8_t*>(this->data_v), this->size_v);
+	}
+#endif
+}
+
+std::shared_ptr<const FontFile> FontFile::load(const papki::File& fi){
+	std::string path;
+	std::string resPath;
+	if(dynamic_cast<const papki::FSFile*>(&fi)){
+		path = fi.path();
+	}else{
+		path = morda::inst().resMan.nativePath(fi);
+		if(path.size() == 0){
+			resPath = morda::inst().resMan.resourcePath(fi);
+		}
+	}
+	
+	if(path.size() == 0 && resPath.size() == 0){
+		//file cannot be identified by path, so just read it
+		std::shared_ptr<FontFile> ret(new FontFile());
+		ret->buf = fi.loadWholeFileIntoMemory();
+		ret->data_v = ret->buf.data();
+		ret->size_v = ret->buf.size();
+		return ret;
+	}
+	
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	
+	auto& cached = fontFiles[std::make_pair(path, resPath)];
+	if(auto ret = cached.lock()){
+		return ret;
+	}
+	
+	//drop entries of the font files which are not used anymore
+	for(auto i = fontFiles.begin(); i != fontFiles.end();){
+		if(&i->second != &cached && i->second.expired()){
+			i = fontFiles.erase(i);
+		}else{
+			++i;
+		}
+	}
+	
+	std::shared_ptr<FontFile> ret(new FontFile());
+
+#ifdef MORDA_FONT_FILE_MMAP
+	//only files from native file system can be memory-mapped
+	if(path.size() != 0){
+		int fd = open(path.c_str(), O_RDONLY);
+		if(fd >= 0){
+			struct stat st;
+			if(fstat(fd, &st) == 0 && st.st_size > 0){
+				void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if(p != MAP_FAILED){
+					ret->data_v = reinterpret_cast<const std::uint8_t*>(p);
+					ret->size_v = size_t(st.st_size);
+					ret->isMapped = true;
+				}
+			}
+			//mapping stays valid after closing the file descriptor
+			close(fd);
+		}
+	}
+#endif
+	
+	if(!ret->isMapped){
+		ret->buf = fi.loadWholeFileIntoMemory();
+		ret->data_v = ret->buf.data();
+		ret->size_v = ret->buf.size();
+	}
+	
+	cached = ret;
+	return ret;
+}
+
+
+
+FreeTypeFaceWrapper::FreeTypeFaceWrapper(const papki::File& fi) :
+		FreeTypeFaceWrapper(FontFile::load(fi))
+{}
+
+FreeTypeFaceWrapper::FreeTypeFaceWrapper(std::shared_ptr<const FontFile> fontFile) :
+		freetype(FreeTypeLibWrapper::inst()),
+		fontFile(std::move(fontFile))
+{
+	ASSERT(this->fontFile)
+	
+	std::lock_guard<std::mutex> lock(this->freetype->mutex);
+	
+	if (FT_New_Memory_Face(this->freetype->lib, this->fontFile->data(), FT_Long(this->fontFile->size()), 0/* face_index */, &this->f) != 0) {
+		throw utki::Exc("FreeTypeFaceWrapper::FreeTypeFaceWrapper(): unable to crate font face object");
+	}
+}
+
+FreeTypeFaceWrapper::~FreeTypeFaceWrapper()noexcept{
+	std::lock_guard<std::mutex> lock(this->freetype->mutex);
+	FT_Done_Face(this->f);
+}
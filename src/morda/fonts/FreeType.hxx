@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <papki/File.hpp>
+
+
+namespace morda{
+
+/**
+ * @brief RAII wrapper of FreeType library instance.
+ * One instance is shared by all the font faces.
+ */
+struct FreeTypeLibWrapper{
+	FT_Library lib;
+	
+	//FreeType requires creation and destruction of faces to be serialized when library is used by several threads
+	std::mutex mutex;
+	
+	FreeTypeLibWrapper();
+	
+	FreeTypeLibWrapper(const FreeTypeLibWrapper&) = delete;
+	FreeTypeLibWrapper& operator=(const FreeTypeLibWrapper&) = delete;
+	
+	~FreeTypeLibWrapper()noexcept;
+	
+	/**
+	 * @brief Get shared library instance.
+	 * The instance is created on first use and destroyed when no face uses it anymore.
+	 * @return FreeType library instance.
+	 */
+	static std::shared_ptr<FreeTypeLibWrapper> inst();
+};
+
+/**
+ * @brief Contents of a font file.
+ * Font files are cached by path, so that faces created from the same file, e.g. for different font sizes, share the contents.
+ * Files from native file system are identified by native path and memory-mapped where supported,
+ * files from other resource packs are identified by resource path and read to memory.
+ */
+class FontFile{
+	const std::uint8_t* data_v;
+	size_t size_v;
+	
+	//contents of the file if it is not memory-mapped
+	std::vector<std::uint8_t> buf;
+	
+	bool isMapped = false;
+	
+	FontFile(){}
+
+public:
+	FontFile(const FontFile&) = delete;
+	FontFile& operator=(const FontFile&) = delete;
+	
+	~FontFile()noexcept;
+	
+	/**
+	 * @brief Get contents of the font file.
+	 * Files from resource packs mounted from native file system and papki::FSFile files are memory-mapped and cached.
+	 * Files from other resource packs are read to memory and cached. Other files are read to memory and not cached.
+	 * @param fi - font file.
+	 * @return Contents of the font file.
+	 */
+	static std::shared_ptr<const FontFile> load(const papki::File& fi);
+	
+	const std::uint8_t* data()const noexcept{
+		return this->data_v;
+	}
+	
+	size_t size()const noexcept{
+		return this->size_v;
+	}
+};
+
+/**
+ * @brief RAII wrapper of FreeType face.
+ * Holds the font file contents and the FreeType library instance for the lifetime of the face.
+ * Font file contents are immutable, so several faces, e.g. used by different threads, can share them.
+ */
+struct FreeTypeFaceWrapper{
+	std::shared_ptr<FreeTypeLibWrapper> freetype;
+	std::shared_ptr<const FontFile> fontFile;//the buffer should be alive as long as the Face is alive!!!
+	FT_Face f;
+	
+	FreeTypeFaceWrapper(const papki::File& fi);
+	
+	FreeTypeFaceWrapper(std::shared_ptr<const FontFile> fontFile);
+	
+	FreeTypeFaceWrapper(const FreeTypeFaceWrapper&) = delete;
+	FreeTypeFaceWrapper& operator=(const FreeTypeFaceWrapper&) = delete;
+	
+	~FreeTypeFaceWrapper()noexcept;
+};
+	
+}
@@ -0,0 +1,116 @@
+#include "GlyphAtlas.hxx"
+
+#include <cstring>
+#include <algorithm>
+
+#include <utki/debug.hpp>
+
+#include "../Morda.hpp"
+#include "../Exc.hpp"
+
+
+using namespace morda;
+
+
+
+namespace{
+//gap between images to avoid bleeding when sampling the texture with filtering
+const unsigned padding_c = 1;
+}
+
+
+
+GlyphAtlas::GlyphAtlas(Texture2D::TexType_e type, kolme::Vec2ui pageDim) :
+		type(type),
+		pageDim_v(pageDim)
+{}
+
+
+
+GlyphAtlas::Region GlyphAtlas::add(kolme::Vec2ui dim, const std::uint8_t* data){
+	if(dim.x + padding_c > this->pageDim_v.x || dim.y + padding_c > this->pageDim_v.y){
+		throw morda::Exc("GlyphAtlas::add(): glyph image does not fit into atlas page");
+	}
+	
+	Region ret;
+	ret.dim = dim;
+	
+	//find place in the last page, or start a new page
+	for(;;){
+		if(this->pages.empty()){
+			this->pages.emplace_back(this->pageDim_v.x * this->pageDim_v.y * Texture2D::bytesPerPixel(this->type));
+		}
+		
+		auto& p = this->pages.back();
+		
+		if(p.x + dim.x + padding_c > this->pageDim_v.x){
+			//start new row
+			p.rowY += p.rowHeight;
+			p.rowHeight = 0;
+			p.x = 0;
+		}
+		
+		if(p.rowY + dim.y + padding_c > this->pageDim_v.y){
+			this->pages.emplace_back(this->pageDim_v.x * this->pageDim_v.y * Texture2D::bytesPerPixel(this->type));
+			continue;
+		}
+		
+		ret.page = this->pages.size() - 1;
+		ret.pos.x = p.x;
+		ret.pos.y = p.rowY;
+		
+		p.x += dim.x + padding_c;
+		p.rowHeight = std::max(p.rowHeight, dim.y + padding_c);
+		break;
+	}
+	
+	auto& p = this->pages[ret.page];
+	
+	unsigned bpp = Texture2D::bytesPerPixel(this->type);
+	
+	for(unsigned y = 0; y != dim.y; ++y){
+		std::memcpy(
+				&p.pixels[((ret.pos.y + y) * this->pageDim_v.x + ret.pos.x) * bpp],
+				&data[y * dim.x * bpp],
+				dim.x * bpp
+			);
+	}
+	
+	p.dirty = true;
+	
+	return ret;
+}
+
+
+
+std::shared_ptr<const GlyphAtlas::PageTexture> GlyphAtlas::pageTexture(size_t page){
+	ASSERT(page < this->pages.size())
+	
+	auto& p = this->pages[page];
+	
+	if(p.dirty){
+		//replacing the texture releases the previous copy of the page, unless it is being used by the renderer
+		p.tex->tex = morda::inst().renderer().factory->createTexture2D(
+				this->type,
+				this->pageDim_v,
+				utki::wrapBuf(p.pixels)
+			);
+		p.dirty = false;
+	}
+	
+	return p.tex;
+}
+
+
+
+std::array<kolme::Vec2f, 4> GlyphAtlas::texCoords(const Region& r)const noexcept{
+	kolme::Vec2f p(float(r.pos.x) / float(this->pageDim_v.x), float(r.pos.y) / float(this->pageDim_v.y));
+	kolme::Vec2f d(float(r.dim.x) / float(this->pageDim_v.x), float(r.dim.y) / float(this->pageDim_v.y));
+	
+	return {{
+		p,
+		kolme::Vec2f(p.x, p.y + d.y),
+		p + d,
+		kolme::Vec2f(p.x + d.x, p.y)
+	}};
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <array>
+#include <cstdint>
+
+#include <kolme/Vector2.hpp>
+
+#include <utki/debug.hpp>
+
+#include "../render/Texture2D.hpp"
+
+
+namespace morda{
+
+/**
+ * @brief Texture atlas for glyph images.
+ * Glyph images are packed to pages of fixed size, rows of glyphs are filled from top to bottom.
+ * Page texture is re-created from the page pixels lazily, when the page which
+ * got new glyphs is used for rendering, so that adding a bunch of glyphs costs one texture upload.
+ * Each page has a PageTexture object which always refers to the latest texture of the page.
+ */
+class GlyphAtlas{
+public:
+	/**
+	 * @brief Place of a glyph image in the atlas.
+	 */
+	struct Region{
+		size_t page;
+		kolme::Vec2ui pos;
+		kolme::Vec2ui dim;
+	};
+	
+	/**
+	 * @brief Texture of an atlas page.
+	 * Holds the latest texture of the page, it is replaced when the page is uploaded again.
+	 * Images are only added to a page, so the latest texture has all the images which were
+	 * on the page when it was retrieved, even after the atlas is cleared.
+	 */
+	class PageTexture{
+		friend class GlyphAtlas;
+		
+		std::shared_ptr<Texture2D> tex;
+	public:
+		const Texture2D& texture()const noexcept{
+			ASSERT(this->tex)
+			return *this->tex;
+		}
+	};
+
+private:
+	struct Page{
+		std::vector<std::uint8_t> pixels;
+		
+		std::shared_ptr<PageTexture> tex;
+		
+		//whether the texture needs to be re-created from the pixels
+		bool dirty = true;
+		
+		//packing state, position of the current row and horizontal position within it
+		unsigned rowY = 0;
+		unsigned rowHeight = 0;
+		unsigned x = 0;
+		
+		Page(size_t size) :
+				pixels(size, 0),
+				tex(std::make_shared<PageTexture>())
+		{}
+	};
+	
+	Texture2D::TexType_e type;
+	
+	kolme::Vec2ui pageDim_v;
+	
+	std::vector<Page> pages;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param type - type of the glyph images.
+	 * @param pageDim - dimensions of atlas page in pixels.
+	 */
+	GlyphAtlas(Texture2D::TexType_e type, kolme::Vec2ui pageDim = kolme::Vec2ui(512));
+	
+	GlyphAtlas(const GlyphAtlas&) = delete;
+	GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+	
+	/**
+	 * @brief Add glyph image to the atlas.
+	 * @param dim - dimensions of the image.
+	 * @param data - image pixels, rows from top to bottom, pixel format as given to the constructor.
+	 * @return Place of the glyph image in the atlas.
+	 */
+	Region add(kolme::Vec2ui dim, const std::uint8_t* data);
+	
+	/**
+	 * @brief Get texture of the atlas page.
+	 * @param page - index of the page.
+	 * @return Texture holding all the images added to the page so far.
+	 */
+	const Texture2D& texture(size_t page){
+		return this->pageTexture(page)->texture();
+	}
+	
+	/**
+	 * @brief Get texture object of the atlas page.
+	 * Use it to refer to the page texture for a long time, e.g. from a mesh.
+	 * Holding the page texture object does not keep outdated copies of the page alive.
+	 * @param page - index of the page.
+	 * @return Texture object of the page, its texture holds all the images added to the page so far.
+	 */
+	std::shared_ptr<const PageTexture> pageTexture(size_t page);
+	
+	/**
+	 * @brief Get texture coordinates of the region.
+	 * @param r - region.
+	 * @return Texture coordinates of the region corners, in the same order as vertices of Renderer::quad01VBO.
+	 */
+	std::array<kolme::Vec2f, 4> texCoords(const Region& r)const noexcept;
+	
+	/**
+	 * @brief Remove all images from the atlas.
+	 * Page texture objects which are still referenced elsewhere stay alive.
+	 */
+	void clear()noexcept{
+		this->pages.clear();
+	}
+	
+	/**
+	 * @brief Get number of pages.
+	 * @return Number of atlas pages.
+	 */
+	size_t numPages()const noexcept{
+		return this->pages.size();
+	}
+	
+	const decltype(pageDim_v)& pageDim()const noexcept{
+		return this->pageDim_v;
+	}
+};
+	
+}
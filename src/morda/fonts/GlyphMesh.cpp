@@ -0,0 +1,100 @@
+#include "GlyphMesh.hxx"
+
+#include <algorithm>
+
+#include <utki/debug.hpp>
+
+#include "../util/util.hpp"
+#include "../Morda.hpp"
+
+
+using namespace morda;
+
+
+
+namespace{
+//quads of one vertex array are limited by 16 bit indices
+const size_t maxQuadsPerPart_c = 0x10000 / 4;
+}
+
+
+
+void GlyphMesh::Builder::add(size_t page, const std::array<kolme::Vec2f, 4>& vertices, const std::array<kolme::Vec2f, 4>& texCoords){
+	auto i = std::find_if(
+			this->pages.begin(),
+			this->pages.end(),
+			[page](const Page& p){
+				return p.page == page;
+			}
+		);
+	if(i == this->pages.end()){
+		this->pages.push_back(Page());
+		i = std::prev(this->pages.end());
+		i->page = page;
+	}
+	
+	i->vertices.insert(i->vertices.end(), vertices.begin(), vertices.end());
+	i->texCoords.insert(i->texCoords.end(), texCoords.begin(), texCoords.end());
+}
+
+
+
+std::unique_ptr<GlyphMesh> GlyphMesh::Builder::build(GlyphAtlas& atlas, ShaderMember shader){
+	std::unique_ptr<GlyphMesh> ret(new GlyphMesh(shader));
+	
+	auto& r = morda::inst().renderer();
+	
+	std::vector<std::uint16_t> indices;
+	
+	for(auto& p : this->pages){
+		auto tex = atlas.pageTexture(p.page);
+		
+		size_t numQuads = p.vertices.size() / 4;
+		
+		for(size_t first = 0; first < numQuads; first += maxQuadsPerPart_c){
+			size_t n = std::min(numQuads - first, maxQuadsPerPart_c);
+			
+			indices.clear();
+			for(size_t q = 0; q != n; ++q){
+				std::uint16_t v = std::uint16_t(q * 4);
+				indices.push_back(v);
+				indices.push_back(v + 1);
+				indices.push_back(v + 2);
+				indices.push_back(v);
+				indices.push_back(v + 2);
+				indices.push_back(v + 3);
+			}
+			
+			Part part;
+			part.tex = tex;
+			part.vao = r.factory->createVertexArray(
+					{
+						r.factory->createVertexBuffer(utki::Buf<kolme::Vec2f>(&p.vertices[first * 4], n * 4)),
+						r.factory->createVertexBuffer(utki::Buf<kolme::Vec2f>(&p.texCoords[first * 4], n * 4))
+					},
+					r.factory->createIndexBuffer(utki::wrapBuf(indices)),
+					VertexArray::Mode_e::TRIANGLES
+				);
+			ret->parts.push_back(std::move(part));
+		}
+	}
+	
+	return ret;
+}
+
+
+
+void GlyphMesh::render(const morda::Matr4r& matrix, kolme::Vec4f color)const{
+	if(this->parts.empty()){
+		return;
+	}
+	
+	auto& shader = morda::inst().renderer().shader.get()->*this->shader;
+	ASSERT(shader)
+	
+	applySimpleAlphaBlending();
+	
+	for(auto& p : this->parts){
+		shader->render(matrix, *p.vao, color, p.tex->texture());
+	}
+}
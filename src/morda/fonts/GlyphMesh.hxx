@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <memory>
+
+#include <kolme/Vector2.hpp>
+
+#include "../render/RenderFactory.hpp"
+
+#include "Font.hpp"
+#include "GlyphAtlas.hxx"
+
+
+namespace morda{
+
+/**
+ * @brief Mesh of glyph quads.
+ * Quads of all the glyphs from the same atlas page are put to one vertex array,
+ * so the whole string is rendered with one draw call per atlas page.
+ * The mesh holds texture objects of the atlas pages, so it always renders with the latest
+ * upload of the page and stays valid even if the atlas is modified or cleared afterwards.
+ */
+class GlyphMesh : public TextMesh{
+public:
+	typedef std::unique_ptr<ShaderColorTexture> RenderFactory::Shaders::* ShaderMember;
+
+private:
+	//shader is looked up at render time, because renderer's shaders can be replaced, e.g. by render list recording
+	ShaderMember shader;
+	
+	struct Part{
+		std::shared_ptr<const GlyphAtlas::PageTexture> tex;
+		std::shared_ptr<VertexArray> vao;
+	};
+	
+	std::vector<Part> parts;
+	
+	GlyphMesh(ShaderMember shader) :
+			shader(shader)
+	{}
+
+public:
+	/**
+	 * @brief Collects glyph quads for building the mesh.
+	 */
+	class Builder{
+		struct Page{
+			size_t page;
+			std::vector<kolme::Vec2f> vertices;
+			std::vector<kolme::Vec2f> texCoords;
+		};
+		
+		std::vector<Page> pages;
+	
+	public:
+		/**
+		 * @brief Add glyph quad.
+		 * @param page - atlas page of the glyph image.
+		 * @param vertices - quad corners, in the same order as returned by GlyphAtlas::texCoords().
+		 * @param texCoords - texture coordinates of the quad corners.
+		 */
+		void add(size_t page, const std::array<kolme::Vec2f, 4>& vertices, const std::array<kolme::Vec2f, 4>& texCoords);
+		
+		/**
+		 * @brief Build the mesh.
+		 * @param atlas - glyph atlas the quads refer to.
+		 * @param shader - shader to render the mesh with.
+		 * @return The mesh.
+		 */
+		std::unique_ptr<GlyphMesh> build(GlyphAtlas& atlas, ShaderMember shader);
+	};
+	
+	void render(const morda::Matr4r& matrix, kolme::Vec4f color)const override;
+};
+	
+}
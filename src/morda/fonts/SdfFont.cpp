@@ -0,0 +1,356 @@
+#include "SdfFont.hxx"
+#include "GlyphMesh.hxx"
+
+#include <cmath>
+#include <algorithm>
+
+#include <utki/debug.hpp>
+#include <utki/util.hpp>
+
+#include "../util/util.hpp"
+#include "../Morda.hpp"
+#include "../Exc.hpp"
+
+
+using namespace morda;
+
+
+
+namespace{
+
+constexpr const char32_t unknownChar_c = 0xfffd;
+
+//maximal distance to glyph edge stored in the distance field, in pixels of the base size
+const int spread_c = 6;
+	
+}
+
+
+
+const unsigned SdfFace::baseSize = 48;
+
+
+
+SdfFace::SdfFace(const papki::File& fi) :
+		SdfFace(FontFile::load(fi))
+{}
+
+
+
+SdfFace::SdfFace(std::shared_ptr<const FontFile> fontFile) :
+		face(std::move(fontFile)),
+		atlas(Texture2D::TexType_e::GREY)
+{
+	if(FT_Set_Pixel_Sizes(this->face.f, 0, SdfFace::baseSize) != 0){
+		throw morda::Exc("SdfFace::SdfFace(): unable to set char size");
+	}
+	
+	this->unknownGlyph = this->loadGlyph(unknownChar_c);
+	
+	this->height = real(this->face.f->size->metrics.height) / (64.0f);
+	this->descender = -real(this->face.f->size->metrics.descender) / (64.0f);
+	this->ascender = real(this->face.f->size->metrics.ascender) / (64.0f);
+}
+
+
+
+SdfFace::Glyph SdfFace::loadGlyph(char32_t c){
+	//no hinting, glyphs are scaled to different sizes
+	if(FT_Load_Char(this->face.f, FT_ULong(c), FT_LOAD_RENDER | FT_LOAD_NO_HINTING) != 0){
+		if(c == unknownChar_c){
+			throw morda::Exc("SdfFace::loadGlyph(): could not load 'unknown character' glyph (UTF-32: 0xfffd)");
+		}
+		TRACE(<< "SdfFace::loadGlyph(" << std::hex << std::uint32_t(c) << "): failed to load glyph" << std::endl)
+		return this->unknownGlyph;
+	}
+	
+	FT_GlyphSlot slot = this->face.f->glyph;
+	
+	FT_Glyph_Metrics *m = &slot->metrics;
+	
+	Glyph g;
+	g.advance = real(m->horiAdvance) / (64.0f);
+	g.topLeft = morda::Vec2r(0);
+	g.bottomRight = morda::Vec2r(0);
+	
+	if(!slot->bitmap.buffer){
+		//empty glyph (space, tab, etc...)
+		return g;
+	}
+	
+	g.topLeft = morda::Vec2r(real(m->horiBearingX), -real(m->horiBearingY)) / (64.0f);
+	g.bottomRight = morda::Vec2r(real(m->horiBearingX + m->width), real(m->height - m->horiBearingY)) / (64.0f);
+	
+	//compute distance field, the image is extended by spread on each side
+	int w = int(slot->bitmap.width);
+	int h = int(slot->bitmap.rows);
+	
+	auto isInside = [slot, w, h](int x, int y) -> bool{
+		if(x < 0 || y < 0 || x >= w || y >= h){
+			return false;
+		}
+		return slot->bitmap.buffer[y * slot->bitmap.pitch + x] >= 0x80;
+	};
+	
+	kolme::Vec2ui dim(w + 2 * spread_c, h + 2 * spread_c);
+	
+	std::vector<std::uint8_t> sdf(dim.x * dim.y);
+	
+	for(int y = 0; y != int(dim.y); ++y){
+		for(int x = 0; x != int(dim.x); ++x){
+			int sx = x - spread_c;
+			int sy = y - spread_c;
+			
+			bool inside = isInside(sx, sy);
+			
+			//search for nearest pixel of opposite state
+			int minDist2 = (spread_c + 1) * (spread_c + 1);
+			for(int dy = -spread_c; dy <= spread_c; ++dy){
+				for(int dx = -spread_c; dx <= spread_c; ++dx){
+					int d2 = dx * dx + dy * dy;
+					if(d2 < minDist2 && isInside(sx + dx, sy + dy) != inside){
+						minDist2 = d2;
+					}
+				}
+			}
+			
+			//edge is half way between pixel centers
+			real dist = std::sqrt(real(minDist2)) - real(0.5);
+			if(!inside){
+				dist = -dist;
+			}
+			
+			real v = real(0.5) + dist / real(2 * spread_c);
+			utki::clampRange(v, real(0), real(1));
+			
+			sdf[y * dim.x + x] = std::uint8_t(v * 0xff);
+		}
+	}
+	
+	auto region = this->atlas.add(dim, &sdf[0]);
+	g.page = region.page;
+	g.texCoords = this->atlas.texCoords(region);
+	
+	std::array<kolme::Vec2f, 4> verts;
+	verts[0] = g.topLeft - morda::Vec2r(spread_c);
+	verts[1] = morda::Vec2r(g.topLeft.x - spread_c, g.bottomRight.y + spread_c);
+	verts[2] = g.bottomRight + morda::Vec2r(spread_c);
+	verts[3] = morda::Vec2r(g.bottomRight.x + spread_c, g.topLeft.y - spread_c);
+	
+	auto& r = morda::inst().renderer();
+	g.vao = r.factory->createVertexArray(
+			{
+				r.factory->createVertexBuffer(utki::wrapBuf(verts)),
+				r.factory->createVertexBuffer(utki::wrapBuf(g.texCoords))
+			},
+			r.quadIndices,
+			VertexArray::Mode_e::TRIANGLE_FAN
+		);
+	
+	return g;
+}
+
+
+
+const SdfFace::Glyph& SdfFace::getGlyph(char32_t c){
+	auto i = this->glyphs.find(c);
+	if(i == this->glyphs.end()){
+		i = this->glyphs.insert(std::make_pair(c, this->loadGlyph(c))).first;
+	}
+	return i->second;
+}
+
+
+
+real SdfFace::kerning(char32_t left, char32_t right)const{
+	if(!FT_HAS_KERNING(this->face.f)){
+		return 0;
+	}
+	
+	FT_Vector delta;
+	if(FT_Get_Kerning(
+			this->face.f,
+			FT_Get_Char_Index(this->face.f, FT_ULong(left)),
+			FT_Get_Char_Index(this->face.f, FT_ULong(right)),
+			FT_KERNING_UNFITTED,
+			&delta
+		) != 0)
+	{
+		return 0;
+	}
+	
+	return real(delta.x) / (64.0f);
+}
+
+
+
+SdfFont::SdfFont(std::shared_ptr<SdfFace> face, unsigned fontSize) :
+		face(std::move(face)),
+		scale(real(fontSize) / real(SdfFace::baseSize))
+{
+	ASSERT(this->face)
+	
+	using std::ceil;
+	
+	this->height_v = ceil(this->face->height * this->scale);
+	this->descender_v = ceil(this->face->descender * this->scale);
+	this->ascender_v = ceil(this->face->ascender * this->scale);
+}
+
+
+
+real SdfFont::charAdvance(char32_t c)const{
+	return this->face->getGlyph(c).advance * this->scale;
+}
+
+
+
+real SdfFont::kerning(char32_t left, char32_t right)const{
+	return this->face->kerning(left, right) * this->scale;
+}
+
+
+
+morda::Rectr SdfFont::charBoundingBox(char32_t c)const{
+	const SdfFace::Glyph& g = this->face->getGlyph(c);
+	return morda::Rectr(g.topLeft * this->scale, (g.bottomRight - g.topLeft) * this->scale);
+}
+
+
+
+void SdfFont::prewarm(const std::u32string& chars)const{
+	for(auto c : chars){
+		this->face->getGlyph(c);
+	}
+}
+
+
+
+std::unique_ptr<TextMesh> SdfFont::makeMesh(const std::u32string& str)const{
+	GlyphMesh::Builder builder;
+	
+	real advance = 0;
+	
+	for(auto s = str.begin(); s != str.end(); ++s){
+		if(s != str.begin()){
+			advance += this->face->kerning(*(s - 1), *s);
+		}
+		
+		const SdfFace::Glyph& g = this->face->getGlyph(*s);
+		
+		if(g.vao){
+			//quad including the distance field spread, same as the glyph's vertex array
+			kolme::Vec2f tl(g.topLeft - morda::Vec2r(spread_c)), br(g.bottomRight + morda::Vec2r(spread_c));
+			
+			std::array<kolme::Vec2f, 4> verts;
+			verts[0] = kolme::Vec2f(advance + tl.x, tl.y) * this->scale;
+			verts[1] = kolme::Vec2f(advance + tl.x, br.y) * this->scale;
+			verts[2] = kolme::Vec2f(advance + br.x, br.y) * this->scale;
+			verts[3] = kolme::Vec2f(advance + br.x, tl.y) * this->scale;
+			
+			builder.add(g.page, verts, g.texCoords);
+		}
+		
+		advance += g.advance;
+	}
+	
+	return builder.build(this->face->glyphAtlas(), &RenderFactory::Shaders::colorPosTexSdf);
+}
+
+
+
+real SdfFont::stringAdvanceInternal(const std::u32string& str)const{
+	real ret = 0;
+	
+	for(auto s = str.begin(); s != str.end(); ++s){
+		if(s != str.begin()){
+			ret += this->face->kerning(*(s - 1), *s);
+		}
+		ret += this->face->getGlyph(*s).advance;
+	}
+	
+	return ret * this->scale;
+}
+
+
+
+morda::Rectr SdfFont::stringBoundingBoxInternal(const std::u32string& str)const{
+	if(str.size() == 0){
+		return morda::Rectr(0, 0, 0, 0);
+	}
+	
+	real curAdvance = 0;
+	
+	real left, right, top, bottom;
+	
+	for(auto s = str.begin(); s != str.end(); ++s){
+		const SdfFace::Glyph& g = this->face->getGlyph(*s);
+		
+		if(s == str.begin()){
+			//init with bounding box of the first glyph
+			left = g.topLeft.x;
+			right = g.bottomRight.x;
+			top = g.topLeft.y;
+			bottom = g.bottomRight.y;
+		}else{
+			curAdvance += this->face->kerning(*(s - 1), *s);
+			
+			using std::min;
+			using std::max;
+			
+			top = min(g.topLeft.y, top);
+			bottom = max(g.bottomRight.y, bottom);
+			left = min(curAdvance + g.topLeft.x, left);
+			right = max(curAdvance + g.bottomRight.x, right);
+		}
+		
+		curAdvance += g.advance;
+	}
+	
+	return morda::Rectr(
+			left * this->scale,
+			top * this->scale,
+			(right - left) * this->scale,
+			(bottom - top) * this->scale
+		);
+}
+
+
+
+real SdfFont::renderStringInternal(const morda::Matr4r& matrix, kolme::Vec4f color, const std::u32string& str)const{
+	if(str.size() == 0){
+		return 0;
+	}
+	
+	auto& shader = morda::inst().renderer().shader->colorPosTexSdf;
+	ASSERT(shader)
+	
+	applySimpleAlphaBlending();
+	
+	//load all glyphs before getting page textures, so that a page which got new glyphs is uploaded once and not for every new glyph
+	this->prewarm(str);
+	
+	morda::Matr4r matr(matrix);
+	matr.scale(this->scale);
+	
+	real advance = 0;
+	
+	for(auto s = str.begin(); s != str.end(); ++s){
+		if(s != str.begin()){
+			advance += this->face->kerning(*(s - 1), *s);
+		}
+		
+		const SdfFace::Glyph& g = this->face->getGlyph(*s);
+		
+		//texture can be null for glyph of empty characters, like space, tab etc...
+		if(g.vao){
+			morda::Matr4r m(matr);
+			m.translate(advance, 0);
+			shader->render(m, *g.vao, color, this->face->texture(g.page));
+		}
+		
+		advance += g.advance;
+	}
+	
+	return advance * this->scale;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <unordered_map>
+#include <memory>
+
+#include <kolme/Vector2.hpp>
+#include <kolme/Rectangle.hpp>
+
+#include <papki/File.hpp>
+
+#include "../config.hpp"
+
+#include "../render/Texture2D.hpp"
+#include "../render/VertexArray.hpp"
+
+#include "Font.hpp"
+#include "FreeType.hxx"
+#include "GlyphAtlas.hxx"
+
+
+namespace morda{
+
+/**
+ * @brief Signed distance field glyphs of a font face.
+ * Glyphs are rasterized once, at fixed base size, to signed distance field images
+ * which are packed to a glyph atlas. The same glyphs are used by SdfFont objects of all sizes,
+ * so memory and rasterization time do not depend on number of font sizes in use.
+ */
+class SdfFace{
+public:
+	struct Glyph{
+		//glyph bounding box, in pixels of the base size
+		morda::Vec2r topLeft;
+		morda::Vec2r bottomRight;
+		
+		std::shared_ptr<VertexArray> vao;
+		size_t page;
+		std::array<kolme::Vec2f, 4> texCoords;
+		
+		real advance;
+	};
+
+private:
+	FreeTypeFaceWrapper face;
+	
+	GlyphAtlas atlas;
+	
+	std::unordered_map<char32_t, Glyph> glyphs;
+	
+	Glyph unknownGlyph;
+	
+	Glyph loadGlyph(char32_t c);
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param fi - file interface to read Truetype font from, i.e. 'ttf' file.
+	 */
+	SdfFace(const papki::File& fi);
+	
+	/**
+	 * @brief Constructor.
+	 * @param fontFile - contents of Truetype font file.
+	 */
+	SdfFace(std::shared_ptr<const FontFile> fontFile);
+	
+	SdfFace(const SdfFace&) = delete;
+	SdfFace& operator=(const SdfFace&) = delete;
+	
+	/**
+	 * @brief Size the glyphs are rasterized with.
+	 * All glyph metrics are given in pixels of this size.
+	 */
+	static const unsigned baseSize;
+	
+	real height;
+	real ascender;
+	real descender;
+	
+	const Glyph& getGlyph(char32_t c);
+	
+	real kerning(char32_t left, char32_t right)const;
+	
+	const Texture2D& texture(size_t page){
+		return this->atlas.texture(page);
+	}
+	
+	/**
+	 * @brief Get glyph atlas.
+	 * @return Atlas holding the glyph images.
+	 */
+	GlyphAtlas& glyphAtlas()noexcept{
+		return this->atlas;
+	}
+};
+
+
+
+/**
+ * @brief A signed distance field font.
+ * This font implementation renders glyphs from signed distance field images held by SdfFace.
+ * Glyphs stay sharp at any scale, and fonts of different sizes created from the same face share all the glyph data.
+ * Requires the renderer to provide RenderFactory::Shaders::colorPosTexSdf shader.
+ */
+class SdfFont : public Font{
+	std::shared_ptr<SdfFace> face;
+	
+	//scale from base size of the face to the size of this font
+	real scale;
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param face - font face to take the glyphs from.
+	 * @param fontSize - size of the font in pixels.
+	 */
+	SdfFont(std::shared_ptr<SdfFace> face, unsigned fontSize);
+	
+	real charAdvance(char32_t c)const override;
+	
+	real kerning(char32_t left, char32_t right)const override;
+	
+	morda::Rectr charBoundingBox(char32_t c)const override;
+	
+	void prewarm(const std::u32string& chars)const override;
+	
+	std::unique_ptr<TextMesh> makeMesh(const std::u32string& str)const override;
+
+protected:
+	real renderStringInternal(const morda::Matr4r& matrix, kolme::Vec4f color, const std::u32string& str)const override;
+	
+	real stringAdvanceInternal(const std::u32string& str)const override;
+	
+	morda::Rectr stringBoundingBoxInternal(const std::u32string& str)const override;
+};
+	
+}
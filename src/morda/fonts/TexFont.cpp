@@ -1,5 +1,7 @@
 #include <algorithm>
-
+#include <thread>
+#include <exception>
+#include <unordered_set>
 
 #include <utki/debug.hpp>
 
@@ -7,6 +9,7 @@
 #include "../util/util.hpp"
 
 #include "TexFont.hxx"
+#include "GlyphMesh.hxx"
 #include "../Morda.hpp"
 
 
@@ -19,104 +22,137 @@ namespace{
 
 constexpr const char32_t unknownChar_c = 0xfffd;
 
-}
+const size_t maxCachedRuns_c = 256;
 
-TexFont::FreeTypeLibWrapper::FreeTypeLibWrapper() {
-	if (FT_Init_FreeType(&this->lib)) {
-		throw utki::Exc("FreeTypeLibWrapper::FreeTypeLibWrapper(): unable to init freetype library");
-	}
-}
+//longer strings are mostly edited text chunks, those are not worth caching
+const size_t maxCachedRunLength_c = 256;
+
+//prewarming fewer glyphs per thread is not worth starting a thread
+const size_t minPrewarmGlyphsPerThread_c = 32;
 
-TexFont::FreeTypeLibWrapper::~FreeTypeLibWrapper()noexcept{
-	FT_Done_FreeType(this->lib);
+void setPixelSize(FT_Face face, unsigned fontSize){
+	FT_Error error = FT_Set_Pixel_Sizes(
+			face,
+			0, // pixel_width (0 means "same as height")
+			fontSize // pixel_height
+		);
+
+	if(error != 0){
+		throw utki::Exc("TexFont::TexFont(): unable to set char size");
+	}
 }
 
-TexFont::FreeTypeFaceWrapper::FreeTypeFaceWrapper(FT_Library& lib, const papki::File& fi) {
-	this->fontFile = fi.loadWholeFileIntoMemory();
-	if (FT_New_Memory_Face(lib, & * this->fontFile.begin(), int(this->fontFile.size()), 0/* face_index */, &this->f) != 0) {
-		throw utki::Exc("FreeTypeFaceWrapper::FreeTypeFaceWrapper(): unable to crate font face object");
+//atlas page should fit several of the biggest glyphs
+unsigned atlasPageSize(unsigned fontSize){
+	unsigned ret = 512;
+	while(ret < 4 * fontSize){
+		ret *= 2;
 	}
+	return ret;
 }
 
-TexFont::FreeTypeFaceWrapper::~FreeTypeFaceWrapper()noexcept{
-	FT_Done_Face(this->f);
 }
-TexFont::Glyph TexFont::loadGlyph(char32_t c) const{
-	if(FT_Load_Char(this->face.f, FT_ULong(c), FT_LOAD_RENDER) != 0){
-		if(c == unknownChar_c){
-			throw morda::Exc("TexFont::loadGlyph(): could not load 'unknown character' glyph (UTF-32: 0xfffd)");
-		}
-		TRACE(<< "TexFont::loadGlyph(" << std::hex << std::uint32_t(c) << "): failed to load glyph" << std::endl)
-		return this->unknownGlyph;
+
+TexFont::RasterizedGlyph TexFont::rasterizeGlyph(FT_Face face, char32_t c){
+	RasterizedGlyph ret;
+	
+	if(FT_Load_Char(face, FT_ULong(c), FT_LOAD_RENDER) != 0){
+		return ret;
 	}
 	
-	FT_GlyphSlot slot = this->face.f->glyph;
+	ret.isLoaded = true;
+	ret.topLeft = morda::Vec2r(0);
+	ret.bottomRight = morda::Vec2r(0);
+	
+	FT_GlyphSlot slot = face->glyph;
 	
 	FT_Glyph_Metrics *m = &slot->metrics;
 	
-	Glyph g;
-	g.advance = real(m->horiAdvance) / (64.0f);
+	ret.advance = real(m->horiAdvance) / (64.0f);
 	
 	if(!slot->bitmap.buffer){
 		//empty glyph (space, tab, etc...)
 		
-		return g;
+		return ret;
 	}
 	
 	RasterImage glyphim(kolme::Vec2ui(slot->bitmap.width, slot->bitmap.rows), RasterImage::ColorDepth_e::GREY, slot->bitmap.buffer);
 
-	RasterImage im(glyphim.dim(), RasterImage::ColorDepth_e::GREYA);
-	im.blit(0, 0, glyphim, 1, 0);
-	im.clear(0, std::uint8_t(0xff));
+	ret.image.init(glyphim.dim(), RasterImage::ColorDepth_e::GREYA);
+	ret.image.blit(0, 0, glyphim, 1, 0);
+	ret.image.clear(0, std::uint8_t(0xff));
 	
+	ret.topLeft = morda::Vec2r(real(m->horiBearingX), -real(m->horiBearingY)) / (64.0f);
+	ret.bottomRight = morda::Vec2r(real(m->horiBearingX + m->width), real(m->height - m->horiBearingY)) / (64.0f);
 	
+	return ret;
+}
+
+
+
+TexFont::Glyph TexFont::makeGlyph(const RasterizedGlyph& rg)const{
+	ASSERT(rg.isLoaded)
+	
+	Glyph g;
+	g.advance = rg.advance;
+	g.topLeft = rg.topLeft;
+	g.bottomRight = rg.bottomRight;
+	
+	if(rg.image.buf().size() == 0){
+		//empty glyph (space, tab, etc...)
+		
+		return g;
+	}
+	
+	auto region = this->atlas.add(rg.image.dim(), &*rg.image.buf().begin());
+	g.page = region.page;
+	g.texCoords = this->atlas.texCoords(region);
 	
 	std::array<kolme::Vec2f, 4> verts;
-	verts[0] = (morda::Vec2r(real(m->horiBearingX), -real(m->horiBearingY)) / (64.0f));
-	verts[1] = (morda::Vec2r(real(m->horiBearingX), real(m->height - m->horiBearingY)) / (64.0f));
-	verts[2] = (morda::Vec2r(real(m->horiBearingX + m->width), real(m->height - m->horiBearingY)) / (64.0f));
-	verts[3] = (morda::Vec2r(real(m->horiBearingX + m->width), -real(m->horiBearingY)) / (64.0f));
-
-	g.topLeft = verts[0];
-	g.bottomRight = verts[2];
+	verts[0] = rg.topLeft;
+	verts[1] = morda::Vec2r(rg.topLeft.x, rg.bottomRight.y);
+	verts[2] = rg.bottomRight;
+	verts[3] = morda::Vec2r(rg.bottomRight.x, rg.topLeft.y);
 
 	auto& r = morda::inst().renderer();
 	g.vao = r.factory->createVertexArray(
 			{
 				r.factory->createVertexBuffer(utki::wrapBuf(verts)),
-				morda::inst().renderer().quad01VBO
+				r.factory->createVertexBuffer(utki::wrapBuf(g.texCoords))
 			},
 			morda::inst().renderer().quadIndices,
 			VertexArray::Mode_e::TRIANGLE_FAN
 		);
-	g.tex = morda::inst().renderer().factory->createTexture2D(
-			morda::numChannelsToTexType(im.numChannels()),
-			im.dim(),
-			im.buf()
-		);
 	
 	return g;
 }
 
 
+
+TexFont::Glyph TexFont::loadGlyph(char32_t c) const{
+	auto rg = rasterizeGlyph(this->face.f, c);
+	if(!rg.isLoaded){
+		if(c == unknownChar_c){
+			throw morda::Exc("TexFont::loadGlyph(): could not load 'unknown character' glyph (UTF-32: 0xfffd)");
+		}
+		TRACE(<< "TexFont::loadGlyph(" << std::hex << std::uint32_t(c) << "): failed to load glyph" << std::endl)
+		return this->unknownGlyph;
+	}
+	
+	return this->makeGlyph(rg);
+}
+
+
 TexFont::TexFont(const papki::File& fi, unsigned fontSize, unsigned maxCached) :
 		maxCached(maxCached),
-		face(freetype.lib, fi)
+		fontSize(fontSize),
+		face(fi),
+		atlas(Texture2D::TexType_e::GREYA, kolme::Vec2ui(atlasPageSize(fontSize)))
 {
 //	TRACE(<< "TexFont::Load(): enter" << std::endl)
 
 	//set character size in pixels
-	{
-		FT_Error error = FT_Set_Pixel_Sizes(
-				this->face.f,
-				0, // pixel_width (0 means "same as height")
-				fontSize // pixel_height
-			);
-
-		if(error != 0){
-			throw utki::Exc("TexFont::TexFont(): unable to set char size");
-		}
-	}
+	setPixelSize(this->face.f, fontSize);
 	
 	this->unknownGlyph = this->loadGlyph(unknownChar_c);
 
@@ -135,36 +171,139 @@ TexFont::TexFont(const papki::File& fi, unsigned fontSize, unsigned maxCached) :
 const TexFont::Glyph& TexFont::getGlyph(char32_t c)const{
 	auto i = this->glyphs.find(c);
 	if(i == this->glyphs.end()){
-		auto r = this->glyphs.insert(std::make_pair(c, this->loadGlyph(c)));
-		ASSERT(r.second)
-		i = r.first;
-		this->lastUsedOrder.push_front(c);
-		i->second.lastUsedIter = this->lastUsedOrder.begin();
-		
-		if(this->lastUsedOrder.size() == this->maxCached){
-			this->glyphs.erase(this->lastUsedOrder.back());
-			this->lastUsedOrder.pop_back();
-		}
-//		TRACE(<< "TexFont::getGlyph(): glyph loaded: " << c << std::endl)
-	}else{
-		Glyph& g = i->second;
-		this->lastUsedOrder.splice(this->lastUsedOrder.begin(), this->lastUsedOrder, g.lastUsedIter);
+		this->compactAtlas();
+		return this->cacheGlyph(c, this->loadGlyph(c));
+	}
+	
+	Glyph& g = i->second;
+	this->lastUsedOrder.splice(this->lastUsedOrder.begin(), this->lastUsedOrder, g.lastUsedIter);
+	
+	return g;
+}
+
+
+
+const TexFont::Glyph& TexFont::cacheGlyph(char32_t c, Glyph&& g)const{
+	auto r = this->glyphs.insert(std::make_pair(c, std::move(g)));
+	ASSERT(r.second)
+	auto i = r.first;
+	this->lastUsedOrder.push_front(c);
+	i->second.lastUsedIter = this->lastUsedOrder.begin();
+	
+	if(this->lastUsedOrder.size() == this->maxCached){
+		this->glyphs.erase(this->lastUsedOrder.back());
+		this->lastUsedOrder.pop_back();
+		++this->numEvicted;
 	}
 	
 	ASSERT(this->lastUsedOrder.size() <= this->maxCached)
-		
+	
 	return i->second;
 }
 
 
 
+void TexFont::compactAtlas()const{
+	if(this->numEvicted == 0 || this->numEvicted < this->glyphs.size()){
+		return;
+	}
+	
+	//more than half of the atlas is occupied by evicted glyphs, start over
+	this->glyphs.clear();
+	this->lastUsedOrder.clear();
+	this->atlas.clear();
+	this->numEvicted = 0;
+	++this->atlasGeneration;
+	
+	this->unknownGlyph = this->loadGlyph(unknownChar_c);
+}
+
+
+
+void TexFont::prewarm(const std::u32string& chars)const{
+	std::vector<char32_t> toLoad;
+	{
+		std::unordered_set<char32_t> added;
+		for(auto c : chars){
+			if(this->glyphs.find(c) != this->glyphs.end()){
+				continue;
+			}
+			if(!added.insert(c).second){
+				continue;
+			}
+			toLoad.push_back(c);
+		}
+	}
+	
+	if(toLoad.size() == 0){
+		return;
+	}
+	
+	std::vector<RasterizedGlyph> rasterized(toLoad.size());
+	
+	size_t numThreads = std::min(size_t(std::thread::hardware_concurrency()), toLoad.size() / minPrewarmGlyphsPerThread_c);
+	
+	if(numThreads <= 1){
+		for(size_t i = 0; i != toLoad.size(); ++i){
+			rasterized[i] = rasterizeGlyph(this->face.f, toLoad[i]);
+		}
+	}else{
+		std::vector<std::exception_ptr> errors(numThreads);
+		std::vector<std::thread> threads;
+		
+		for(size_t t = 0; t != numThreads; ++t){
+			threads.emplace_back(
+					[this, t, numThreads, &toLoad, &rasterized, &errors](){
+						try{
+							//FreeType face object cannot be used by several threads at once
+							FreeTypeFaceWrapper face(this->face.fontFile);
+							setPixelSize(face.f, this->fontSize);
+							
+							//interleave characters among threads, so that complex glyphs are spread evenly
+							for(size_t i = t; i < toLoad.size(); i += numThreads){
+								rasterized[i] = rasterizeGlyph(face.f, toLoad[i]);
+							}
+						}catch(...){
+							errors[t] = std::current_exception();
+						}
+					}
+				);
+		}
+		
+		for(auto& t : threads){
+			t.join();
+		}
+		
+		for(auto& e : errors){
+			if(e){
+				std::rethrow_exception(e);
+			}
+		}
+	}
+	
+	//add glyphs to the atlas, page textures are uploaded once, when the glyphs are rendered
+	for(size_t i = 0; i != toLoad.size(); ++i){
+		if(this->glyphs.find(toLoad[i]) != this->glyphs.end()){
+			continue;
+		}
+		this->compactAtlas();
+		if(rasterized[i].isLoaded){
+			this->cacheGlyph(toLoad[i], this->makeGlyph(rasterized[i]));
+		}else{
+			TRACE(<< "TexFont::prewarm(" << std::hex << std::uint32_t(toLoad[i]) << "): failed to load glyph" << std::endl)
+			this->cacheGlyph(toLoad[i], Glyph(this->unknownGlyph));
+		}
+	}
+}
+
+
+
 real TexFont::renderGlyphInternal(const morda::Matr4r& matrix, kolme::Vec4f color, char32_t ch)const{
 	const Glyph& g = this->getGlyph(ch);
 	
-	//texture can be null for glyph of empty characters, like space, tab etc...
-	if(g.tex){
-		ASSERT(g.vao)
-		morda::inst().renderer().shader->colorPosTex->render(matrix, *g.vao, color, *g.tex);
+	//vertex array can be null for glyph of empty characters, like space, tab etc...
+	if(g.vao){
+		morda::inst().renderer().shader->colorPosTex->render(matrix, *g.vao, color, this->atlas.texture(g.page));
 	}
 
 	return g.advance;
@@ -172,73 +311,129 @@ real TexFont::renderGlyphInternal(const morda::Matr4r& matrix, kolme::Vec4f colo
 
 
 
-real TexFont::stringAdvanceInternal(const std::u32string& str)const{
-	real ret = 0;
+void TexFont::shape(ShapedRun& run, const std::u32string& str)const{
+	run.positions.resize(str.size());
+	
+	if(str.size() == 0){
+		run.advance = 0;
+		run.boundingBox = morda::Rectr(0, 0, 0, 0);
+		return;
+	}
+	
+	real curAdvance = 0;
 
-	auto s = str.begin();
+	real left, right, top, bottom;
 	
-	for(; s != str.end(); ++s){
-		try{
-			const Glyph& g = this->getGlyph(*s);
-			ret += g.advance;
-		}catch(std::out_of_range&){
-			//ignore
+	for(size_t i = 0; i != str.size(); ++i){
+		const Glyph& g = this->getGlyph(str[i]);
+		
+		if(i == 0){
+			//init with bounding box of the first glyph
+			left = g.topLeft.x;
+			right = g.bottomRight.x;
+			top = g.topLeft.y;
+			bottom = g.bottomRight.y;
+		}else{
+			curAdvance += this->kerning(str[i - 1], str[i]);
+			
+			using std::min;
+			using std::max;
+
+			top = min(g.topLeft.y, top);
+			bottom = max(g.bottomRight.y, bottom);
+			left = min(curAdvance + g.topLeft.x, left);
+			right = max(curAdvance + g.bottomRight.x, right);
 		}
+		
+		run.positions[i] = curAdvance;
+		
+		curAdvance += g.advance;
 	}
+	
+	run.advance = curAdvance;
+	
+	run.boundingBox.p.x = left;
+	run.boundingBox.p.y = top;
+	run.boundingBox.d.x = right - left;
+	run.boundingBox.d.y = -(top - bottom);
 
-	return ret;
+	ASSERT(run.boundingBox.d.x >= 0)
+	ASSERT(run.boundingBox.d.y >= 0)
 }
 
 
 
-morda::Rectr TexFont::stringBoundingBoxInternal(const std::u32string& str)const{
-	morda::Rectr ret;
-
-	if(str.size() == 0){
-		ret.p.set(0);
-		ret.d.set(0);
-		return ret;
+const TexFont::ShapedRun& TexFont::getRun(const std::u32string& str)const{
+	if(str.size() > maxCachedRunLength_c){
+		this->shape(this->uncachedRun, str);
+		return this->uncachedRun;
 	}
+	
+	auto i = this->runs.find(str);
+	if(i == this->runs.end()){
+		ShapedRun run;
+		this->shape(run, str);
+		
+		i = this->runs.insert(std::make_pair(str, std::move(run))).first;
+		this->runsLastUsedOrder.push_front(&i->first);
+		i->second.lastUsedIter = this->runsLastUsedOrder.begin();
+		
+		if(this->runsLastUsedOrder.size() > maxCachedRuns_c){
+			auto e = this->runs.find(*this->runsLastUsedOrder.back());
+			ASSERT(e != this->runs.end())
+			this->runsLastUsedOrder.pop_back();
+			this->runs.erase(e);
+		}
+	}else{
+		this->runsLastUsedOrder.splice(this->runsLastUsedOrder.begin(), this->runsLastUsedOrder, i->second.lastUsedIter);
+	}
+	
+	return i->second;
+}
 
-	auto s = str.begin();
 
-	real curAdvance;
 
-	real left, right, top, bottom;
-	//init with bounding box of the first glyph
-	{
-		const Glyph& g = this->getGlyph(*s);
-		left = g.topLeft.x;
-		right = g.bottomRight.x;
-		top = g.topLeft.y;
-		bottom = g.bottomRight.y;
-		curAdvance = g.advance;
-		++s;
+std::unique_ptr<TextMesh> TexFont::makeMesh(const std::u32string& str)const{
+	const ShapedRun& run = this->getRun(str);
+	
+	size_t generation = this->atlasGeneration;
+	
+	GlyphMesh::Builder builder;
+	
+	for(size_t i = 0; i != str.size(); ++i){
+		const Glyph& g = this->getGlyph(str[i]);
+		
+		if(!g.vao){
+			continue;
+		}
+		
+		std::array<kolme::Vec2f, 4> verts;
+		verts[0] = morda::Vec2r(run.positions[i] + g.topLeft.x, g.topLeft.y);
+		verts[1] = morda::Vec2r(run.positions[i] + g.topLeft.x, g.bottomRight.y);
+		verts[2] = morda::Vec2r(run.positions[i] + g.bottomRight.x, g.bottomRight.y);
+		verts[3] = morda::Vec2r(run.positions[i] + g.bottomRight.x, g.topLeft.y);
+		
+		builder.add(g.page, verts, g.texCoords);
+	}
+	
+	if(generation != this->atlasGeneration){
+		//the string has more different characters than the glyph cache can hold, glyphs were evicted while building the mesh
+		return this->Font::makeMesh(str);
 	}
+	
+	return builder.build(this->atlas, &RenderFactory::Shaders::colorPosTex);
+}
 
-	for(; s != str.end(); ++s){
-		const Glyph& g = this->getGlyph(*s);
 
-		using std::min;
-		using std::max;
-		
-		top = min(g.topLeft.y, top);
-		bottom = max(g.bottomRight.y, bottom);
-		left = min(curAdvance + g.topLeft.x, left);
-		right = max(curAdvance + g.bottomRight.x, right);
 
-		curAdvance += g.advance;
-	}
+real TexFont::stringAdvanceInternal(const std::u32string& str)const{
+	return this->getRun(str).advance;
+}
 
-	ret.p.x = left;
-	ret.p.y = top;
-	ret.d.x = right - left;
-	ret.d.y = -(top - bottom);
 
-	ASSERT(ret.d.x >= 0)
-	ASSERT(ret.d.y >= 0)
-//	TRACE(<< "TexFont::stringBoundingBoxInternal(): ret = " << ret << std::endl)
-	return ret;
+
+morda::Rectr TexFont::stringBoundingBoxInternal(const std::u32string& str)const{
+	return this->getRun(str).boundingBox;
 }
 
 
@@ -248,26 +443,17 @@ real TexFont::renderStringInternal(const morda::Matr4r& matrix, kolme::Vec4f col
 		return 0;
 	}
 	
+	const ShapedRun& run = this->getRun(str);
+	
 	applySimpleAlphaBlending();
 
-	real ret = 0;
-
-	morda::Matr4r matr(matrix);
-
-	auto s = str.begin();
-
-	for(; s != str.end(); ++s){
-		try{
-			real advance = this->renderGlyphInternal(matr, color, *s);
-			ret += advance;
-			matr.translate(advance, 0);
-		}catch(std::out_of_range&){
-			//ignore
-		}
+	for(size_t i = 0; i != str.size(); ++i){
+		morda::Matr4r matr(matrix);
+		matr.translate(run.positions[i], 0);
+		this->renderGlyphInternal(matr, color, str[i]);
 	}
-	
 
-	return ret;
+	return run.advance;
 }
 
 
@@ -276,3 +462,32 @@ real TexFont::charAdvance(char32_t c) const{
 	auto& g = this->getGlyph(c);
 	return g.advance;
 }
+
+
+
+morda::Rectr TexFont::charBoundingBox(char32_t c)const{
+	auto& g = this->getGlyph(c);
+	return morda::Rectr(g.topLeft, g.bottomRight - g.topLeft);
+}
+
+
+
+real TexFont::kerning(char32_t left, char32_t right)const{
+	if(!FT_HAS_KERNING(this->face.f)){
+		return 0;
+	}
+	
+	FT_Vector delta;
+	if(FT_Get_Kerning(
+			this->face.f,
+			FT_Get_Char_Index(this->face.f, FT_ULong(left)),
+			FT_Get_Char_Index(this->face.f, FT_ULong(right)),
+			FT_KERNING_DEFAULT,
+			&delta
+		) != 0)
+	{
+		return 0;
+	}
+	
+	return real(delta.x) / (64.0f);
+}
@@ -5,9 +5,6 @@
 #include <stdexcept>
 #include <list>
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
 #include <kolme/Vector2.hpp>
 #include <kolme/Rectangle.hpp>
 
@@ -19,16 +16,24 @@
 #include "../render/Texture2D.hpp"
 #include "../render/VertexArray.hpp"
 
+#include "../util/RasterImage.hpp"
+
 #include "Font.hpp"
+#include "FreeType.hxx"
+#include "GlyphAtlas.hxx"
 
 
 namespace morda{
 /**
  * @brief A texture font.
- * This font implementation reads a Truetype font from 'ttf' file and renders given
- * set of characters to a texture.
+ * This font implementation reads a Truetype font from 'ttf' file and renders
+ * glyphs of the used characters to a glyph atlas texture.
  * Then, for rendering strings of text it renders
  * row of quads with texture coordinates corresponding to string characters on the texture.
+ * Glyphs are rendered on first use, or in advance, in parallel, with prewarm().
+ * Strings are shaped, i.e. glyph positions with kerning applied are calculated, once and
+ * the shaped runs of recently used strings are cached, so that rendering and measuring
+ * the same string again does not need to shape it.
  */
 class TexFont : public Font{
 	mutable std::list<char32_t> lastUsedOrder;
@@ -37,8 +42,10 @@ class TexFont : public Font{
 		morda::Vec2r topLeft;
 		morda::Vec2r bottomRight;
 		
+		//can be null for glyphs of empty characters, like space, tab etc...
 		std::shared_ptr<VertexArray> vao;
-		std::shared_ptr<Texture2D> tex;
+		size_t page;
+		std::array<kolme::Vec2f, 4> texCoords;
 		
 		real advance;
 		
@@ -49,27 +56,58 @@ class TexFont : public Font{
 	
 	
 	unsigned maxCached;
+	
+	//number of glyphs evicted from cache since the atlas was cleared, those occupy space in the atlas
+	mutable size_t numEvicted = 0;
+	
+	//number of times the atlas was cleared
+	mutable size_t atlasGeneration = 0;
+	
+	unsigned fontSize;
 
-	struct FreeTypeLibWrapper{
-		FT_Library lib;
-
-		FreeTypeLibWrapper();
-		~FreeTypeLibWrapper()noexcept;
-	} freetype;
-
-//	TRACE(<< "TexFont::Load(): FreeType library inited" << std::endl)
-
-	struct FreeTypeFaceWrapper{
-		FT_Face f;
-		std::vector<std::uint8_t> fontFile;//the buffer should be alive as long as the Face is alive!!!
-
-		FreeTypeFaceWrapper(FT_Library& lib, const papki::File& fi);
-		~FreeTypeFaceWrapper()noexcept;
-	} face;
+	FreeTypeFaceWrapper face;
+	
+	mutable GlyphAtlas atlas;
+	
+	mutable Glyph unknownGlyph;
+	
+	//glyph rendered by FreeType, not yet uploaded to the atlas
+	struct RasterizedGlyph{
+		bool isLoaded = false;
+		
+		morda::Vec2r topLeft;
+		morda::Vec2r bottomRight;
+		
+		real advance;
+		
+		//empty for glyphs of empty characters
+		RasterImage image;
+	};
+	
+	//can be called from any thread, as long as the face is only used by the calling thread
+	static RasterizedGlyph rasterizeGlyph(FT_Face face, char32_t c);
 	
-	Glyph unknownGlyph;
+	Glyph makeGlyph(const RasterizedGlyph& rg)const;
 	
 	Glyph loadGlyph(char32_t c)const;
+	
+	mutable std::list<const std::u32string*> runsLastUsedOrder;
+	
+	struct ShapedRun{
+		//horizontal positions of the glyphs
+		std::vector<real> positions;
+		
+		real advance;
+		
+		morda::Rectr boundingBox;
+		
+		decltype(runsLastUsedOrder)::iterator lastUsedIter;
+	};
+	
+	mutable std::unordered_map<std::u32string, ShapedRun> runs;
+	
+	//storage for runs which are too long to be cached
+	mutable ShapedRun uncachedRun;
 public:
 	/**
 	 * @brief Constructor.
@@ -81,6 +119,21 @@ public:
 
 	real charAdvance(char32_t c) const override;
 	
+	real kerning(char32_t left, char32_t right)const override;
+	
+	morda::Rectr charBoundingBox(char32_t c)const override;
+	
+	/**
+	 * @brief Render glyphs in advance.
+	 * Glyphs of the given characters which are not cached yet are rendered in parallel on worker threads,
+	 * each worker uses its own FreeType face over the font file loaded by this font.
+	 * Then the glyphs are added to the glyph atlas on the calling thread, which must be the UI thread.
+	 * @param chars - characters to render glyphs for.
+	 */
+	void prewarm(const std::u32string& chars)const override;
+	
+	std::unique_ptr<TextMesh> makeMesh(const std::u32string& str)const override;
+	
 protected:
 	real renderStringInternal(const morda::Matr4r& matrix, kolme::Vec4f color, const std::u32string& str)const override;
 
@@ -92,5 +145,14 @@ private:
 	real renderGlyphInternal(const morda::Matr4r& matrix, kolme::Vec4f color, char32_t ch)const;
 
 	const Glyph& getGlyph(char32_t c)const;
+	
+	const Glyph& cacheGlyph(char32_t c, Glyph&& g)const;
+	
+	//clears glyph atlas if glyphs evicted from cache waste too much of it
+	void compactAtlas()const;
+	
+	void shape(ShapedRun& run, const std::u32string& str)const;
+	
+	const ShapedRun& getRun(const std::u32string& str)const;
 };
 }
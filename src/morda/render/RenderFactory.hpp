@@ -55,6 +55,9 @@ public:
 		std::unique_ptr<ShaderColor> colorPosLum;
 		std::unique_ptr<Shader> posClr;
 		std::unique_ptr<ShaderColorTexture> colorPosTex;
+		
+		//signed distance field texture, can be null if not supported by the renderer
+		std::unique_ptr<ShaderColorTexture> colorPosTexSdf;
 	};
 	
 	virtual std::unique_ptr<Shaders> createShaders() = 0;
@@ -0,0 +1,382 @@
+#include "RenderList.hpp"
+
+#include <exception>
+
+#include "../Morda.hpp"
+
+
+using namespace morda;
+
+
+
+namespace{
+//innermost render list recording
+RenderList::Recording* current = nullptr;
+
+bool isEqual(const kolme::Matr4f& a, const kolme::Matr4f& b){
+	for(unsigned i = 0; i != 4; ++i){
+		for(unsigned j = 0; j != 4; ++j){
+			if(a[i][j] != b[i][j]){
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool isEqual(const kolme::Recti& a, const kolme::Recti& b){
+	return a.p == b.p && a.d == b.d;
+}
+}
+
+
+
+struct RenderList::ShaderProxies{
+	static void recordDraw(RenderList& list, Shader_e shader, const kolme::Matr4f& m, const VertexArray& va, const Texture2D* tex, const kolme::Vec4f& color){
+		Command c;
+		c.type = Command::Type_e::DRAW;
+		c.shader = shader;
+		c.matrix = m;
+		c.va = va.sharedFromThis(&va);
+		if(tex){
+			c.tex = tex->sharedFromThis(tex);
+		}
+		c.color = color;
+		c.clipped = !list.clips.empty();
+		if(c.clipped){
+			c.clip = list.clips.back();
+		}
+		list.add(std::move(c));
+	}
+	
+	class Texture : public ShaderTexture{
+		RenderList& list;
+		const ShaderTexture& shader;
+	public:
+		Texture(RenderList& list, const ShaderTexture& shader) :
+				list(list),
+				shader(shader)
+		{}
+		
+		void render(const kolme::Matr4f& m, const VertexArray& va, const Texture2D& tex)const override{
+			recordDraw(this->list, Shader_e::POS_TEX, m, va, &tex, kolme::Vec4f(1));
+			this->shader.render(m, va, tex);
+		}
+	};
+	
+	class Color : public ShaderColor{
+		RenderList& list;
+		const ShaderColor& shader;
+		Shader_e type;
+	public:
+		Color(RenderList& list, const ShaderColor& shader, Shader_e type) :
+				list(list),
+				shader(shader),
+				type(type)
+		{}
+		
+		void render(const kolme::Matr4f& m, const VertexArray& va, kolme::Vec4f color)const override{
+			recordDraw(this->list, this->type, m, va, nullptr, color);
+			this->shader.render(m, va, color);
+		}
+	};
+	
+	class Plain : public Shader{
+		RenderList& list;
+		const Shader& shader;
+	public:
+		Plain(RenderList& list, const Shader& shader) :
+				list(list),
+				shader(shader)
+		{}
+		
+		void render(const kolme::Matr4f& m, const VertexArray& va)const override{
+			recordDraw(this->list, Shader_e::POS_CLR, m, va, nullptr, kolme::Vec4f(1));
+			this->shader.render(m, va);
+		}
+	};
+	
+	class ColorTexture : public ShaderColorTexture{
+		RenderList& list;
+		const ShaderColorTexture& shader;
+		Shader_e type;
+	public:
+		ColorTexture(RenderList& list, const ShaderColorTexture& shader, Shader_e type) :
+				list(list),
+				shader(shader),
+				type(type)
+		{}
+		
+		void render(const kolme::Matr4f& m, const VertexArray& va, kolme::Vec4f color, const Texture2D& tex)const override{
+			recordDraw(this->list, this->type, m, va, &tex, color);
+			this->shader.render(m, va, color, tex);
+		}
+	};
+	
+	//installs recording proxies to the renderer, returns previously installed shaders
+	static std::unique_ptr<RenderFactory::Shaders> install(RenderList& list){
+		auto& s = *morda::inst().renderer().shader;
+		
+		auto ret = utki::makeUnique<RenderFactory::Shaders>();
+		
+		ret->posTex = std::move(s.posTex);
+		ret->colorPos = std::move(s.colorPos);
+		ret->colorPosLum = std::move(s.colorPosLum);
+		ret->posClr = std::move(s.posClr);
+		ret->colorPosTex = std::move(s.colorPosTex);
+		ret->colorPosTexSdf = std::move(s.colorPosTexSdf);
+		
+		if(ret->posTex){
+			s.posTex = utki::makeUnique<Texture>(list, *ret->posTex);
+		}
+		if(ret->colorPos){
+			s.colorPos = utki::makeUnique<Color>(list, *ret->colorPos, Shader_e::COLOR_POS);
+		}
+		if(ret->colorPosLum){
+			s.colorPosLum = utki::makeUnique<Color>(list, *ret->colorPosLum, Shader_e::COLOR_POS_LUM);
+		}
+		if(ret->posClr){
+			s.posClr = utki::makeUnique<Plain>(list, *ret->posClr);
+		}
+		if(ret->colorPosTex){
+			s.colorPosTex = utki::makeUnique<ColorTexture>(list, *ret->colorPosTex, Shader_e::COLOR_POS_TEX);
+		}
+		if(ret->colorPosTexSdf){
+			s.colorPosTexSdf = utki::makeUnique<ColorTexture>(list, *ret->colorPosTexSdf, Shader_e::COLOR_POS_TEX_SDF);
+		}
+		
+		return ret;
+	}
+	
+	//swaps shaders installed to renderer with the given ones
+	static void swap(RenderFactory::Shaders& shaders)noexcept{
+		auto& s = *morda::inst().renderer().shader;
+		
+		std::swap(s.posTex, shaders.posTex);
+		std::swap(s.colorPos, shaders.colorPos);
+		std::swap(s.colorPosLum, shaders.colorPosLum);
+		std::swap(s.posClr, shaders.posClr);
+		std::swap(s.colorPosTex, shaders.colorPosTex);
+		std::swap(s.colorPosTexSdf, shaders.colorPosTexSdf);
+	}
+};
+
+
+
+void RenderList::add(Command&& c){
+	this->commands.push_back(std::move(c));
+}
+
+
+
+void RenderList::clear()noexcept{
+	this->commands.clear();
+	this->clips.clear();
+	this->isRecorded = false;
+}
+
+
+
+bool RenderList::isValidFor(const kolme::Matr4f& matrix)const{
+	if(!this->isRecorded){
+		return false;
+	}
+	
+	if(!isEqual(this->matrix, matrix)){
+		return false;
+	}
+	
+	auto& r = morda::inst().renderer();
+	
+	//scissor state does not matter, recorded clipping is applied relatively to the current scissor rectangle
+	return isEqual(r.getViewport(), this->viewport);
+}
+
+
+
+void RenderList::replay()const{
+	auto& r = morda::inst().renderer();
+	auto& s = *r.shader;
+	
+	bool scissorEnabled = r.isScissorEnabled();
+	kolme::Recti scissor;
+	if(scissorEnabled){
+		scissor = r.getScissorRect();
+	}
+	
+	bool curScissorEnabled = scissorEnabled;
+	kolme::Recti curScissor = scissor;
+	
+	for(auto& c : this->commands){
+		switch(c.type){
+			case Command::Type_e::DRAW:
+				{
+					bool e = scissorEnabled;
+					kolme::Recti s = scissor;
+					if(c.clipped){
+						s = c.clip;
+						if(e){
+							s.intersect(scissor);
+						}
+						e = true;
+					}
+					if(e != curScissorEnabled){
+						r.setScissorEnabled(e);
+						curScissorEnabled = e;
+					}
+					if(e && !isEqual(s, curScissor)){
+						r.setScissorRect(s);
+						curScissor = s;
+					}
+				}
+				switch(c.shader){
+					case Shader_e::POS_TEX:
+						s.posTex->render(c.matrix, *c.va, *c.tex);
+						break;
+					case Shader_e::COLOR_POS:
+						s.colorPos->render(c.matrix, *c.va, c.color);
+						break;
+					case Shader_e::COLOR_POS_LUM:
+						s.colorPosLum->render(c.matrix, *c.va, c.color);
+						break;
+					case Shader_e::POS_CLR:
+						s.posClr->render(c.matrix, *c.va);
+						break;
+					case Shader_e::COLOR_POS_TEX:
+						s.colorPosTex->render(c.matrix, *c.va, c.color, *c.tex);
+						break;
+					case Shader_e::COLOR_POS_TEX_SDF:
+						s.colorPosTexSdf->render(c.matrix, *c.va, c.color, *c.tex);
+						break;
+				}
+				break;
+			case Command::Type_e::BLEND_ENABLE:
+				r.setBlendEnabled(c.blendEnabled);
+				recordBlendEnabled(c.blendEnabled);
+				break;
+			case Command::Type_e::BLEND_FUNC:
+				r.setBlendFunc(c.blendFactors[0], c.blendFactors[1], c.blendFactors[2], c.blendFactors[3]);
+				recordBlendFunc(c.blendFactors[0], c.blendFactors[1], c.blendFactors[2], c.blendFactors[3]);
+				break;
+		}
+	}
+	
+	if(curScissorEnabled != scissorEnabled){
+		r.setScissorEnabled(scissorEnabled);
+	}
+	if(scissorEnabled && !isEqual(curScissor, scissor)){
+		r.setScissorRect(scissor);
+	}
+}
+
+
+
+void RenderList::recordBlendEnabled(bool enabled){
+	for(auto rec = current; rec; rec = rec->prev){
+		Command c;
+		c.type = Command::Type_e::BLEND_ENABLE;
+		c.blendEnabled = enabled;
+		rec->list.add(std::move(c));
+	}
+}
+
+
+
+void RenderList::recordBlendFunc(Renderer::BlendFactor_e srcClr, Renderer::BlendFactor_e dstClr, Renderer::BlendFactor_e srcAlpha, Renderer::BlendFactor_e dstAlpha){
+	for(auto rec = current; rec; rec = rec->prev){
+		Command c;
+		c.type = Command::Type_e::BLEND_FUNC;
+		c.blendFactors[0] = srcClr;
+		c.blendFactors[1] = dstClr;
+		c.blendFactors[2] = srcAlpha;
+		c.blendFactors[3] = dstAlpha;
+		rec->list.add(std::move(c));
+	}
+}
+
+
+
+void RenderList::recordClip(const kolme::Recti& rect){
+	for(auto rec = current; rec; rec = rec->prev){
+		auto& clips = rec->list.clips;
+		kolme::Recti r = rect;
+		if(!clips.empty()){
+			r.intersect(clips.back());
+		}
+		clips.push_back(r);
+	}
+}
+
+
+
+void RenderList::recordUnclip()noexcept{
+	for(auto rec = current; rec; rec = rec->prev){
+		ASSERT(!rec->list.clips.empty())
+		rec->list.clips.pop_back();
+	}
+}
+
+
+
+RenderList::Recording::Recording(RenderList& list, const kolme::Matr4f& matrix) :
+		list(list),
+		prev(current)
+{
+	auto& r = morda::inst().renderer();
+	
+	this->list.clear();
+	this->list.matrix = matrix;
+	this->list.viewport = r.getViewport();
+	
+	this->saved = ShaderProxies::install(this->list);
+	
+	current = this;
+}
+
+
+
+RenderList::Recording::~Recording()noexcept{
+	ASSERT(current == this)
+	
+	ShaderProxies::swap(*this->saved);
+	
+	current = this->prev;
+	
+	//list recorded partially is not valid
+	this->list.isRecorded = !std::uncaught_exception();
+}
+
+
+
+RenderList::Pause::Pause()noexcept :
+		paused(current)
+{
+	if(!this->paused){
+		return;
+	}
+	
+	//outermost recording holds the real shaders
+	auto outermost = this->paused;
+	for(; outermost->prev; outermost = outermost->prev){}
+	
+	ShaderProxies::swap(*outermost->saved);
+	
+	current = nullptr;
+}
+
+
+
+RenderList::Pause::~Pause()noexcept{
+	if(!this->paused){
+		return;
+	}
+	
+	ASSERT(!current)
+	
+	auto outermost = this->paused;
+	for(; outermost->prev; outermost = outermost->prev){}
+	
+	ShaderProxies::swap(*outermost->saved);
+	
+	current = this->paused;
+}
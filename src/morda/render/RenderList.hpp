@@ -0,0 +1,192 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include <kolme/Matrix4.hpp>
+#include <kolme/Vector4.hpp>
+#include <kolme/Rectangle.hpp>
+
+#include "Renderer.hpp"
+
+namespace morda{
+
+/**
+ * @brief Retained list of rendering commands.
+ * Render list records draw calls issued through the renderer's shaders, as well as
+ * changes of blending state and clipping, so that those can be replayed later without
+ * traversing the widget hierarchy and re-computing matrices.
+ * Clipping is recorded relatively to the scissor state the list was recorded within,
+ * so the list can be replayed within a different scissor rectangle, e.g. for another damaged region.
+ * Recorded draw calls hold references to vertex arrays and textures they use.
+ */
+class RenderList{
+public:
+	/**
+	 * @brief Shader used by a draw command.
+	 */
+	enum class Shader_e{
+		POS_TEX,
+		COLOR_POS,
+		COLOR_POS_LUM,
+		POS_CLR,
+		COLOR_POS_TEX,
+		COLOR_POS_TEX_SDF
+	};
+
+private:
+	struct Command{
+		enum class Type_e{
+			DRAW,
+			BLEND_ENABLE,
+			BLEND_FUNC
+		} type;
+		
+		//for DRAW
+		Shader_e shader;
+		kolme::Matr4f matrix;
+		std::shared_ptr<const VertexArray> va;
+		std::shared_ptr<const Texture2D> tex;
+		kolme::Vec4f color;
+		
+		//whether the draw call was clipped by the recorded content itself
+		bool clipped;
+		
+		//clipping rectangle, not intersected with the scissor rectangle the list was recorded within
+		kolme::Recti clip;
+		
+		//for BLEND_ENABLE
+		bool blendEnabled;
+		
+		//for BLEND_FUNC
+		Renderer::BlendFactor_e blendFactors[4];
+	};
+	
+	std::vector<Command> commands;
+	
+	//state the list was recorded with
+	kolme::Matr4f matrix;
+	kolme::Recti viewport;
+	
+	//stack of clipping rectangles while recording, each one is intersected with the previous ones
+	std::vector<kolme::Recti> clips;
+	
+	bool isRecorded = false;
+	
+	void add(Command&& c);
+
+public:
+	RenderList() = default;
+	
+	RenderList(const RenderList&) = delete;
+	RenderList& operator=(const RenderList&) = delete;
+	
+	/**
+	 * @brief Clear the list.
+	 */
+	void clear()noexcept;
+	
+	/**
+	 * @brief Check if the list can be replayed.
+	 * The list can be replayed if it was recorded with the same transformation matrix
+	 * and same viewport as the current ones. Current scissor state does not matter.
+	 * @param matrix - transformation matrix to replay the list with.
+	 * @return true if the list can be replayed.
+	 * @return false if the list needs to be recorded again.
+	 */
+	bool isValidFor(const kolme::Matr4f& matrix)const;
+	
+	/**
+	 * @brief Replay the recorded commands.
+	 * Recorded clipping is intersected with the current scissor rectangle, if scissor test is enabled.
+	 * Scissor state is restored after replaying, blending state is left as after the last recorded command,
+	 * same as it would be after rendering normally.
+	 */
+	void replay()const;
+	
+	/**
+	 * @brief Get number of recorded commands.
+	 * @return Number of recorded commands.
+	 */
+	size_t size()const noexcept{
+		return this->commands.size();
+	}
+	
+	/**
+	 * @brief Notify about enabling or disabling the blending.
+	 * Code which changes the blending state should call this function after doing that,
+	 * so that the change is recorded to the render list being recorded, if any.
+	 * @param enabled - whether blending was enabled or disabled.
+	 */
+	static void recordBlendEnabled(bool enabled);
+	
+	/**
+	 * @brief Notify about changing the blending function.
+	 * Code which changes the blending function should call this function after doing that,
+	 * so that the change is recorded to the render list being recorded, if any.
+	 */
+	static void recordBlendFunc(Renderer::BlendFactor_e srcClr, Renderer::BlendFactor_e dstClr, Renderer::BlendFactor_e srcAlpha, Renderer::BlendFactor_e dstAlpha);
+	
+	/**
+	 * @brief Notify about clipping the rendering.
+	 * Code which clips rendering using the scissor test should call this function before rendering the clipped content,
+	 * so that the clipping is recorded to the render list being recorded, if any.
+	 * Each call has to be matched by a call to recordUnclip() after rendering the clipped content.
+	 * @param rect - clipping rectangle in framebuffer coordinates, not intersected with the current scissor rectangle.
+	 */
+	static void recordClip(const kolme::Recti& rect);
+	
+	/**
+	 * @brief Notify about the end of clipping started by recordClip().
+	 */
+	static void recordUnclip()noexcept;
+	
+	/**
+	 * @brief Record render list while in scope.
+	 * While the object of this class exists, all draw calls done through the renderer's shaders
+	 * are performed as usual and also recorded to the render list.
+	 * Recordings can be nested, in that case draw calls are recorded to all the lists being recorded.
+	 */
+	class Recording{
+		friend class RenderList;
+		
+		RenderList& list;
+		Recording* prev;
+		
+		//shaders which were installed to renderer before recording started
+		std::unique_ptr<RenderFactory::Shaders> saved;
+	public:
+		/**
+		 * @brief Constructor.
+		 * Clears the list and starts recording.
+		 * @param list - render list to record.
+		 * @param matrix - transformation matrix the list is recorded with.
+		 */
+		Recording(RenderList& list, const kolme::Matr4f& matrix);
+		
+		Recording(const Recording&) = delete;
+		Recording& operator=(const Recording&) = delete;
+		
+		~Recording()noexcept;
+	};
+	
+	/**
+	 * @brief Suspend recording while in scope.
+	 * Rendering to texture, for example, should not be recorded.
+	 */
+	class Pause{
+		Recording* paused;
+	public:
+		Pause()noexcept;
+		
+		Pause(const Pause&) = delete;
+		Pause& operator=(const Pause&) = delete;
+		
+		~Pause()noexcept;
+	};
+
+private:
+	struct ShaderProxies;
+};
+	
+}
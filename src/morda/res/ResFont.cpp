@@ -7,6 +7,9 @@
 #include "../util/util.hpp"
 
 #include "../fonts/TexFont.hxx"
+#include "../fonts/SdfFont.hxx"
+
+#include <map>
 
 #include <unikod/utf8.hpp>
 
@@ -20,6 +23,65 @@ ResFont::ResFont(const papki::File& fi, unsigned fontSize, unsigned maxCached) :
 
 
 
+ResFont::ResFont(std::unique_ptr<morda::Font> font) :
+		f(std::move(font))
+{
+	ASSERT(this->f)
+}
+
+
+
+namespace{
+//faces of sdf fonts, shared by fonts of all sizes loaded from the same file,
+//font file is alive as long as the face is alive, so the key cannot refer to another file
+std::map<const FontFile*, std::weak_ptr<SdfFace>> sdfFaces;
+
+//parses character range in form of "<first>-<last>" or "<char>", character codes are hexadecimal
+void appendRange(std::u32string& chars, const std::string& range){
+	auto dash = range.find('-');
+	
+	char32_t first, last;
+	try{
+		first = char32_t(std::stoul(range.substr(0, dash), nullptr, 16));
+		last = dash == std::string::npos ? first : char32_t(std::stoul(range.substr(dash + 1), nullptr, 16));
+	}catch(std::logic_error&){
+		throw morda::Exc(std::string("ResFont::load(): malformed character range in 'prewarm': ") + range);
+	}
+	
+	if(last < first){
+		throw morda::Exc(std::string("ResFont::load(): empty character range in 'prewarm': ") + range);
+	}
+	
+	for(char32_t c = first; c <= last; ++c){
+		chars.push_back(c);
+	}
+}
+
+std::shared_ptr<SdfFace> getSdfFace(const papki::File& fi){
+	auto fontFile = FontFile::load(fi);
+	
+	auto& p = sdfFaces[fontFile.get()];
+	if(auto ret = p.lock()){
+		return ret;
+	}
+	
+	//drop entries of the faces which are not used anymore
+	for(auto i = sdfFaces.begin(); i != sdfFaces.end();){
+		if(&i->second != &p && i->second.expired()){
+			i = sdfFaces.erase(i);
+		}else{
+			++i;
+		}
+	}
+	
+	auto ret = std::make_shared<SdfFace>(std::move(fontFile));
+	p = ret;
+	return ret;
+}
+}
+
+
+
 std::shared_ptr<ResFont> ResFont::load(const stob::Node& chain, const papki::File& fi){
 	//read size attribute
 	unsigned fontSize;
@@ -36,6 +98,33 @@ std::shared_ptr<ResFont> ResFont::load(const stob::Node& chain, const papki::Fil
 		maxCached = p->up().asUint32();
 	}
 
-	return std::make_shared<ResFont>(fi, fontSize, maxCached);
+	std::shared_ptr<ResFont> ret;
+	
+	if(auto p = chain.thisOrNext("type").node()){
+		std::string type = p->up().value();
+		if(type == "sdf"){
+			if(morda::inst().renderer().shader->colorPosTexSdf){
+				ret = std::make_shared<ResFont>(utki::makeUnique<SdfFont>(getSdfFace(fi), fontSize));
+			}else{
+				TRACE(<< "ResFont::load(): renderer does not support sdf fonts, loading texture font instead" << std::endl)
+			}
+		}else if(type != "texture"){
+			throw morda::Exc("ResFont::load(): unknown font type");
+		}
+	}
+
+	if(!ret){
+		ret = std::make_shared<ResFont>(fi, fontSize, maxCached);
+	}
+	
+	if(auto p = chain.thisOrNext("prewarm").node()){
+		std::u32string chars;
+		for(auto r = p->child(); r; r = r->next()){
+			appendRange(chars, r->value());
+		}
+		ret->font().prewarm(chars);
+	}
+	
+	return ret;
 }
 
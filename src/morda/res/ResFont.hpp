@@ -22,12 +22,19 @@ namespace morda{
  * @param chars - list of all chars for which the glyphs should be created.
  * @param size - size of glyphs, in length units, i.e.: no unit(pixels), dp, mm.
  * @param outline - thickness of the outline in length units.
+ * @param type - type of the font, 'texture' (default) or 'sdf'. Signed distance field (sdf) fonts
+ *               of all sizes loaded from the same file share the glyphs, and stay sharp when scaled.
+ *               If renderer does not support sdf fonts, texture font is loaded instead.
+ * @param prewarm - list of character ranges to prepare glyphs for when the font is loaded.
+ *                  Each range is given as hexadecimal codes of first and last characters separated by '-',
+ *                  or as a single hexadecimal character code.
  * 
  * Example:
  * @code
  * fnt_normal{
  *     file {Vera.ttf}
  *     size {12dp}
+ *     prewarm {20-7e 400-4ff}
  * }
  * @endcode
  */
@@ -38,6 +45,8 @@ class ResFont : public morda::Resource{
 
 public:
 	ResFont(const papki::File& fi, unsigned fontSize, unsigned maxCached);
+	
+	ResFont(std::unique_ptr<morda::Font> font);
 
 	~ResFont()noexcept{}
 
@@ -44,29 +44,53 @@ public:
 	{}
 	
 	
-	class ImageMatrix :	virtual public utki::Shared{
-		const std::array<std::array<std::shared_ptr<const ResImage>, 3>, 3> images_v;
+	/**
+	 * @brief Nine-patch image rasterized for particular border widths.
+	 * Holds the raster texture of the whole nine-patch image and the widths of the nine-patch borders on that texture.
+	 */
+	class ScaledImage : virtual public utki::Shared{
+		const std::shared_ptr<const ResImage::QuadTexture> tex_v;
+		
+		const Sidesr borders_v;
 		
 		std::weak_ptr<const ResNinePatch> parent;
 	
 		real mul;//for erasing from the cache
 	public:
-		decltype(images_v)& images()const noexcept{
-			return this->images_v;
+		/**
+		 * @brief Get raster texture.
+		 * @return Texture of the whole nine-patch image.
+		 */
+		const ResImage::QuadTexture& tex()const noexcept{
+			return *this->tex_v;
+		}
+		
+		/**
+		 * @brief Get borders.
+		 * @return Widths of the borders on the texture, in pixels.
+		 */
+		const Sidesr& borders()const noexcept{
+			return this->borders_v;
 		}
 		
-		ImageMatrix(std::array<std::array<std::shared_ptr<const ResImage>, 3>, 3>&& l, std::shared_ptr<const ResNinePatch> parent, real mul);
+		ScaledImage(std::shared_ptr<const ResImage::QuadTexture> tex, Sidesr borders, std::shared_ptr<const ResNinePatch> parent, real mul);
 		
-		~ImageMatrix()noexcept;
+		~ScaledImage()noexcept;
 	};
 	
-	std::shared_ptr<ImageMatrix> get(Sidesr borders)const;
+	/**
+	 * @brief Get nine-patch image rasterized for given border widths.
+	 * The image is rasterized so that its borders are not smaller than the requested ones.
+	 * @param borders - requested border widths, in pixels. Negative values are ignored.
+	 * @return Rasterized nine-patch image.
+	 */
+	std::shared_ptr<ScaledImage> get(Sidesr borders)const;
 	
 	const decltype(borders_v)& borders()const noexcept{
 		return this->borders_v;
 	}
 private:
-	mutable std::map<real, std::weak_ptr<ImageMatrix>> cache;
+	mutable std::map<real, std::weak_ptr<ScaledImage>> cache;
 	
 	static std::shared_ptr<ResNinePatch> load(const stob::Node& chain, const papki::File& fi);
 };
@@ -0,0 +1,353 @@
+#include "ParagraphLayout.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <utki/debug.hpp>
+
+
+using namespace morda;
+
+
+
+namespace{
+//number of line layouts for different widths to keep
+const size_t maxCachedLayouts_c = 4;
+
+enum class BreakClass_e{
+	OTHER,
+	SPACE,
+	NEWLINE,
+	CARRIAGE_RETURN,
+	ZERO_WIDTH_SPACE,
+	GLUE,
+	HYPHEN,
+	OPEN,
+	CLOSE,
+	IDEOGRAPHIC,
+	DIGIT
+};
+
+BreakClass_e breakClass(char32_t c){
+	switch(c){
+		case U' ':
+		case U'\t':
+		case 0x3000://ideographic space
+			return BreakClass_e::SPACE;
+		case U'\n':
+		case 0xb://vertical tab
+		case 0xc://form feed
+		case 0x85://next line
+		case 0x2028://line separator
+		case 0x2029://paragraph separator
+			return BreakClass_e::NEWLINE;
+		case U'\r':
+			return BreakClass_e::CARRIAGE_RETURN;
+		case 0x200b:
+			return BreakClass_e::ZERO_WIDTH_SPACE;
+		case 0xa0://no-break space
+		case 0x2007://figure space
+		case 0x202f://narrow no-break space
+		case 0x2060://word joiner
+		case 0xfeff://zero width no-break space
+			return BreakClass_e::GLUE;
+		case U'-':
+		case 0xad://soft hyphen
+		case 0x2010://hyphen
+		case 0x2012://figure dash
+		case 0x2013://en dash
+			return BreakClass_e::HYPHEN;
+		case U'(':
+		case U'[':
+		case U'{':
+		case 0x3008:
+		case 0x300a:
+		case 0x300c:
+		case 0x300e:
+		case 0x3010:
+		case 0xff08:
+			return BreakClass_e::OPEN;
+		case U')':
+		case U']':
+		case U'}':
+		case U',':
+		case U'.':
+		case U';':
+		case U':':
+		case U'!':
+		case U'?':
+		case 0x3001://ideographic comma
+		case 0x3002://ideographic full stop
+		case 0x3009:
+		case 0x300b:
+		case 0x300d:
+		case 0x300f:
+		case 0x3011:
+		case 0xff09:
+		case 0xff0c:
+		case 0xff0e:
+		case 0xff01:
+		case 0xff1f:
+			return BreakClass_e::CLOSE;
+		default:
+			break;
+	}
+	
+	if(U'0' <= c && c <= U'9'){
+		return BreakClass_e::DIGIT;
+	}
+	
+	if(
+			(0x2e80 <= c && c <= 0x9fff) || //CJK radicals, kana, CJK ideographs
+			(0xac00 <= c && c <= 0xd7af) || //Hangul syllables
+			(0xf900 <= c && c <= 0xfaff) || //CJK compatibility ideographs
+			(0xff00 <= c && c <= 0xffef) || //full width forms
+			(0x20000 <= c && c <= 0x2fffd) //CJK ideographs extensions
+		)
+	{
+		return BreakClass_e::IDEOGRAPHIC;
+	}
+	
+	return BreakClass_e::OTHER;
+}
+
+bool isNewline(BreakClass_e c){
+	return c == BreakClass_e::NEWLINE || c == BreakClass_e::CARRIAGE_RETURN;
+}
+
+//break opportunity between two characters
+enum class Break_e{
+	PROHIBITED,
+	ALLOWED,
+	MANDATORY
+};
+
+Break_e breakBetween(BreakClass_e a, BreakClass_e b){
+	if(a == BreakClass_e::CARRIAGE_RETURN && b == BreakClass_e::NEWLINE){
+		return Break_e::PROHIBITED;
+	}
+	if(isNewline(a)){
+		return Break_e::MANDATORY;
+	}
+	
+	//spaces and newlines stay at the end of the line
+	if(b == BreakClass_e::SPACE || isNewline(b)){
+		return Break_e::PROHIBITED;
+	}
+	
+	if(a == BreakClass_e::ZERO_WIDTH_SPACE){
+		return Break_e::ALLOWED;
+	}
+	
+	if(a == BreakClass_e::GLUE || b == BreakClass_e::GLUE){
+		return Break_e::PROHIBITED;
+	}
+	
+	if(b == BreakClass_e::CLOSE || b == BreakClass_e::ZERO_WIDTH_SPACE || a == BreakClass_e::OPEN){
+		return Break_e::PROHIBITED;
+	}
+	
+	if(a == BreakClass_e::SPACE){
+		return Break_e::ALLOWED;
+	}
+	
+	if(a == BreakClass_e::HYPHEN){
+		//do not separate minus sign from the number
+		return b == BreakClass_e::DIGIT ? Break_e::PROHIBITED : Break_e::ALLOWED;
+	}
+	
+	if(a == BreakClass_e::IDEOGRAPHIC || b == BreakClass_e::IDEOGRAPHIC){
+		return Break_e::ALLOWED;
+	}
+	
+	return Break_e::PROHIBITED;
+}
+}
+
+
+
+void ParagraphLayout::analyze(const TextStorage& text, const Font& font)const{
+	this->segments.clear();
+	this->layouts.clear();
+	this->font = &font;
+	
+	Segment s;
+	s.contentEnd = 0;
+	s.contentAdvance = 0;
+	s.advance = 0;
+	s.kerning = 0;
+	
+	char32_t prev = 0;
+	BreakClass_e prevClass = BreakClass_e::OTHER;
+	
+	size_t i = 0;
+	for(auto iter = text.begin(); iter != text.end(); ++iter, ++i){
+		char32_t c = *iter;
+		BreakClass_e cls = breakClass(c);
+		
+		real kerning = 0;
+		
+		if(i != 0){
+			kerning = font.kerning(prev, c);
+			
+			auto br = breakBetween(prevClass, cls);
+			if(br != Break_e::PROHIBITED){
+				s.end = i;
+				s.mandatoryBreak = br == Break_e::MANDATORY;
+				this->segments.push_back(s);
+				
+				s.contentEnd = i;
+				s.contentAdvance = 0;
+				s.advance = 0;
+				s.kerning = br == Break_e::MANDATORY ? 0 : kerning;
+				kerning = 0;
+			}
+		}
+		
+		if(isNewline(cls)){
+			//newline characters are not visible
+		}else{
+			s.advance += kerning + font.charAdvance(c);
+			if(cls != BreakClass_e::SPACE){
+				s.contentEnd = i + 1;
+				s.contentAdvance = s.advance;
+			}
+		}
+		
+		prev = c;
+		prevClass = cls;
+	}
+	
+	s.end = i;
+	s.mandatoryBreak = i != 0 && isNewline(prevClass);
+	this->segments.push_back(s);
+}
+
+
+
+void ParagraphLayout::fit(std::vector<Line>& lines, const TextStorage& text, real width)const{
+	ASSERT(this->font)
+	
+	lines.clear();
+	
+	size_t lineBegin = 0;
+	size_t lineEnd = 0;
+	real lineWidth = 0;
+	
+	//advance of the line including trailing spaces
+	real x = 0;
+	
+	bool lineEmpty = true;
+	
+	for(size_t k = 0; k != this->segments.size(); ++k){
+		auto& s = this->segments[k];
+		size_t start = k == 0 ? 0 : this->segments[k - 1].end;
+		
+		if(!lineEmpty && x + s.kerning + s.contentAdvance > width){
+			lines.emplace_back(lineBegin, lineEnd, lineWidth);
+			lineBegin = start;
+			lineEnd = start;
+			lineWidth = 0;
+			x = 0;
+			lineEmpty = true;
+		}
+		
+		if(lineEmpty && s.contentAdvance > width){
+			//segment does not fit even to the empty line, break it between characters
+			auto& font = *this->font;
+			char32_t prev = 0;
+			real cx = 0;
+			auto iter = text.iteratorAt(start);
+			for(size_t i = start; i != s.contentEnd; ++i, ++iter){
+				char32_t c = *iter;
+				real kerning = i == lineBegin ? 0 : font.kerning(prev, c);
+				real advance = font.charAdvance(c);
+				if(i != lineBegin && cx + kerning + advance > width){
+					lines.emplace_back(lineBegin, i, cx);
+					lineBegin = i;
+					cx = 0;
+					kerning = 0;
+				}
+				cx += kerning + advance;
+				prev = c;
+			}
+			lineEnd = s.contentEnd;
+			lineWidth = cx;
+			x = cx + s.advance - s.contentAdvance;
+		}else{
+			real kerning = lineEmpty ? 0 : s.kerning;
+			if(s.contentEnd != start){
+				lineEnd = s.contentEnd;
+				lineWidth = x + kerning + s.contentAdvance;
+			}
+			x += kerning + s.advance;
+		}
+		lineEmpty = false;
+		
+		if(s.mandatoryBreak){
+			lines.emplace_back(lineBegin, lineEnd, lineWidth);
+			lineBegin = s.end;
+			lineEnd = s.end;
+			lineWidth = 0;
+			x = 0;
+			lineEmpty = true;
+		}
+	}
+	
+	//text ending with newline has an empty last line
+	if(!lineEmpty || lines.empty() || this->segments.back().mandatoryBreak){
+		lines.emplace_back(lineBegin, lineEnd, lineWidth);
+	}
+}
+
+
+
+const std::vector<ParagraphLayout::Line>& ParagraphLayout::lines(const TextStorage& text, const Font& font, real width)const{
+	if(this->font != &font){
+		this->analyze(text, font);
+	}
+	
+	for(auto i = this->layouts.begin(); i != this->layouts.end(); ++i){
+		if(i->first == width){
+			std::rotate(this->layouts.begin(), i, i + 1);
+			return this->layouts.front().second;
+		}
+	}
+	
+	if(this->layouts.size() == maxCachedLayouts_c){
+		this->layouts.pop_back();
+	}
+	
+	this->layouts.insert(this->layouts.begin(), std::make_pair(width, std::vector<Line>()));
+	
+	auto& ret = this->layouts.front().second;
+	this->fit(ret, text, width);
+	
+	return ret;
+}
+
+
+
+real ParagraphLayout::naturalWidth(const TextStorage& text, const Font& font)const{
+	real ret = 0;
+	for(auto& l : this->lines(text, font, std::numeric_limits<real>::max())){
+		using std::max;
+		ret = max(ret, l.width);
+	}
+	return ret;
+}
+
+
+
+real ParagraphLayout::lineOffset(const Line& line, real width, Align_e align)noexcept{
+	switch(align){
+		default:
+		case Align_e::LEFT:
+			return 0;
+		case Align_e::CENTER:
+			return std::round((width - line.width) / 2);
+		case Align_e::RIGHT:
+			return width - line.width;
+	}
+}
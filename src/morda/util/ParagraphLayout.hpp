@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+
+#include "../config.hpp"
+
+#include "../fonts/Font.hpp"
+
+#include "TextStorage.hpp"
+
+
+namespace morda{
+
+/**
+ * @brief Layout of a paragraph of text wrapped to a given width.
+ * The text is split to segments between line break opportunities, roughly following
+ * the Unicode line breaking algorithm (UAX #14): lines can be broken after spaces and hyphens,
+ * around ideographic characters and after newline characters, where the break is mandatory.
+ * Lines are filled with segments greedily.
+ * Advances of the segments are measured once per text and font, so wrapping the same text to
+ * a different width only needs to fit the segments to lines without measuring the text again.
+ * Line layouts for a few recently used widths are cached as well.
+ */
+class ParagraphLayout{
+public:
+	/**
+	 * @brief Horizontal alignment of lines.
+	 */
+	enum class Align_e{
+		LEFT,
+		CENTER,
+		RIGHT
+	};
+	
+	/**
+	 * @brief Line of the paragraph.
+	 */
+	struct Line{
+		//index of the first character of the line
+		size_t begin;
+		
+		//index after the last visible character of the line, trailing spaces and newline characters are not included
+		size_t end;
+		
+		//advance of the visible characters of the line
+		real width;
+		
+		Line(size_t begin, size_t end, real width) :
+				begin(begin),
+				end(end),
+				width(width)
+		{}
+	};
+	
+private:
+	struct Segment{
+		//index after the last character of the segment, segment starts where previous one ends
+		size_t end;
+		
+		//index after the last character of the segment which is not a space or newline
+		size_t contentEnd;
+		
+		//advance of the characters before contentEnd
+		real contentAdvance;
+		
+		//advance of all the characters of the segment
+		real advance;
+		
+		//kerning between the last character of previous segment and the first character of this segment
+		real kerning;
+		
+		//whether the line has to be broken after this segment
+		bool mandatoryBreak;
+	};
+	
+	mutable std::vector<Segment> segments;
+	
+	//font the segments were measured with
+	mutable const Font* font = nullptr;
+	
+	//recently used line layouts, most recently used first
+	mutable std::vector<std::pair<real, std::vector<Line>>> layouts;
+	
+	void analyze(const TextStorage& text, const Font& font)const;
+	
+	void fit(std::vector<Line>& lines, const TextStorage& text, real width)const;
+	
+public:
+	ParagraphLayout() = default;
+	
+	ParagraphLayout(const ParagraphLayout&) = delete;
+	ParagraphLayout& operator=(const ParagraphLayout&) = delete;
+	
+	/**
+	 * @brief Get lines of the text wrapped to given width.
+	 * Text is measured only if it was not measured with the given font before.
+	 * Fonts are told apart by address, so invalidate() must be called when the font object is replaced.
+	 * @param text - text to lay out. Must be the same text as in previous calls, unless invalidate() was called.
+	 * @param font - font to measure the text with.
+	 * @param width - width to wrap the text to.
+	 * @return Lines of the text. There is always at least one line.
+	 */
+	const std::vector<Line>& lines(const TextStorage& text, const Font& font, real width)const;
+	
+	/**
+	 * @brief Get width of the text which is not wrapped.
+	 * @param text - text to lay out.
+	 * @param font - font to measure the text with.
+	 * @return Width of the longest line of the text, when the lines are only broken at newline characters.
+	 */
+	real naturalWidth(const TextStorage& text, const Font& font)const;
+	
+	/**
+	 * @brief Drop cached measurements.
+	 * Must be called when the text or the font is changed.
+	 */
+	void invalidate()noexcept{
+		this->font = nullptr;
+		this->layouts.clear();
+	}
+	
+	/**
+	 * @brief Get horizontal position of the line.
+	 * @param line - line to get position of.
+	 * @param width - width the text is laid out to.
+	 * @param align - alignment of the line.
+	 * @return Horizontal position of the first character of the line.
+	 */
+	static real lineOffset(const Line& line, real width, Align_e align)noexcept;
+};
+
+}
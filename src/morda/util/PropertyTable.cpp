@@ -0,0 +1,99 @@
+#include "PropertyTable.hpp"
+
+#include <cstring>
+
+#include <utki/debug.hpp>
+
+
+using namespace morda;
+
+
+namespace{
+//property table of the widget which is currently being constructed
+const PropertyTable* current = nullptr;
+}
+
+
+
+PropertyTable::PropertyTable(const stob::Node* chain) :
+		chain_v(chain)
+{
+	size_t numProps = 0;
+	for(auto n = chain; n; n = n->next()){
+		if(n->isProperty()){
+			++numProps;
+		}
+	}
+	
+	//keep load factor not greater than 0.5
+	size_t size = 8;
+	while(size < numProps * 2){
+		size *= 2;
+	}
+	
+	this->entries.resize(size, Entry{0, nullptr});
+	
+	for(auto n = chain; n; n = n->next()){
+		if(!n->isProperty() || !n->value()){
+			continue;
+		}
+		
+		auto h = propertyHash(n->value());
+		
+		for(size_t i = h & (size - 1);; i = (i + 1) & (size - 1)){
+			auto& e = this->entries[i];
+			if(!e.property){
+				e.hash = h;
+				e.property = n;
+				break;
+			}
+			if(e.hash == h && std::strcmp(e.property->value(), n->value()) == 0){
+				//first occurrence of the property wins
+				break;
+			}
+		}
+	}
+}
+
+
+
+const stob::Node* PropertyTable::find(const char* name)const noexcept{
+	ASSERT(name)
+	
+	auto h = propertyHash(name);
+	
+	size_t mask = this->entries.size() - 1;
+	
+	for(size_t i = h & mask;; i = (i + 1) & mask){
+		auto& e = this->entries[i];
+		if(!e.property){
+			return nullptr;
+		}
+		if(e.hash == h && std::strcmp(e.property->value(), name) == 0){
+			return e.property;
+		}
+	}
+}
+
+
+
+const PropertyTable* PropertyTable::of(const stob::Node* chain)noexcept{
+	if(current && current->chain() == chain){
+		return current;
+	}
+	return nullptr;
+}
+
+
+
+PropertyTable::Scope::Scope(const PropertyTable& table)noexcept :
+		prev(current)
+{
+	current = &table;
+}
+
+
+
+PropertyTable::Scope::~Scope()noexcept{
+	current = this->prev;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <stob/dom.hpp>
+
+
+namespace morda{
+
+/**
+ * @brief Hash of property name.
+ * FNV-1a hash function.
+ * @param name - property name.
+ * @param h - hash of the preceding characters.
+ * @return Hash value.
+ */
+constexpr std::uint32_t propertyHash(const char* name, std::uint32_t h = 2166136261u){
+	return *name == 0 ? h : propertyHash(name + 1, (h ^ std::uint32_t(std::uint8_t(*name))) * 16777619u);
+}
+
+/**
+ * @brief Decoded chain of properties.
+ * Property table is a hash table of the properties of STOB chain.
+ * It is built once for a chain and then any property can be looked up in it in constant time,
+ * instead of scanning the chain for each property.
+ * In case a property appears in the chain several times, the first occurrence is taken,
+ * same as when scanning the chain.
+ */
+class PropertyTable{
+	struct Entry{
+		std::uint32_t hash;
+		const stob::Node* property;//nullptr if entry is empty
+	};
+	
+	std::vector<Entry> entries;
+	
+	const stob::Node* chain_v;
+public:
+	/**
+	 * @brief Constructor.
+	 * @param chain - chain of properties to decode. Non-property nodes are ignored.
+	 */
+	PropertyTable(const stob::Node* chain);
+	
+	PropertyTable(const PropertyTable&) = delete;
+	PropertyTable& operator=(const PropertyTable&) = delete;
+	
+	PropertyTable(PropertyTable&&) = default;
+	PropertyTable& operator=(PropertyTable&&) = default;
+	
+	/**
+	 * @brief Get decoded chain.
+	 * @return The chain this table was built from.
+	 */
+	const stob::Node* chain()const noexcept{
+		return this->chain_v;
+	}
+	
+	/**
+	 * @brief Find property.
+	 * @param name - name of the property to find.
+	 * @return Property node, i.e. node which holds property name and has property value as children.
+	 * @return nullptr if there is no such property in the table.
+	 */
+	const stob::Node* find(const char* name)const noexcept;
+	
+	/**
+	 * @brief Find property table of given chain.
+	 * Returns the property table of the widget which is currently being constructed,
+	 * if given chain is the chain of that widget.
+	 * @param chain - chain to find property table for.
+	 * @return Property table of the chain.
+	 * @return nullptr if there is no property table for given chain.
+	 */
+	static const PropertyTable* of(const stob::Node* chain)noexcept;
+	
+	/**
+	 * @brief Make property table available while in scope.
+	 * Inflater creates an object of this class while constructing a widget, so that all
+	 * the widget constructors of the class hierarchy read properties from the table via getProperty().
+	 */
+	class Scope{
+		const PropertyTable* prev;
+	public:
+		Scope(const PropertyTable& table)noexcept;
+		
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+		
+		~Scope()noexcept;
+	};
+};
+
+}
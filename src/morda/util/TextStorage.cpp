@@ -0,0 +1,399 @@
+#include "TextStorage.hpp"
+
+#include <utki/debug.hpp>
+#include <utki/util.hpp>
+
+
+using namespace morda;
+
+
+
+namespace{
+//chunks bigger than that are split, it is small enough to keep chunk edits and metrics recomputation cheap
+const size_t maxChunkSize_c = 1024;
+}
+
+
+
+size_t TextStorage::findChunk(size_t pos)const noexcept{
+	if(pos >= this->size_v){
+		return this->chunks.size();
+	}
+	
+	auto i = std::upper_bound(
+			this->chunks.begin(),
+			this->chunks.end(),
+			pos,
+			[](size_t pos, const Chunk& c){
+				return pos < c.start;
+			}
+		);
+	ASSERT(i != this->chunks.begin())
+	--i;
+	
+	ASSERT(i->start <= pos && pos < i->start + i->text.size())
+	
+	return size_t(i - this->chunks.begin());
+}
+
+
+
+TextStorage::const_iterator TextStorage::iteratorAt(size_t pos)const noexcept{
+	auto c = this->findChunk(pos);
+	if(c == this->chunks.size()){
+		return this->end();
+	}
+	return const_iterator(this, c, pos - this->chunks[c].start);
+}
+
+
+
+std::u32string TextStorage::substr(size_t pos, size_t n)const{
+	std::u32string ret;
+	
+	if(pos >= this->size_v){
+		return ret;
+	}
+	
+	ret.reserve(std::min(n, this->size_v - pos));
+	
+	this->forEachSpan(pos, n, [&ret](const char32_t* p, size_t len){
+		ret.append(p, len);
+	});
+	
+	return ret;
+}
+
+
+
+void TextStorage::updateStarts(size_t fromChunk)noexcept{
+	size_t start = fromChunk == 0 ? 0 : this->chunks[fromChunk - 1].start + this->chunks[fromChunk - 1].text.size();
+	
+	for(auto i = this->chunks.begin() + fromChunk; i != this->chunks.end(); ++i){
+		i->start = start;
+		start += i->text.size();
+	}
+	
+	ASSERT(start == this->size_v)
+	
+	this->offsetsValid = false;
+}
+
+
+
+void TextStorage::splitChunk(size_t chunk){
+	auto& text = this->chunks[chunk].text;
+	
+	if(text.size() <= maxChunkSize_c){
+		return;
+	}
+	
+	//split to half-filled chunks, so that subsequent inserts do not cause splitting right away
+	const size_t pieceSize = maxChunkSize_c / 2;
+	
+	std::vector<Chunk> pieces;
+	pieces.reserve((text.size() - 1) / pieceSize);
+	
+	for(size_t p = pieceSize; p < text.size(); p += pieceSize){
+		pieces.emplace_back(text.substr(p, pieceSize), 0);
+	}
+	
+	text.resize(pieceSize);
+	text.shrink_to_fit();
+	
+	this->chunks.insert(
+			this->chunks.begin() + chunk + 1,
+			std::make_move_iterator(pieces.begin()),
+			std::make_move_iterator(pieces.end())
+		);
+}
+
+
+
+void TextStorage::assign(std::u32string text){
+	this->clear();
+	
+	if(text.empty()){
+		return;
+	}
+	
+	this->size_v = text.size();
+	this->chunks.emplace_back(std::move(text), 0);
+	
+	this->splitChunk(0);
+	
+	this->updateStarts(0);
+}
+
+
+
+void TextStorage::insert(size_t pos, const std::u32string& str){
+	if(str.empty()){
+		return;
+	}
+	
+	utki::clampTop(pos, this->size_v);
+	
+	size_t c;
+	
+	if(this->chunks.empty()){
+		this->chunks.emplace_back(std::u32string(str), 0);
+		c = 0;
+	}else{
+		c = this->findChunk(pos);
+		if(c == this->chunks.size()){
+			//append to the last chunk
+			--c;
+		}
+		
+		auto& chunk = this->chunks[c];
+		chunk.text.insert(pos - chunk.start, str);
+		chunk.metricsValid = false;
+	}
+	
+	this->size_v += str.size();
+	
+	this->splitChunk(c);
+	
+	this->updateStarts(c);
+}
+
+
+
+void TextStorage::erase(size_t pos, size_t n){
+	if(pos >= this->size_v){
+		return;
+	}
+	
+	utki::clampTop(n, this->size_v - pos);
+	
+	if(n == 0){
+		return;
+	}
+	
+	size_t first = this->findChunk(pos);
+	size_t last = this->findChunk(pos + n - 1);
+	
+	ASSERT(first < this->chunks.size())
+	ASSERT(last < this->chunks.size())
+	
+	{
+		auto& f = this->chunks[first];
+		auto& l = this->chunks[last];
+		
+		size_t end = pos + n - l.start;
+		
+		if(first == last){
+			f.text.erase(pos - f.start, n);
+		}else{
+			l.text.erase(0, end);
+			l.metricsValid = false;
+			f.text.erase(pos - f.start);
+		}
+		f.metricsValid = false;
+	}
+	
+	this->size_v -= n;
+	
+	//remove fully erased chunks
+	if(last > first + 1){
+		this->chunks.erase(this->chunks.begin() + first + 1, this->chunks.begin() + last);
+		last = first + 1;
+	}
+	if(last != first && this->chunks[last].text.empty()){
+		this->chunks.erase(this->chunks.begin() + last);
+	}
+	if(this->chunks[first].text.empty()){
+		this->chunks.erase(this->chunks.begin() + first);
+		if(first != 0){
+			--first;
+		}
+	}
+	
+	//merge chunks around the erased span if they became small
+	if(first + 1 < this->chunks.size() && this->chunks[first].text.size() + this->chunks[first + 1].text.size() <= maxChunkSize_c){
+		this->chunks[first].text.append(this->chunks[first + 1].text);
+		this->chunks[first].metricsValid = false;
+		this->chunks.erase(this->chunks.begin() + first + 1);
+	}
+	
+	if(!this->chunks.empty()){
+		this->updateStarts(first);
+	}
+}
+
+
+
+void TextStorage::invalidateMetrics()const noexcept{
+	for(auto& c : this->chunks){
+		c.metricsValid = false;
+	}
+	this->offsetsValid = false;
+}
+
+
+
+const TextStorage::Chunk& TextStorage::chunkWithMetrics(size_t chunk, const Font& font)const{
+	if(this->metricsFont != &font){
+		this->invalidateMetrics();
+		this->metricsFont = &font;
+	}
+	
+	auto& c = this->chunks[chunk];
+	
+	if(!c.metricsValid){
+		c.prefix.resize(c.text.size() + 1);
+		
+		using std::min;
+		using std::max;
+		
+		//bounding box is accumulated from glyph metrics cached by the font, so the chunk text is not measured twice
+		real left = 0, right = 0, top = 0, bottom = 0;
+		
+		real x = 0;
+		c.prefix[0] = x;
+		for(size_t i = 0; i != c.text.size(); ++i){
+			auto bb = font.charBoundingBox(c.text[i]);
+			if(i == 0){
+				left = bb.p.x;
+				right = bb.p.x + bb.d.x;
+				top = bb.p.y;
+				bottom = bb.p.y + bb.d.y;
+			}else{
+				top = min(bb.p.y, top);
+				bottom = max(bb.p.y + bb.d.y, bottom);
+				left = min(x + bb.p.x, left);
+				right = max(x + bb.p.x + bb.d.x, right);
+			}
+			
+			x += font.charAdvance(c.text[i]);
+			if(i + 1 != c.text.size()){
+				x += font.kerning(c.text[i], c.text[i + 1]);
+			}
+			c.prefix[i + 1] = x;
+		}
+		
+		c.boundingBox = Rectr(left, top, right - left, bottom - top);
+		c.metricsValid = true;
+	}
+	
+	return c;
+}
+
+
+
+void TextStorage::updateOffsets(const Font& font)const{
+	if(this->metricsFont != &font){
+		this->invalidateMetrics();
+		this->metricsFont = &font;
+	}
+	
+	if(this->offsetsValid){
+		return;
+	}
+	
+	real x = 0;
+	
+	for(size_t i = 0; i != this->chunks.size(); ++i){
+		auto& c = this->chunkWithMetrics(i, font);
+		if(i != 0){
+			x += font.kerning(this->chunks[i - 1].text.back(), c.text.front());
+		}
+		c.offset = x;
+		x += c.prefix.back();
+	}
+	
+	this->advance_v = x;
+	this->offsetsValid = true;
+}
+
+
+
+real TextStorage::advance(const Font& font, size_t pos)const{
+	if(pos == 0 || this->chunks.empty()){
+		return 0;
+	}
+	
+	this->updateOffsets(font);
+	
+	auto c = this->findChunk(pos);
+	if(c == this->chunks.size()){
+		return this->advance_v;
+	}
+	
+	auto& chunk = this->chunks[c];
+	return chunk.offset + chunk.prefix[pos - chunk.start];
+}
+
+
+
+size_t TextStorage::indexAt(const Font& font, real x)const{
+	if(x <= 0 || this->chunks.empty()){
+		return 0;
+	}
+	
+	this->updateOffsets(font);
+	
+	if(x >= this->advance_v){
+		return this->size_v;
+	}
+	
+	auto c = std::upper_bound(
+			this->chunks.begin(),
+			this->chunks.end(),
+			x,
+			[](real x, const Chunk& c){
+				return x < c.offset;
+			}
+		);
+	ASSERT(c != this->chunks.begin())
+	--c;
+	
+	//find the character the position falls on
+	auto p = std::upper_bound(c->prefix.begin(), c->prefix.end() - 1, x - c->offset);
+	ASSERT(p != c->prefix.begin())
+	--p;
+	
+	size_t index = c->start + size_t(p - c->prefix.begin());
+	ASSERT(index < this->size_v)
+	
+	real left = c->offset + *p;
+	real right = this->advance(font, index + 1);
+	
+	return x - left < right - x ? index : index + 1;
+}
+
+
+
+Rectr TextStorage::boundingBox(const Font& font)const{
+	if(this->chunks.empty()){
+		return Rectr(0, 0, 0, 0);
+	}
+	
+	this->updateOffsets(font);
+	
+	using std::min;
+	using std::max;
+	
+	real left, right, top, bottom;
+	
+	//init with bounding box of the first chunk
+	{
+		auto& bb = this->chunks.front().boundingBox;
+		left = bb.p.x;
+		right = bb.p.x + bb.d.x;
+		top = bb.p.y;
+		bottom = bb.p.y + bb.d.y;
+	}
+	
+	for(auto i = this->chunks.begin() + 1; i != this->chunks.end(); ++i){
+		auto& bb = i->boundingBox;
+		
+		top = min(bb.p.y, top);
+		bottom = max(bb.p.y + bb.d.y, bottom);
+		left = min(i->offset + bb.p.x, left);
+		right = max(i->offset + bb.p.x + bb.d.x, right);
+	}
+	
+	return Rectr(left, top, right - left, bottom - top);
+}
@@ -0,0 +1,313 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+#include "../config.hpp"
+
+#include "../fonts/Font.hpp"
+
+
+namespace morda{
+
+/**
+ * @brief Editable UTF-32 text.
+ * The text is stored as a rope of chunks, each holding a limited number of characters.
+ * Inserting and erasing only touches the chunks in the edited span, so editing a
+ * large text costs in proportion to the size of the edit rather than to the size of the text.
+ * Text metrics (advance and bounding box) are cached per chunk and only recomputed
+ * for the chunks which were modified. For each chunk the advances of all its characters
+ * are kept as prefix sums, so that mapping between character index and horizontal
+ * position is a binary search.
+ */
+class TextStorage{
+	struct Chunk{
+		std::u32string text;
+		
+		//index of the first character of the chunk in the whole text
+		size_t start;
+		
+		//cached metrics of the chunk text
+		mutable bool metricsValid = false;
+		mutable Rectr boundingBox;
+		
+		//horizontal positions of the characters within the chunk, kerning included,
+		//last element is the advance of the whole chunk
+		mutable std::vector<real> prefix;
+		
+		//horizontal position of the chunk within the whole text
+		mutable real offset;
+		
+		Chunk(std::u32string&& text, size_t start) :
+				text(std::move(text)),
+				start(start)
+		{}
+	};
+	
+	//chunks are never empty
+	std::vector<Chunk> chunks;
+	
+	size_t size_v = 0;
+	
+	//font the cached metrics were computed with
+	mutable const Font* metricsFont = nullptr;
+	
+	//whether chunk offsets and the advance of the whole text are up to date
+	mutable bool offsetsValid = false;
+	mutable real advance_v;
+
+public:
+	TextStorage() = default;
+	
+	TextStorage(std::u32string text){
+		this->assign(std::move(text));
+	}
+	
+	/**
+	 * @brief Iterator over characters of the text.
+	 */
+	class const_iterator{
+		friend class TextStorage;
+		
+		const TextStorage* owner = nullptr;
+		size_t chunk = 0;
+		size_t offset = 0;
+		
+		const_iterator(const TextStorage* owner, size_t chunk, size_t offset) :
+				owner(owner),
+				chunk(chunk),
+				offset(offset)
+		{}
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef char32_t value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const char32_t* pointer;
+		typedef const char32_t& reference;
+		
+		const_iterator() = default;
+		
+		const char32_t& operator*()const noexcept{
+			return this->owner->chunks[this->chunk].text[this->offset];
+		}
+		
+		const char32_t* operator->()const noexcept{
+			return &this->operator*();
+		}
+		
+		const_iterator& operator++()noexcept{
+			++this->offset;
+			if(this->offset == this->owner->chunks[this->chunk].text.size()){
+				++this->chunk;
+				this->offset = 0;
+			}
+			return *this;
+		}
+		
+		const_iterator operator++(int)noexcept{
+			auto ret = *this;
+			this->operator++();
+			return ret;
+		}
+		
+		const_iterator& operator--()noexcept{
+			if(this->offset == 0){
+				--this->chunk;
+				this->offset = this->owner->chunks[this->chunk].text.size();
+			}
+			--this->offset;
+			return *this;
+		}
+		
+		const_iterator operator--(int)noexcept{
+			auto ret = *this;
+			this->operator--();
+			return ret;
+		}
+		
+		bool operator==(const const_iterator& i)const noexcept{
+			return this->chunk == i.chunk && this->offset == i.offset;
+		}
+		
+		bool operator!=(const const_iterator& i)const noexcept{
+			return !this->operator==(i);
+		}
+		
+		/**
+		 * @brief Get index of the character this iterator points to.
+		 * @return Index of the character in the text.
+		 */
+		size_t index()const noexcept{
+			if(this->chunk == this->owner->chunks.size()){
+				return this->owner->size();
+			}
+			return this->owner->chunks[this->chunk].start + this->offset;
+		}
+	};
+	
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+	
+	const_iterator begin()const noexcept{
+		return const_iterator(this, 0, 0);
+	}
+	
+	const_iterator end()const noexcept{
+		return const_iterator(this, this->chunks.size(), 0);
+	}
+	
+	const_reverse_iterator rbegin()const noexcept{
+		return const_reverse_iterator(this->end());
+	}
+	
+	const_reverse_iterator rend()const noexcept{
+		return const_reverse_iterator(this->begin());
+	}
+	
+	/**
+	 * @brief Get iterator pointing to a character.
+	 * @param pos - index of the character.
+	 * @return Iterator pointing to the character, or end iterator if pos is not less than size of the text.
+	 */
+	const_iterator iteratorAt(size_t pos)const noexcept;
+	
+	/**
+	 * @brief Get number of characters.
+	 * @return Number of characters in the text.
+	 */
+	size_t size()const noexcept{
+		return this->size_v;
+	}
+	
+	bool empty()const noexcept{
+		return this->size_v == 0;
+	}
+	
+	/**
+	 * @brief Get character.
+	 * @param pos - index of the character, must be less than size of the text.
+	 * @return The character.
+	 */
+	char32_t operator[](size_t pos)const noexcept{
+		return *this->iteratorAt(pos);
+	}
+	
+	/**
+	 * @brief Get the whole text.
+	 * @return Copy of the text.
+	 */
+	std::u32string str()const{
+		return this->substr(0, this->size());
+	}
+	
+	/**
+	 * @brief Get part of the text.
+	 * @param pos - index of the first character to get.
+	 * @param n - number of characters to get. Clamped to the end of the text.
+	 * @return Copy of the part of the text.
+	 */
+	std::u32string substr(size_t pos, size_t n = std::u32string::npos)const;
+	
+	/**
+	 * @brief Iterate through contiguous spans of characters.
+	 * Allows accessing the text without copying it.
+	 * @param pos - index of the first character.
+	 * @param n - number of characters. Clamped to the end of the text.
+	 * @param f - function called for each span, with pointer to the first character of the span and the span length.
+	 */
+	template <class F> void forEachSpan(size_t pos, size_t n, F&& f)const{
+		for(auto i = this->iteratorAt(pos); n != 0 && i.chunk != this->chunks.size(); ++i.chunk, i.offset = 0){
+			auto& t = this->chunks[i.chunk].text;
+			size_t len = std::min(t.size() - i.offset, n);
+			f(&t[i.offset], len);
+			n -= len;
+		}
+	}
+	
+	/**
+	 * @brief Replace whole text.
+	 * @param text - new text.
+	 */
+	void assign(std::u32string text);
+	
+	/**
+	 * @brief Remove all the text.
+	 */
+	void clear()noexcept{
+		this->chunks.clear();
+		this->size_v = 0;
+		this->offsetsValid = false;
+	}
+	
+	/**
+	 * @brief Insert text.
+	 * @param pos - index to insert the text at. Clamped to size of the text.
+	 * @param str - text to insert.
+	 */
+	void insert(size_t pos, const std::u32string& str);
+	
+	/**
+	 * @brief Erase part of the text.
+	 * @param pos - index of the first character to erase.
+	 * @param n - number of characters to erase. Clamped to the end of the text.
+	 */
+	void erase(size_t pos, size_t n);
+	
+	/**
+	 * @brief Replace part of the text.
+	 * @param pos - index of the first character to replace.
+	 * @param n - number of characters to replace. Clamped to the end of the text.
+	 * @param str - text to put instead of the replaced characters.
+	 */
+	void replace(size_t pos, size_t n, const std::u32string& str){
+		this->erase(pos, n);
+		this->insert(pos, str);
+	}
+	
+	/**
+	 * @brief Get advance of the text.
+	 * Complexity is O(log(n)) unless the text was edited since the last query.
+	 * @param font - font to use.
+	 * @param pos - get advance of the characters before this index.
+	 * @return Advance of the text, i.e. horizontal position of the character at given index.
+	 */
+	real advance(const Font& font, size_t pos = std::u32string::npos)const;
+	
+	/**
+	 * @brief Get index of the character at given horizontal position.
+	 * Complexity is O(log(n)) unless the text was edited since the last query.
+	 * @param font - font to use.
+	 * @param x - horizontal position within the text.
+	 * @return Index of the character boundary nearest to the given position, i.e.
+	 *         index of the character if the position is in its left half, or index of the next character otherwise.
+	 */
+	size_t indexAt(const Font& font, real x)const;
+	
+	/**
+	 * @brief Get bounding box of the text.
+	 * @param font - font to use.
+	 * @return Bounding box of the whole text.
+	 */
+	Rectr boundingBox(const Font& font)const;
+	
+	/**
+	 * @brief Drop cached text metrics.
+	 * Should be called when font changes.
+	 */
+	void invalidateMetrics()const noexcept;
+
+private:
+	//returns index of the chunk containing the character, or number of chunks
+	size_t findChunk(size_t pos)const noexcept;
+	
+	void updateStarts(size_t fromChunk)noexcept;
+	
+	void splitChunk(size_t chunk);
+	
+	const Chunk& chunkWithMetrics(size_t chunk, const Font& font)const;
+	
+	void updateOffsets(const Font& font)const;
+};
+	
+}
@@ -164,7 +164,15 @@ const stob::Node* morda::getProperty(const stob::Node* chain, const char* proper
 	if(!chain){
 		return nullptr;
 	}
-	if(auto n = chain->thisOrNext(property).node()){
+	
+	const stob::Node* n;
+	if(auto t = PropertyTable::of(chain)){
+		n = t->find(property);
+	}else{
+		n = chain->thisOrNext(property).node();
+	}
+	
+	if(n){
 		if(n->child() && n->child()->value()){
 			return n->child();
 		}
@@ -213,6 +221,13 @@ void morda::applySimpleAlphaBlending(){
 			Renderer::BlendFactor_e::ONE,
 			Renderer::BlendFactor_e::ONE_MINUS_SRC_ALPHA
 		);
+	RenderList::recordBlendEnabled(true);
+	RenderList::recordBlendFunc(
+			Renderer::BlendFactor_e::SRC_ALPHA,
+			Renderer::BlendFactor_e::ONE_MINUS_SRC_ALPHA,
+			Renderer::BlendFactor_e::ONE,
+			Renderer::BlendFactor_e::ONE_MINUS_SRC_ALPHA
+		);
 }
 
 
@@ -14,6 +14,8 @@
 #include "../render/Texture2D.hpp"
 #include "../render/RenderFactory.hpp"
 
+#include "PropertyTable.hpp"
+
 namespace morda{
 
 
@@ -107,6 +109,8 @@ std::tuple<std::unique_ptr<stob::Node>, stob::Node*> resolveIncludes(papki::File
 
 /**
  * @brief Get property by name from STOB chain.
+ * If the chain is the chain of a widget being inflated, then the property is looked up
+ * in the widget's property table. Otherwise, the chain is scanned for the property.
  * @param chain - STOB chain of properties.
  * @param property - property name to look for.
  * @return Pointer to property value if property was found in the STOB chain.
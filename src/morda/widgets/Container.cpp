@@ -1,5 +1,8 @@
 #include "Container.hpp"
 
+#include <algorithm>
+#include <unordered_set>
+
 #include "../Morda.hpp"
 
 #include "../util/util.hpp"
@@ -50,14 +53,14 @@ void Container::renderChild(const Matr4r& matrix, const Widget& c) const {
 	}
 
 	morda::Matr4r matr(matrix);
-	matr.translate(c.rect().p);
+	matr.translate(c.rect().p + this->childrenOffset());
 
 	c.renderInternal(matr);
 }
 
 
 void Container::render(const morda::Matr4r& matrix)const{
-	for(auto& w: this->children()){
+	for(auto w: this->childrenArray_v){
 		this->renderChild(matrix, *w);
 	}
 }
@@ -96,8 +99,8 @@ bool Container::onMouseButton(bool isDown, const morda::Vec2r& pos, MouseButton_
 	}
 
 	//call children in reverse order
-	for(Widget::T_ChildrenList::const_reverse_iterator i = this->children().rbegin(); i != this->children().rend(); ++i){
-		auto& c = *i;
+	for(auto i = this->childrenArray_v.rbegin(); i != this->childrenArray_v.rend(); ++i){
+		auto c = *i;
 
 		if(!c->isInteractive()){
 			continue;
@@ -114,7 +117,7 @@ bool Container::onMouseButton(bool isDown, const morda::Vec2r& pos, MouseButton_
 			ASSERT(this->mouseCaptureMap.find(pointerId) == this->mouseCaptureMap.end())
 
 			if(isDown){//in theory, it can be button up event here, if some widget which captured mouse was removed from its parent
-				this->mouseCaptureMap.insert(std::make_pair(pointerId, std::make_pair(std::weak_ptr<Widget>(c), 1)));
+				this->mouseCaptureMap.insert(std::make_pair(pointerId, std::make_pair(std::weak_ptr<Widget>(c->sharedFromThis(c)), 1)));
 			}
 
 			return true;
@@ -132,8 +135,8 @@ bool Container::onMouseMove(const morda::Vec2r& pos, unsigned pointerID){
 	BlockedFlagGuard blockedFlagGuard(this->isBlocked);
 
 	//call children in reverse order
-	for(Widget::T_ChildrenList::const_reverse_iterator i = this->children().rbegin(); i != this->children().rend(); ++i){
-		auto& c = *i;
+	for(auto i = this->childrenArray_v.rbegin(); i != this->childrenArray_v.rend(); ++i){
+		auto c = *i;
 
 		if(!c->isInteractive()){
 			ASSERT_INFO(!c->isHovered(), "c->name() = " << c->name())
@@ -153,9 +156,8 @@ bool Container::onMouseMove(const morda::Vec2r& pos, unsigned pointerID){
 
 		if(consumed){//consumed mouse move event
 			//un-hover rest of the children
-			for(++i; i != this->children().rend(); ++i){
-				auto& c = *i;
-				c->setHovered(false, pointerID);
+			for(++i; i != this->childrenArray_v.rend(); ++i){
+				(*i)->setHovered(false, pointerID);
 			}
 			return true;
 		}
@@ -172,8 +174,14 @@ void Container::onHoverChanged(unsigned pointerID){
 	}
 
 	//un-hover all the children if container became un-hovered
+	this->unhoverChildren(pointerID);
+}
+
+
+
+void Container::unhoverChildren(unsigned pointerID){
 	BlockedFlagGuard blockedFlagGuard(this->isBlocked);
-	for(auto& w : this->children()){
+	for(auto w : this->childrenArray_v){
 		w->setHovered(false, pointerID);
 	}
 }
@@ -183,9 +191,10 @@ void Container::onHoverChanged(unsigned pointerID){
 void Container::layOut(){
 //	TRACE(<< "Container::layOut(): invoked" << std::endl)
 	BlockedFlagGuard blockedFlagGuard(this->isBlocked);
-	for(auto& w : this->children()){
+	for(auto w : this->childrenArray_v){
 		if(w->needsRelayout()){
 			w->relayoutNeeded = false;
+			M_MORDA_PROFILE_SCOPE("layout", typeid(*w), w->id)
 			w->layOut();
 		}
 	}
@@ -221,6 +230,11 @@ Widget::T_ChildrenList::iterator Container::add(std::shared_ptr<Widget> w, const
 
 	Widget& widget = *w;
 
+	//reserve beforehand, so that inserting to the array does not throw after widget is added to the list
+	if(this->childrenArray_v.size() == this->childrenArray_v.capacity()){
+		this->childrenArray_v.reserve(std::max(2 * this->childrenArray_v.capacity(), this->childrenArray_v.size() + 1));
+	}
+
 	if(insertBefore){
 		ret = this->children_v.insert(insertBefore->parentIter_v, std::move(w));
 	}else{
@@ -229,8 +243,13 @@ Widget::T_ChildrenList::iterator Container::add(std::shared_ptr<Widget> w, const
 		--ret;
 	}
 
+	size_t index = insertBefore ? insertBefore->parentIndex_v : this->childrenArray_v.size();
+	this->childrenArray_v.insert(this->childrenArray_v.begin() + index, &widget);
+	this->updateParentIndices(index);
+
 	widget.parentIter_v = ret;
 	widget.parent_v = this;
+	this->indexSubtree(widget);
 	widget.onParentChanged();
 
 	this->onChildrenListChanged();
@@ -260,6 +279,10 @@ std::shared_ptr<Widget> Container::remove(Widget& w){
 
 	this->children_v.erase(w.parentIter_v);
 
+	this->childrenArray_v.erase(this->childrenArray_v.begin() + w.parentIndex_v);
+	this->updateParentIndices(w.parentIndex_v);
+
+	this->unindexSubtree(w);
 	w.parent_v = nullptr;
 	w.setUnhovered();
 
@@ -273,10 +296,119 @@ std::shared_ptr<Widget> Container::remove(Widget& w){
 
 
 void Container::removeAll() {
-	while(this->children().size()){
-//		TRACE(<< "Container::removeAll(): w = " << (this->Children().front().get()) << std::endl)
-		this->remove(*this->children().front());
+	if(this->children_v.size() == 0){
+		return;
+	}
+	
+	if(this->isBlocked){
+		throw morda::Exc("Container::removeAll(): cannot remove children while iterating through children, try deferred removing.");
+	}
+	
+	//all the widgets in ID index of this container are from the children's subtrees,
+	//remove them from the ancestors' ID indices in one pass
+	if(this->idIndex.size() != 0){
+		std::unordered_set<const Widget*> removed;
+		for(auto& i : this->idIndex){
+			removed.insert(i.second.begin(), i.second.end());
+		}
+		
+		for(Container* a = this->parent(); a; a = a->parent()){
+			for(auto& i : this->idIndex){
+				auto j = a->idIndex.find(i.first);
+				ASSERT(j != a->idIndex.end())
+				auto& v = j->second;
+				v.erase(
+						std::remove_if(
+								v.begin(),
+								v.end(),
+								[&removed](const Widget* w){
+									return removed.find(w) != removed.end();
+								}
+							),
+						v.end()
+					);
+				if(v.size() == 0){
+					a->idIndex.erase(j);
+				}
+			}
+		}
+		
+		this->idIndex.clear();
+	}
+	
+	T_ChildrenList children;
+	children.swap(this->children_v);
+	this->childrenArray_v.clear();
+	
+	for(auto& w : children){
+		w->indexedId.clear();
+		w->parent_v = nullptr;
+		w->setUnhovered();
+		w->onParentChanged();
+	}
+	
+	this->onChildrenListChanged();
+}
+
+
+
+void Container::updateParentIndices(size_t from)noexcept{
+	for(size_t i = from; i != this->childrenArray_v.size(); ++i){
+		this->childrenArray_v[i]->parentIndex_v = i;
+	}
+}
+
+
+
+void Container::indexSubtree(Widget& w){
+	w.indexedId = w.id;
+
+	auto c = dynamic_cast<Container*>(&w);
+
+	for(Container* a = this; a; a = a->parent()){
+		if(w.indexedId.length() != 0){
+			a->idIndex[w.indexedId].push_back(&w);
+		}
+		if(c){
+			for(auto& i : c->idIndex){
+				auto& v = a->idIndex[i.first];
+				v.insert(v.end(), i.second.begin(), i.second.end());
+			}
+		}
+	}
+}
+
+
+
+void Container::unindexSubtree(Widget& w){
+	auto c = dynamic_cast<Container*>(&w);
+
+	auto erase = [](T_IdIndex& index, const std::string& id, Widget* widget){
+		auto i = index.find(id);
+		ASSERT(i != index.end())
+		auto& v = i->second;
+		auto j = std::find(v.begin(), v.end(), widget);
+		ASSERT(j != v.end())
+		v.erase(j);
+		if(v.size() == 0){
+			index.erase(i);
+		}
+	};
+
+	for(Container* a = this; a; a = a->parent()){
+		if(w.indexedId.length() != 0){
+			erase(a->idIndex, w.indexedId, &w);
+		}
+		if(c){
+			for(auto& i : c->idIndex){
+				for(auto p : i.second){
+					erase(a->idIndex, i.first, p);
+				}
+			}
+		}
 	}
+
+	w.indexedId.clear();
 }
 
 
@@ -286,6 +418,38 @@ std::shared_ptr<Widget> Container::findById(const std::string& id)noexcept{
 		return r;
 	}
 
+	auto i = this->idIndex.find(id);
+	if(i != this->idIndex.end()){
+		//the closer to the tree root the higher the priority is
+		Widget* found = nullptr;
+		unsigned foundDepth = 0;
+		for(auto w : i->second){
+			if(w->id != id){
+				//ID was changed after the widget was added
+				continue;
+			}
+			unsigned depth = 0;
+			for(auto p = w->parent(); p != this; p = p->parent()){
+				ASSERT(p)
+				++depth;
+			}
+			if(!found || depth < foundDepth){
+				found = w;
+				foundDepth = depth;
+			}
+		}
+		if(found){
+			return found->sharedFromThis(found);
+		}
+	}
+
+	//ID is not in the index, but it could be assigned to some widget after it was added, so search through the tree
+	return this->findByIdScan(id);
+}
+
+
+
+std::shared_ptr<Widget> Container::findByIdScan(const std::string& id)noexcept{
 	//first check direct children, because the closer to the tree root higher the priority is
 	for(auto& w : this->children()){
 		if(auto r = w->Widget::findById(id)){
@@ -316,6 +480,7 @@ Vec2r Container::dimForWidget(const Widget& w, const LayoutParams& lp)const{
 		}
 	}
 	if(d.x < 0 || d.y < 0){
+		M_MORDA_PROFILE_SCOPE("measure", typeid(w), w.id)
 		Vec2r md = w.measure(d);
 		for(unsigned i = 0; i != md.size(); ++i){
 			if(d[i] < 0){
@@ -337,11 +502,23 @@ void Container::changeChildZPosition(Widget& child, T_ChildrenList::const_iterat
 
 	ASSERT(child.parent_v == this)
 
+	size_t index = toBefore == this->children_v.end() ? this->childrenArray_v.size() : (*toBefore)->parentIndex_v;
+
 	auto w = *child.parentIter_v;
 
 	this->children_v.erase(child.parentIter_v);
 
 	child.parentIter_v = this->children_v.insert(toBefore, std::move(w));
 
+	//move the child within the array keeping the order of the rest of the children
+	auto b = this->childrenArray_v.begin();
+	if(index > child.parentIndex_v){
+		std::rotate(b + child.parentIndex_v, b + child.parentIndex_v + 1, b + index);
+		this->updateParentIndices(child.parentIndex_v);
+	}else{
+		std::rotate(b + index, b + child.parentIndex_v, b + child.parentIndex_v + 1);
+		this->updateParentIndices(index);
+	}
+
 	this->onChildrenListChanged();
 }
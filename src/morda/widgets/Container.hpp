@@ -2,6 +2,8 @@
 
 #include <map>
 #include <list>
+#include <vector>
+#include <unordered_map>
 
 #include <utki/Unique.hpp>
 
@@ -33,10 +35,26 @@ class Container : virtual public Widget{
 private:
 	T_ChildrenList children_v;
 
+	//Same children as in children_v, but stored contiguously for faster iteration.
+	//Ownership is held by children_v.
+	std::vector<Widget*> childrenArray_v;
+
+	void updateParentIndices(size_t from)noexcept;
+
 	//Map which maps pointer ID to a pair holding reference to capturing widget and number of mouse capture clicks
 	typedef std::map<unsigned, std::pair<std::weak_ptr<Widget>, unsigned> > T_MouseCaptureMap;
 	T_MouseCaptureMap mouseCaptureMap;
 
+	//Index of IDs of all the widgets in the sub-hierarchy of this container, excluding the container itself.
+	//Widgets having same ID are listed in the order they were added.
+	typedef std::unordered_map<std::string, std::vector<Widget*>> T_IdIndex;
+	T_IdIndex idIndex;
+
+	void indexSubtree(Widget& w);
+	void unindexSubtree(Widget& w);
+
+	std::shared_ptr<Widget> findByIdScan(const std::string& id)noexcept;
+
 protected:
 	//flag indicating that modifications to children list are blocked
 	bool isBlocked = false;
@@ -121,6 +139,13 @@ public:
 	using Widget::getLayoutParams;
 protected:
 	void renderChild(const Matr4r& matrix, const Widget& c)const;
+	
+	/**
+	 * @brief Un-hover all the children.
+	 * Un-hovered widgets cancel the interaction with the pointer, e.g. pressed buttons get released without clicking.
+	 * @param pointerID - ID of the pointer to un-hover the children for.
+	 */
+	void unhoverChildren(unsigned pointerID);
 public:
 	/**
 	 * @brief Constructor.
@@ -135,6 +160,17 @@ public:
 	 */
 	void render(const morda::Matr4r& matrix)const override;
 
+	/**
+	 * @brief Get offset of the children contents.
+	 * Children are rendered shifted by this offset from their positions,
+	 * for example, scrolling containers return the negated scroll position here.
+	 * Damage reported by children is shifted by the same offset.
+	 * @return Offset of children contents in pixels.
+	 */
+	virtual Vec2r childrenOffset()const noexcept{
+		return Vec2r(0);
+	}
+
 	/**
 	 * @brief Handle mouse button event.
 	 * Override of Widget::onMouseButton() method. It passes the event to the container's child widgets in reverse order.
@@ -214,6 +250,8 @@ public:
 	/**
 	 * @brief Find widget by ID.
 	 * It searches through the whole widget sub-hierarchy, not just direct children of this container.
+	 * The container maintains an index of IDs of its sub-hierarchy, so the lookup does not traverse the widget tree.
+	 * In case there are several widgets with the given ID, the one closest to this container is returned.
 	 * @param id - ID of the child widget to look for.
 	 * @return pointer to widget with given ID if found.
 	 * @return nullptr if there is no widget with given ID found.
@@ -228,6 +266,16 @@ public:
 		return this->children_v;
 	}
 
+	/**
+	 * @brief Get array of child widgets.
+	 * Same as children(), but the child widgets are stored contiguously,
+	 * which is faster to iterate through. The order of widgets is same as in children list.
+	 * @return Array of child widgets.
+	 */
+	const std::vector<Widget*>& childrenArray()const noexcept{
+		return this->childrenArray_v;
+	}
+
 	const T_ChildrenList& getDirectChildren() const noexcept override{
 		return this->children();
 	}
@@ -63,6 +63,12 @@ Widget::Widget(const stob::Node* chain){
 		this->cache = false;
 	}
 
+	if(const stob::Node* p = getProperty(chain, "retain")){
+		this->retain = p->asBool();
+	}else{
+		this->retain = false;
+	}
+
 	if(const stob::Node* p = getProperty(chain, "visible")){
 		this->isVisible_v = p->asBool();
 	}else{
@@ -106,6 +112,7 @@ std::shared_ptr<Widget> Widget::findById(const std::string& id)noexcept{
 void Widget::resize(const morda::Vec2r& newDims){
 	if(this->rectangle.d == newDims){
 		if(this->relayoutNeeded){
+			M_MORDA_PROFILE_SCOPE("layout", typeid(*this), this->id)
 			this->clearCache();
 			this->relayoutNeeded = false;
 			this->layOut();
@@ -117,7 +124,9 @@ void Widget::resize(const morda::Vec2r& newDims){
 	this->rectangle.d = newDims;
 	utki::clampBottom(this->rectangle.d.x, real(0.0f));
 	utki::clampBottom(this->rectangle.d.y, real(0.0f));
+	this->setRedrawNeeded();
 	this->relayoutNeeded = false;
+	M_MORDA_PROFILE_SCOPE("layout", typeid(*this), this->id)
 	this->onResize();//call virtual method
 }
 
@@ -155,8 +164,64 @@ void Widget::setRelayoutNeeded()noexcept{
 	this->relayoutNeeded = true;
 	if(this->parent_v){
 		this->parent_v->setRelayoutNeeded();
+	}else if(this == morda::inst().rootWidget.get()){
+		//layout can move anything anywhere
+		morda::inst().setFullDamage();
 	}
 	this->cacheTex.reset();
+	if(this->retainedList){
+		this->retainedList->clear();
+	}
+}
+
+
+
+void Widget::setRedrawNeeded()noexcept{
+	this->invalidateCache();
+	this->reportDamage();
+}
+
+
+
+void Widget::moveTo(const morda::Vec2r& newPos)noexcept{
+	if(this->rectangle.p == newPos){
+		return;
+	}
+
+	//contents of the widget do not change, but the parent's contents do
+	if(this->parent_v){
+		this->parent_v->invalidateCache();
+	}
+
+	this->reportDamage();
+	this->rectangle.p = newPos;
+	this->reportDamage();
+}
+
+
+
+void Widget::reportDamage()noexcept{
+	if(morda::inst().isFullyDamaged()){
+		return;
+	}
+
+	Rectr r(Vec2r(0), this->rect().d);
+
+	const Widget* w = this;
+	for(; w->parent(); w = w->parent()){
+		r.p += w->rect().p + w->parent()->childrenOffset();
+		if(w->parent()->clip()){
+			r.intersect(Rectr(Vec2r(0), w->parent()->rect().d));
+		}
+	}
+
+	if(w != morda::inst().rootWidget.get()){
+		return;
+	}
+
+	r.p += w->rect().p;
+
+	morda::inst().addDamage(r);
 }
 
 
@@ -166,6 +231,8 @@ void Widget::renderInternal(const morda::Matr4r& matrix)const{
 		return;
 	}
 
+	M_MORDA_PROFILE_SCOPE("render", typeid(*this), this->id)
+
 	if(this->cache){
 		if(this->cacheDirty){
 			bool scissorTestWasEnabled = morda::inst().renderer().isScissorEnabled();
@@ -187,34 +254,19 @@ void Widget::renderInternal(const morda::Matr4r& matrix)const{
 		applySimpleAlphaBlending();
 
 		this->renderFromCache(matrix);
-	}else{
-		if(this->clip_v){
-	//		TRACE(<< "Widget::RenderInternal(): oldScissorBox = " << Rect2i(oldcissorBox[0], oldcissorBox[1], oldcissorBox[2], oldcissorBox[3]) << std::endl)
-
-			//set scissor test
-			kolme::Recti scissor = this->computeViewportRect(matrix);
-
-			kolme::Recti oldScissor;
-			bool scissorTestWasEnabled = morda::inst().renderer().isScissorEnabled();
-			if(scissorTestWasEnabled){
-				oldScissor = morda::inst().renderer().getScissorRect();
-				scissor.intersect(oldScissor);
-			}else{
-				morda::inst().renderer().setScissorEnabled(true);
-			}
-
-			morda::inst().renderer().setScissorRect(scissor);
-
-			this->render(matrix);
-
-			if(scissorTestWasEnabled){
-				morda::inst().renderer().setScissorRect(oldScissor);
-			}else{
-				morda::inst().renderer().setScissorEnabled(false);
+	}else if(this->retain){
+		if(this->cacheDirty || !this->retainedList || !this->retainedList->isValidFor(matrix)){
+			if(!this->retainedList){
+				this->retainedList = utki::makeUnique<RenderList>();
 			}
+			RenderList::Recording recording(*this->retainedList, matrix);
+			this->renderUncached(matrix);
+			this->cacheDirty = false;
 		}else{
-			this->render(matrix);
+			this->retainedList->replay();
 		}
+	}else{
+		this->renderUncached(matrix);
 	}
 
 	//render border
@@ -234,6 +286,44 @@ void Widget::renderInternal(const morda::Matr4r& matrix)const{
 #endif
 }
 
+
+
+void Widget::renderUncached(const morda::Matr4r& matrix)const{
+	if(this->clip_v){
+//		TRACE(<< "Widget::RenderInternal(): oldScissorBox = " << Rect2i(oldcissorBox[0], oldcissorBox[1], oldcissorBox[2], oldcissorBox[3]) << std::endl)
+
+		//set scissor test
+		kolme::Recti scissor = this->computeViewportRect(matrix);
+
+		RenderList::recordClip(scissor);
+
+		kolme::Recti oldScissor;
+		bool scissorTestWasEnabled = morda::inst().renderer().isScissorEnabled();
+		if(scissorTestWasEnabled){
+			oldScissor = morda::inst().renderer().getScissorRect();
+			scissor.intersect(oldScissor);
+		}else{
+			morda::inst().renderer().setScissorEnabled(true);
+		}
+
+		morda::inst().renderer().setScissorRect(scissor);
+
+		this->render(matrix);
+
+		if(scissorTestWasEnabled){
+			morda::inst().renderer().setScissorRect(oldScissor);
+		}else{
+			morda::inst().renderer().setScissorEnabled(false);
+		}
+
+		RenderList::recordUnclip();
+	}else{
+		this->render(matrix);
+	}
+}
+
+
+
 std::shared_ptr<Texture2D> Widget::renderToTexture(std::shared_ptr<Texture2D> reuse) const {
 	std::shared_ptr<Texture2D> tex;
 
@@ -251,6 +341,9 @@ std::shared_ptr<Texture2D> Widget::renderToTexture(std::shared_ptr<Texture2D> re
 
 	ASSERT(tex)
 
+	//rendering to texture is not a part of any retained render list
+	RenderList::Pause renderListPause;
+
 	r.setFramebuffer(r.factory->createFramebuffer(tex));
 
 //	ASSERT_INFO(Render::isBoundFrameBufferComplete(), "tex.dim() = " << tex.dim())
@@ -285,9 +378,15 @@ void Widget::renderFromCache(const kolme::Matr4f& matrix) const {
 }
 
 void Widget::clearCache(){
+	this->setRedrawNeeded();
+}
+
+
+
+void Widget::invalidateCache()noexcept{
 	this->cacheDirty = true;
 	if(this->parent_v){
-		this->parent_v->clearCache();
+		this->parent_v->invalidateCache();
 	}
 }
 
@@ -414,6 +513,12 @@ void Widget::setEnabled(bool enable) {
 }
 
 void Widget::setVisible(bool visible) {
+	if(this->isVisible_v != visible){
+		if(this->parent_v){
+			this->parent_v->invalidateCache();
+		}
+		this->reportDamage();
+	}
 	this->isVisible_v = visible;
 	if (!this->isVisible_v) {
 		this->setUnhovered();
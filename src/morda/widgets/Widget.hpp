@@ -16,11 +16,13 @@
 #include "../config.hpp"
 
 #include "../render/Texture2D.hpp"
+#include "../render/RenderList.hpp"
 
 #include "../util/keycodes.hpp"
 #include "../util/MouseButton.hpp"
 
 #include "../Exc.hpp"
+#include "../Profiler.hpp"
 
 
 namespace morda{
@@ -95,6 +97,7 @@ public:
 private:
 	Container* parent_v = nullptr;
 	T_ChildrenList::iterator parentIter_v;
+	size_t parentIndex_v;//index in the parent's array of children
 
 	std::set<unsigned> hovered;
 
@@ -132,6 +135,16 @@ private:
 
 	void renderFromCache(const kolme::Matr4f& matrix)const;
 
+	void invalidateCache()noexcept;
+
+	//marks the area of the widget on the screen as damaged
+	void reportDamage()noexcept;
+
+	bool retain;
+	mutable std::unique_ptr<RenderList> retainedList;
+
+	void renderUncached(const morda::Matr4r& matrix)const;
+
 protected:
 	void clearCache();
 
@@ -147,6 +160,21 @@ public:
 		this->cache = enabled;
 	}
 
+	/**
+	 * @brief Enable/disable retained rendering.
+	 * If retained rendering is enabled for this widget then draw calls issued when rendering the widget and its children
+	 * are recorded to a render list. Next time the widget needs to be drawn the recorded draw calls are replayed
+	 * without traversing the widget hierarchy. The render list is re-recorded when cache is cleared or
+	 * when the widget is drawn at a different position on the screen.
+	 * Unlike caching, this does not require an additional texture and does not lose resolution.
+	 * From GUI script it can be enabled with 'retain{true}' property.
+	 * @param enabled - whether to enable or disable retained rendering.
+	 */
+	void setRetain(bool enabled)noexcept{
+		this->retain = enabled;
+		this->retainedList.reset();
+	}
+
 	/**
 	 * @brief Render this widget to texture.
 	 * @param reuse - try to re-use the existing texture to avoid new texture allocation.
@@ -162,6 +190,9 @@ private:
 	std::unique_ptr<stob::Node> layout;
 
 	mutable std::unique_ptr<LayoutParams> layoutParams;
+
+	//ID this widget was registered with in the ID index of the ancestor containers
+	std::string indexedId;
 public:
 	std::string id;
 
@@ -224,6 +255,16 @@ public:
 		return this->parentIter_v;
 	}
 
+	/**
+	 * @brief Get index of the widget in the parent container.
+	 * Index is the position of the widget in parent's children list.
+	 * Only valid when the widget is added to some container.
+	 * @return Index of this widget among the children of its parent container.
+	 */
+	size_t parentIndex()const noexcept{
+		return this->parentIndex_v;
+	}
+
 	/**
 	 * @brief Remove widget from parent container.
 	 * Be careful when calling this method from within another method of the widget
@@ -286,16 +327,14 @@ public:
 	 * @brief Move widget to position within its parent.
 	 * @param newPos - new widget's position.
 	 */
-	void moveTo(const morda::Vec2r& newPos)noexcept{
-		this->rectangle.p = newPos;
-	}
+	void moveTo(const morda::Vec2r& newPos)noexcept;
 
 	/**
 	 * @brief Shift widget within its parent.
 	 * @param delta - vector to shift the widget by.
 	 */
 	void moveBy(const morda::Vec2r& delta)noexcept{
-		this->rectangle.p += delta;
+		this->moveTo(this->rectangle.p + delta);
 	}
 
 	/**
@@ -401,16 +440,33 @@ public:
 	 */
 	template <class T> std::list<std::shared_ptr<T>> find(){
 		std::list<std::shared_ptr<T>> ret;
+		this->findInto(ret);
+		return ret;
+	}
+
+	/**
+	 * @brief Recursively visit all children of given type.
+	 * Unlike find(), this method does not allocate any memory.
+	 * The visitor must not add or remove widgets to/from the hierarchy being visited.
+	 * @param visitor - function object to call for each child widget of type T, it is called with T& argument.
+	 */
+	template <class T, class F> void visit(F&& visitor){
+		for(auto& child : this->getDirectChildren()){
+			if(auto c = dynamic_cast<T*>(child.get())){
+				visitor(*c);
+			}
+			child->visit<T>(visitor);
+		}
+	}
 
-		auto childrenList = this->getDirectChildren();
-		for(auto& child : childrenList){
+private:
+	template <class T> void findInto(std::list<std::shared_ptr<T>>& ret){
+		for(auto& child : this->getDirectChildren()){
 			if(auto c = std::dynamic_pointer_cast<T>(child)){
 				ret.emplace_back(std::move(c));
 			}
-			ret.splice(ret.end(), child->find<T>());
+			child->findInto(ret);
 		}
-
-		return ret;
 	}
 
 public:
@@ -548,6 +604,14 @@ public:
 	 */
 	void setRelayoutNeeded()noexcept;
 
+	/**
+	 * @brief Request redrawing.
+	 * Marks the area occupied by the widget on the screen as damaged, so that it is redrawn
+	 * on next call to Morda::renderDamaged(). Widgets should call this method when their
+	 * appearance changes without re-layout. Does nothing if the widget is not in the GUI hierarchy.
+	 */
+	void setRedrawNeeded()noexcept;
+
 	/**
 	 * @brief Perform layout of the widget.
 	 * Override this method to arrange widgets contents if needed.
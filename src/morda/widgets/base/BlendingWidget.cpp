@@ -74,8 +74,10 @@ BlendingWidget::BlendingWidget(const stob::Node* chain) :
 
 void BlendingWidget::applyBlending() const{
 	morda::inst().renderer().setBlendEnabled(this->isBlendingEnabled());
+	RenderList::recordBlendEnabled(this->isBlendingEnabled());
 	if(this->isBlendingEnabled()){
 		morda::inst().renderer().setBlendFunc(this->blend_v.src, this->blend_v.dst, this->blend_v.srcAlpha, this->blend_v.dstAlpha);
+		RenderList::recordBlendFunc(this->blend_v.src, this->blend_v.dst, this->blend_v.srcAlpha, this->blend_v.dstAlpha);
 	}
 }
 
@@ -84,6 +86,7 @@ void BlendingWidget::setBlendingEnabled(bool enable){
 		return;
 	}
 	this->isBlendingEnabled_v = enable;
+	this->setRedrawNeeded();
 	this->onBlendingChanged();
 }
 
@@ -92,5 +95,6 @@ void BlendingWidget::setBlendingParams(const BlendingParams& blend){
 		return;
 	}
 	this->blend_v = blend;
+	this->setRedrawNeeded();
 	this->onBlendingChanged();
 }
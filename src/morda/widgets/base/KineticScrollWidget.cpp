@@ -0,0 +1,352 @@
+#include "KineticScrollWidget.hpp"
+
+#include <cmath>
+
+#include "../../Morda.hpp"
+
+#include "../../util/util.hpp"
+
+
+using namespace morda;
+
+
+namespace{
+
+//update about 60 times per second
+const std::uint16_t updatePeriod_c = 16;
+
+//velocities below this value are considered zero, in pixels per second
+const real minVelocity_c = real(20);
+
+//velocity decay rate while overscrolled, in 1/second
+const real overscrollDamping_c = real(20);
+
+//rate of returning from overscroll, in 1/second
+const real springRate_c = real(12);
+
+//rate of approaching the snap point, in 1/second
+const real snapRate_c = real(15);
+
+//resistance to dragging while overscrolled
+const real dragOverscrollFactor_c = real(0.5f);
+
+//only pointer samples from this last period of time are used to compute velocity, in milliseconds
+const std::uint32_t velocityWindow_c = 100;
+
+//distance the pointer has to move before dragging starts, in density pixels
+const real dragThreshold_c = real(5);
+	
+}
+
+
+
+class KineticScrollWidget::Flight : public Updateable{
+	KineticScrollWidget& owner;
+public:
+	Flight(KineticScrollWidget& owner) :
+			owner(owner)
+	{}
+	
+	void update(std::uint32_t dt)override{
+		this->owner.updateFlight(dt);
+	}
+};
+
+
+
+KineticScrollWidget::KineticScrollWidget(const stob::Node* chain) :
+		Widget(chain)
+{
+	if(auto p = getProperty(chain, "kinetic")){
+		this->isKinetic_v = p->asBool();
+	}else{
+		this->isKinetic_v = false;
+	}
+	
+	if(auto p = getProperty(chain, "snap")){
+		this->isSnapping_v = p->asBool();
+	}else{
+		this->isSnapping_v = false;
+	}
+}
+
+
+
+KineticScrollWidget::~KineticScrollWidget()noexcept{
+	//flight refers to this widget, so it must not be updated after the widget is destroyed
+	this->stopFlight();
+}
+
+
+
+void KineticScrollWidget::setKinetic(bool kinetic){
+	this->isKinetic_v = kinetic;
+	
+	if(!kinetic){
+		this->isPointerDown = false;
+		this->isDragging = false;
+		this->stopKineticScrolling();
+	}
+}
+
+
+
+void KineticScrollWidget::addSample(const Vec2r& pos){
+	this->lastSample = (this->lastSample + 1) % this->samples.size();
+	
+	auto& s = this->samples[this->lastSample];
+	s.pos = pos;
+	s.time = Updateable::getTicks();
+	
+	if(this->numSamples < this->samples.size()){
+		++this->numSamples;
+	}
+}
+
+
+
+Vec2r KineticScrollWidget::computeVelocity()const{
+	if(this->numSamples < 2){
+		return Vec2r(0);
+	}
+	
+	auto& newest = this->samples[this->lastSample];
+	
+	const Sample* oldest = &newest;
+	
+	for(size_t i = 1; i != this->numSamples; ++i){
+		auto& s = this->samples[(this->lastSample + this->samples.size() - i) % this->samples.size()];
+		if(newest.time - s.time > velocityWindow_c){
+			break;
+		}
+		oldest = &s;
+	}
+	
+	std::uint32_t dt = newest.time - oldest->time;
+	if(dt == 0){
+		return Vec2r(0);
+	}
+	
+	//content is scrolled in the direction opposite to the pointer movement
+	return (oldest->pos - newest.pos) * (real(1000) / real(dt));
+}
+
+
+
+void KineticScrollWidget::setOverscroll(const Vec2r& overscroll)noexcept{
+	if(this->overscroll_v == overscroll){
+		return;
+	}
+	this->overscroll_v = overscroll;
+	
+	//content is rendered shifted by overscroll
+	this->setRedrawNeeded();
+}
+
+
+
+void KineticScrollWidget::applyOverscroll(const Vec2r& over){
+	Vec2r o = this->overscroll_v + over;
+	
+	//do not let overscroll to go further than quarter of the widget size
+	for(unsigned i = 0; i != 2; ++i){
+		real limit = this->rect().d[i] / 4;
+		utki::clampRange(o[i], -limit, limit);
+	}
+	
+	this->setOverscroll(o);
+}
+
+
+
+bool KineticScrollWidget::handleKineticMouseButton(bool isDown, const Vec2r& pos, MouseButton_e button, unsigned pointerID){
+	if(!this->isKinetic_v || button != MouseButton_e::LEFT){
+		return false;
+	}
+	
+	if(isDown){
+		if(this->isPointerDown){
+			//already tracking another pointer
+			return false;
+		}
+		
+		//grabbing stops the flight, but keeps the overscroll
+		this->stopFlight();
+		this->velocity = Vec2r(0);
+		
+		this->isPointerDown = true;
+		this->isDragging = false;
+		this->dragPointerId = pointerID;
+		this->dragStartPos = pos;
+		this->lastPointerPos = pos;
+		this->numSamples = 0;
+		this->addSample(pos);
+		return true;
+	}
+	
+	if(!this->isPointerDown || this->dragPointerId != pointerID){
+		return false;
+	}
+	
+	this->isPointerDown = false;
+	
+	bool wasDragging = this->isDragging;
+	this->isDragging = false;
+	
+	if(wasDragging){
+		this->addSample(pos);
+		this->velocity = this->computeVelocity();
+	}else{
+		this->velocity = Vec2r(0);
+	}
+	
+	this->startFlight();
+	
+	return wasDragging;
+}
+
+
+
+bool KineticScrollWidget::handleKineticMouseMove(const Vec2r& pos, unsigned pointerID){
+	if(!this->isPointerDown || this->dragPointerId != pointerID){
+		return false;
+	}
+	
+	if(!this->isDragging){
+		Vec2r d = pos - this->dragStartPos;
+		real threshold = Morda::inst().units.dpToPx(dragThreshold_c);
+		if(d * d < threshold * threshold){
+			return false;
+		}
+		this->isDragging = true;
+		
+		//the pointer is scrolling now, the content should not consider it pressed
+		this->onKineticDragStarted(pointerID);
+	}
+	
+	Vec2r delta = this->lastPointerPos - pos;
+	this->lastPointerPos = pos;
+	this->addSample(pos);
+	
+	//first, drag back from overscroll
+	Vec2r over = this->overscroll_v;
+	for(unsigned i = 0; i != 2; ++i){
+		real& o = over[i];
+		if(o == 0 || (o > 0) == (delta[i] > 0)){
+			continue;
+		}
+		if(std::abs(delta[i]) <= std::abs(o)){
+			o += delta[i];
+			delta[i] = 0;
+		}else{
+			delta[i] += o;
+			o = 0;
+		}
+	}
+	this->setOverscroll(over);
+	
+	this->applyOverscroll(this->kineticScrollBy(delta) * dragOverscrollFactor_c);
+	
+	return true;
+}
+
+
+
+void KineticScrollWidget::startFlight(){
+	this->isSnapped = !this->isSnapping_v;
+	
+	if(this->isKineticScrolling()){
+		return;
+	}
+	
+	if(this->velocity == Vec2r(0) && this->overscroll_v == Vec2r(0) && this->isSnapped){
+		return;
+	}
+	
+	if(!this->flight){
+		this->flight = std::make_shared<Flight>(*this);
+	}
+	this->flight->startUpdating(updatePeriod_c);
+}
+
+
+
+void KineticScrollWidget::stopFlight()noexcept{
+	if(this->flight){
+		this->flight->stopUpdating();
+	}
+}
+
+
+
+bool KineticScrollWidget::isKineticScrolling()const noexcept{
+	return this->flight && this->flight->isUpdating();
+}
+
+
+
+void KineticScrollWidget::fling(const Vec2r& velocity){
+	if(this->isPointerDown){
+		return;
+	}
+	this->velocity = velocity;
+	this->startFlight();
+}
+
+
+
+void KineticScrollWidget::stopKineticScrolling()noexcept{
+	this->stopFlight();
+	this->velocity = Vec2r(0);
+	this->setOverscroll(Vec2r(0));
+	this->isSnapped = true;
+}
+
+
+
+void KineticScrollWidget::updateFlight(std::uint32_t dt){
+	real t = real(dt) / real(1000);
+	
+	if(this->velocity != Vec2r(0)){
+		this->applyOverscroll(this->kineticScrollBy(this->velocity * t));
+		
+		this->velocity *= std::exp(-this->friction_v * t);
+		
+		for(unsigned i = 0; i != 2; ++i){
+			if(this->overscroll_v[i] != 0){
+				this->velocity[i] *= std::exp(-overscrollDamping_c * t);
+			}
+			if(std::abs(this->velocity[i]) < minVelocity_c){
+				this->velocity[i] = 0;
+			}
+		}
+		return;
+	}
+	
+	if(this->overscroll_v != Vec2r(0)){
+		Vec2r o = this->overscroll_v - this->overscroll_v * std::min(real(1), springRate_c * t);
+		
+		for(unsigned i = 0; i != 2; ++i){
+			if(std::abs(o[i]) < real(0.5f)){
+				o[i] = 0;
+			}
+		}
+		this->setOverscroll(o);
+		return;
+	}
+	
+	if(!this->isSnapped){
+		Vec2r d = this->kineticSnapDelta();
+		
+		if(std::abs(d.x) < real(0.5f) && std::abs(d.y) < real(0.5f)){
+			this->kineticScrollBy(d);
+			this->isSnapped = true;
+		}else if(this->kineticScrollBy(d * std::min(real(1), snapRate_c * t)) != Vec2r(0)){
+			//snap point is beyond scroll boundary
+			this->isSnapped = true;
+		}
+		return;
+	}
+	
+	this->stopFlight();
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <array>
+
+#include "../Widget.hpp"
+
+#include "../../Updateable.hpp"
+
+
+namespace morda{
+
+/**
+ * @brief Base class for widgets with kinetic scrolling.
+ * Implements scroll physics: tracking of pointer drag velocity, deceleration due to friction,
+ * overscroll bounce and snapping to snap points.
+ * While scrolling is in flight only the scroll position is updated, no relayout is done.
+ * From GUI script kinetic scrolling can be enabled by 'kinetic{true}' property and snapping
+ * to snap points can be enabled by 'snap{true}' property. By default, both are disabled.
+ */
+class KineticScrollWidget : virtual public Widget{
+	class Flight;
+	friend class Flight;
+	
+	std::shared_ptr<Flight> flight;
+	
+	bool isKinetic_v;
+	bool isSnapping_v;
+	
+	//velocity decay rate, in 1/second
+	real friction_v = real(2.5f);
+	
+	//pointer drag
+	unsigned dragPointerId = 0;
+	bool isPointerDown = false;
+	bool isDragging = false;
+	Vec2r dragStartPos;
+	Vec2r lastPointerPos;
+	
+	struct Sample{
+		Vec2r pos;
+		std::uint32_t time;
+	};
+	std::array<Sample, 8> samples;
+	size_t numSamples = 0;
+	size_t lastSample = 0;
+	
+	//current scrolling velocity, in pixels per second
+	Vec2r velocity = Vec2r(0);
+	
+	Vec2r overscroll_v = Vec2r(0);
+	
+	bool isSnapped = true;
+	
+protected:
+	KineticScrollWidget(const stob::Node* chain);
+	
+	/**
+	 * @brief Scroll content by given delta.
+	 * Called by kinetic scrolling engine to scroll the content. Implementation should only
+	 * translate the content and must not initiate relayout.
+	 * @param delta - scroll position delta in pixels.
+	 * @return The part of the delta which could not be applied because scroll boundary has been reached.
+	 */
+	virtual Vec2r kineticScrollBy(const Vec2r& delta) = 0;
+	
+	/**
+	 * @brief Get distance to the closest snap point.
+	 * @return Scroll position delta needed to move to the closest snap point.
+	 */
+	virtual Vec2r kineticSnapDelta()const = 0;
+	
+	/**
+	 * @brief Called when pointer drag turns into scrolling.
+	 * Widget should cancel the press on its content, if any, so that releasing the pointer
+	 * after scrolling does not click the content.
+	 * @param pointerID - ID of the pointer which is dragged.
+	 */
+	virtual void onKineticDragStarted(unsigned pointerID){}
+	
+	/**
+	 * @brief Handle mouse button event.
+	 * Widget should call this method from its onMouseButton() handler.
+	 * @param isDown - is button pressed.
+	 * @param pos - pointer position in widget's coordinates.
+	 * @param button - mouse button.
+	 * @param pointerID - pointer ID.
+	 * @return true if event is consumed by kinetic scrolling.
+	 * @return false otherwise.
+	 */
+	bool handleKineticMouseButton(bool isDown, const Vec2r& pos, MouseButton_e button, unsigned pointerID);
+	
+	/**
+	 * @brief Handle mouse move event.
+	 * Widget should call this method from its onMouseMove() handler.
+	 * @param pos - pointer position in widget's coordinates.
+	 * @param pointerID - pointer ID.
+	 * @return true if pointer is being dragged.
+	 * @return false otherwise.
+	 */
+	bool handleKineticMouseMove(const Vec2r& pos, unsigned pointerID);
+	
+public:
+	KineticScrollWidget(const KineticScrollWidget&) = delete;
+	KineticScrollWidget& operator=(const KineticScrollWidget&) = delete;
+	
+	~KineticScrollWidget()noexcept;
+	
+	/**
+	 * @brief Check if kinetic scrolling is enabled.
+	 * @return true if kinetic scrolling is enabled.
+	 */
+	bool isKinetic()const noexcept{
+		return this->isKinetic_v;
+	}
+	
+	/**
+	 * @brief Enable or disable kinetic scrolling.
+	 * @param kinetic - whether to enable kinetic scrolling.
+	 */
+	void setKinetic(bool kinetic);
+	
+	/**
+	 * @brief Check if snapping to snap points is enabled.
+	 * @return true if snapping is enabled.
+	 */
+	bool isSnapping()const noexcept{
+		return this->isSnapping_v;
+	}
+	
+	/**
+	 * @brief Enable or disable snapping to snap points.
+	 * @param snapping - whether to enable snapping.
+	 */
+	void setSnapping(bool snapping){
+		this->isSnapping_v = snapping;
+	}
+	
+	/**
+	 * @brief Set friction.
+	 * @param friction - velocity decay rate, in 1/second.
+	 */
+	void setFriction(real friction){
+		this->friction_v = friction;
+	}
+	
+	/**
+	 * @brief Start kinetic scrolling with given velocity.
+	 * @param velocity - initial scrolling velocity in pixels per second.
+	 */
+	void fling(const Vec2r& velocity);
+	
+	/**
+	 * @brief Stop kinetic scrolling.
+	 * Stops scrolling immediately, overscroll is reset.
+	 */
+	void stopKineticScrolling()noexcept;
+	
+	/**
+	 * @brief Check if kinetic scrolling is in flight.
+	 * @return true if scrolling is in flight.
+	 */
+	bool isKineticScrolling()const noexcept;
+	
+	/**
+	 * @brief Get current overscroll.
+	 * Widget should additionally translate its content by this value when rendering.
+	 * @return Current overscroll in pixels.
+	 */
+	const Vec2r& overscroll()const noexcept{
+		return this->overscroll_v;
+	}
+	
+private:
+	//all changes of overscroll go through this method, so that the widget gets redrawn
+	void setOverscroll(const Vec2r& overscroll)noexcept;
+	
+	void updateFlight(std::uint32_t dt);
+	
+	void startFlight();
+	
+	void stopFlight()noexcept;
+	
+	void addSample(const Vec2r& pos);
+	
+	Vec2r computeVelocity()const;
+	
+	void applyOverscroll(const Vec2r& over);
+};
+
+}
@@ -55,24 +55,71 @@ Vec2r SingleLineTextWidget::measure(const morda::Vec2r& quotum)const noexcept{
 	return ret;
 }
 
-void SingleLineTextWidget::onTextChanged() {
+void SingleLineTextWidget::onTextResized(){
+	real oldWidth = this->bb.d.x;
+	
 	this->recomputeBoundingBox();
+	
+	//measure() depends only on the text width, if it did not change then layout stays the same, only redraw is needed
+	if(this->bb.d.x == oldWidth){
+		this->setRedrawNeeded();
+		return;
+	}
+	
+	this->setRelayoutNeeded();
+}
+
+void SingleLineTextWidget::onTextChanged() {
+	this->mesh.reset();
 	this->TextWidget::onTextChanged();
 }
 
+void SingleLineTextWidget::renderText(const morda::Matr4r& matrix, kolme::Vec4f color)const{
+	if(!this->mesh){
+		this->mesh = this->font().makeMesh(this->getText());
+	}
+	ASSERT(this->mesh)
+	this->mesh->render(matrix, color);
+}
+
 void TextWidget::setText(std::u32string&& text) {
-	this->lines.clear();
-	this->lines.emplace_back(std::move(text));
-	this->setRelayoutNeeded();
+	size_t erased = this->text_v.size();
+	this->text_v.assign(std::move(text));
+	this->onTextReplaced(0, erased, this->text_v.size());
+	this->onTextResized();
 	this->onTextChanged();
 }
 
-std::u32string TextWidget::getText() const {
-	std::u32string ret;
-	
-	for(auto& l : this->lines){
-		ret.append(l);
+void TextWidget::insertText(size_t pos, const std::u32string& str){
+	if(str.empty()){
+		return;
 	}
-	
-	return ret;
+	utki::clampTop(pos, this->text_v.size());
+	this->text_v.insert(pos, str);
+	this->onTextReplaced(pos, 0, str.size());
+	this->onTextResized();
+	this->onTextChanged();
+}
+
+void TextWidget::eraseText(size_t pos, size_t n){
+	if(pos >= this->text_v.size()){
+		return;
+	}
+	utki::clampTop(n, this->text_v.size() - pos);
+	if(n == 0){
+		return;
+	}
+	this->text_v.erase(pos, n);
+	this->onTextReplaced(pos, n, 0);
+	this->onTextResized();
+	this->onTextChanged();
+}
+
+void TextWidget::replaceText(size_t pos, size_t n, const std::u32string& str){
+	utki::clampTop(pos, this->text_v.size());
+	utki::clampTop(n, this->text_v.size() - pos);
+	this->text_v.replace(pos, n, str);
+	this->onTextReplaced(pos, n, str.size());
+	this->onTextResized();
+	this->onTextChanged();
 }
@@ -5,6 +5,8 @@
 
 #include "../../res/ResFont.hpp"
 
+#include "../../util/TextStorage.hpp"
+
 #include <kolme/Rectangle.hpp>
 
 #include <list>
@@ -19,8 +21,7 @@ namespace morda{
 class TextWidget : public ColorWidget{
 	std::shared_ptr<ResFont> font_v;
 	
-protected:
-	std::vector<std::u32string> lines;
+	TextStorage text_v;
 	
 public:
 	TextWidget(const TextWidget&) = delete;
@@ -38,7 +39,44 @@ public:
 	
 	void setText(std::u32string&& text);
 	
-	std::u32string getText()const;
+	/**
+	 * @brief Get copy of the text.
+	 * Use text() to access the text without copying it.
+	 * @return Copy of the text.
+	 */
+	std::u32string getText()const{
+		return this->text_v.str();
+	}
+	
+	/**
+	 * @brief Get text.
+	 * @return Text storage.
+	 */
+	const TextStorage& text()const noexcept{
+		return this->text_v;
+	}
+	
+	/**
+	 * @brief Insert text.
+	 * @param pos - index to insert the text at.
+	 * @param str - text to insert.
+	 */
+	void insertText(size_t pos, const std::u32string& str);
+	
+	/**
+	 * @brief Erase part of the text.
+	 * @param pos - index of the first character to erase.
+	 * @param n - number of characters to erase.
+	 */
+	void eraseText(size_t pos, size_t n);
+	
+	/**
+	 * @brief Replace part of the text.
+	 * @param pos - index of the first character to replace.
+	 * @param n - number of characters to replace.
+	 * @param str - text to put instead of the replaced characters.
+	 */
+	void replaceText(size_t pos, size_t n, const std::u32string& str);
 	
 	void clear(){
 		this->setText(std::u32string());
@@ -56,6 +94,26 @@ public:
 	
 protected:
 	TextWidget(const stob::Node* desc);
+	
+	/**
+	 * @brief Called when part of the text is replaced.
+	 * Called by all text modifying functions right after the text is modified and before onTextChanged().
+	 * Allows updating data derived from the text incrementally, only for the modified part of the text.
+	 * @param pos - index of the first replaced character.
+	 * @param erased - number of characters which were erased.
+	 * @param inserted - number of characters which were inserted at pos instead of erased ones.
+	 */
+	virtual void onTextReplaced(size_t pos, size_t erased, size_t inserted){}
+	
+	/**
+	 * @brief Called when the text is modified to update layout of the widget.
+	 * Called by all text modifying functions right after onTextReplaced() and before onTextChanged().
+	 * Default implementation requests re-layout of the widget.
+	 * Override it to skip re-layout when the text modification does not change measured size of the widget.
+	 */
+	virtual void onTextResized(){
+		this->setRelayoutNeeded();
+	}
 
 private:
 
@@ -63,7 +121,10 @@ private:
 
 
 class SingleLineTextWidget : public TextWidget{
-	mutable Rectr bb;
+	mutable Rectr bb = Rectr(0, 0, 0, 0);
+	
+	//text prepared for rendering, built on first render after the text or font is changed
+	mutable std::unique_ptr<TextMesh> mesh;
 	
 protected:
 	Vec2r measure(const morda::Vec2r& quotum)const noexcept override;
@@ -75,10 +136,24 @@ protected:
 	}
 	
 	void recomputeBoundingBox(){
-		this->bb = this->font().stringBoundingBox(this->getText());
+		//only chunks of the text which were changed since last time are measured
+		this->bb = this->text().boundingBox(this->font());
 	}
+	
+	/**
+	 * @brief Render the whole text.
+	 * Glyphs of the text are positioned once, after the text or font is changed, so
+	 * rendering unchanged text costs one draw call per glyph atlas page.
+	 * @param matrix - transformation matrix to use when rendering the text.
+	 * @param color - text color.
+	 */
+	void renderText(const morda::Matr4r& matrix, kolme::Vec4f color)const;
+	
+	void onTextResized()override;
 public:
 	void onFontChanged()override{
+		this->mesh.reset();
+		this->text().invalidateMetrics();
 		this->recomputeBoundingBox();
 	}
 
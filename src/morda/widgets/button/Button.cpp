@@ -24,6 +24,7 @@ void Button::setPressed(bool pressed) {
 	}
 	this->isPressed_v = pressed;
 	this->isPressedChangedNotified = false;
+	this->setRedrawNeeded();
 	this->onPressedChanged();
 }
 
@@ -3,6 +3,7 @@
 #include "../../Morda.hpp"
 
 #include "../group/Overlay.hpp"
+#include "../group/List.hpp"
 
 #include "../proxy/MouseProxy.hpp"
 
@@ -14,6 +15,8 @@
 
 #include "../base/TextWidget.hpp"
 
+#include <algorithm>
+
 
 
 
@@ -25,7 +28,7 @@ namespace{
 
 const auto selectorLayout_c = stob::parse(R"qwertyuiop(
 	layout{dx{max} dy{max}}
-
+	
 	Row{
 		layout{dx{max}}
 		Pile{
@@ -76,7 +79,7 @@ const char* contextMenuLayout_c = R"qwertyuiop(
 					dx{max}
 				}
 				image{morda_npt_contextmenu_bg}
-				Column{
+				VList{
 					layout{
 						dx{max}
 					}
@@ -94,74 +97,154 @@ const char* contextMenuLayout_c = R"qwertyuiop(
 
 
 class StaticProvider : public DropDownSelector::ItemsProvider{
-	std::vector<std::unique_ptr<stob::Node>> widgets;
+	std::shared_ptr<const Inflater::Prototype> prototype;
+	
+	std::vector<const stob::Node*> widgets;
 public:
-
+	StaticProvider(std::shared_ptr<const Inflater::Prototype> prototype) :
+			prototype(std::move(prototype))
+	{
+		for(auto n = this->prototype->chain(); n; n = n->nextNonProperty().node()){
+			this->widgets.push_back(n);
+		}
+	}
+	
 	size_t count() const noexcept override{
 		return this->widgets.size();
 	}
-
+	
 	std::shared_ptr<Widget> getWidget(size_t index)override{
 		return morda::Morda::inst().inflater.inflate(*(this->widgets[index]));
 	}
-
-
+	
+	
 	void recycle(size_t index, std::shared_ptr<Widget> w)override{
 //		TRACE(<< "StaticProvider::recycle(): index = " << index << std::endl)
 	}
+};
+	
+}
 
-
-	void add(std::unique_ptr<stob::Node> w){
-		this->widgets.push_back(std::move(w));
+class DropDownSelector::ListProvider : public List::ItemsProvider{
+	DropDownSelector& dds;
+	
+	std::vector<std::shared_ptr<Pile>> wrappersPool;
+public:
+	ListProvider(DropDownSelector& dds) :
+			dds(dds)
+	{}
+	
+	size_t count()const noexcept override{
+		if(!this->dds.provider){
+			return 0;
+		}
+		return this->dds.provider->count();
+	}
+	
+	std::shared_ptr<Widget> getWidget(size_t index)override{
+		ASSERT(this->dds.provider)
+		
+		std::shared_ptr<Pile> wd;
+		if(this->wrappersPool.size() != 0){
+			wd = std::move(this->wrappersPool.back());
+			this->wrappersPool.pop_back();
+		}
+		
+		return this->dds.wrapItem(std::move(wd), this->dds.provider->getWidget(index), index);
+	}
+	
+	void recycle(size_t index, std::shared_ptr<Widget> w)override{
+		auto wd = std::dynamic_pointer_cast<Pile>(w);
+		ASSERT(wd)
+		ASSERT(wd->children().size() != 0)
+		
+		auto item = wd->children().back()->removeFromParent();
+		
+		if(this->dds.provider){
+			this->dds.provider->recycle(index, std::move(item));
+		}
+		
+		this->wrappersPool.push_back(std::move(wd));
 	}
 };
 
-}
-
 void DropDownSelector::showDropdownMenu() {
 	if(!this->provider){
 		return;
 	}
-
+	
 	auto overlay = this->findAncestor<Overlay>();
 	if(!overlay){
 		throw Exc("DropDownSelector: no Overlay parent found");
 	}
-
-	auto np = morda::Morda::inst().inflater.inflate(*stob::parse(contextMenuLayout_c));
+	
+	auto np = morda::Morda::inst().inflater.inflate(contextMenuLayout_c);
 	ASSERT(np)
-
+	
 	auto minSizeSpacer = np->findById("minSizeSpacer");
-
+	
 	auto& lp = minSizeSpacer->getLayoutParams();
 	lp.dim.x = this->rect().d.x;
-
-	auto va = np->findByIdAs<morda::Column>("morda_contextmenu_content");
+	
+	auto va = np->findByIdAs<morda::VList>("morda_contextmenu_content");
 	ASSERT(va)
-
-	for(size_t i = 0; i != this->provider->count(); ++i){
-		va->add(this->wrapItem(this->provider->getWidget(i), i));
+	
+	auto lprovider = std::make_shared<ListProvider>(*this);
+	
+	//Items are virtualized, so it is not possible to measure them all. Assume that all items are of same height as the first one.
+	real itemHeight = 0;
+	if(this->provider->count() != 0){
+		auto w = lprovider->getWidget(0);
+		itemHeight = w->measure(Vec2r(-1)).y;
+		lprovider->recycle(0, std::move(w));
 	}
-
+	
+	Vec2r anchor = this->calcPosInParent(Vec2r(0), overlay) + Vec2r(0, this->rect().d.y);
+	
+	//the list should not be taller than the space below the selector, otherwise it would create widgets for all the items
+	{
+		using std::min;
+		using std::max;
+		real maxHeight = max(overlay->rect().d.y - anchor.y, itemHeight);
+		va->Widget::getLayoutParams().dim.y = min(itemHeight * real(this->provider->count()), maxHeight);
+	}
+	
+	va->setItemsProvider(std::move(lprovider));
+	
 	this->hoveredIndex = -1;
-
+	
+	auto vaWeak = utki::makeWeak(va);
+	
 	np->getByNameAs<MouseProxy>("contextMenuMouseProxy").mouseButton
-			= [this](Widget& w, bool isDown, const Vec2r pos, MouseButton_e button, unsigned id) -> bool{
+			= [this, vaWeak, itemHeight](Widget& w, bool isDown, const Vec2r pos, MouseButton_e button, unsigned id) -> bool{
+				switch(button){
+					case MouseButton_e::WHEEL_UP:
+					case MouseButton_e::WHEEL_DOWN:
+						if(isDown){
+							if(auto va = vaWeak.lock()){
+								va->scrollBy(button == MouseButton_e::WHEEL_UP ? -itemHeight : itemHeight);
+							}
+						}
+						return true;
+					default:
+						break;
+				}
+				
 				if(!isDown){
 					this->mouseButtonUpHandler(false);
 				}
-
+				
 				return true;
 			};
-
-	overlay->showContextMenu(np, this->calcPosInParent(Vec2r(0), overlay) + Vec2r(0, this->rect().d.y));
+	
+	overlay->showContextMenu(np, anchor);
 }
 
 bool DropDownSelector::onMouseButton(bool isDown, const morda::Vec2r& pos, MouseButton_e button, unsigned pointerID){
 	if(!isDown){
 		this->mouseButtonUpHandler(true);
 	}
-
+	
 	return this->NinePatchPushButton::onMouseButton(isDown, pos, button, pointerID);
 }
 
@@ -170,12 +253,12 @@ void DropDownSelector::mouseButtonUpHandler(bool isFirstOne) {
 	if(!oc){
 		throw Exc("No Overlay found in ancestors of DropDownSelector");
 	}
-
+	
 	auto dds = this->sharedFromThis(this);
 
 //	TRACE(<< "DropDownSelector::mouseButtonUpHandler(): this->hoveredIndex = " << this->hoveredIndex << std::endl)
 //	TRACE(<< "DropDownSelector::mouseButtonUpHandler(): isFirstOne = " << isFirstOne << std::endl)
-
+	
 	if(this->hoveredIndex < 0){
 		if(!isFirstOne){
 			morda::Morda::inst().postToUiThread([oc](){
@@ -187,7 +270,7 @@ void DropDownSelector::mouseButtonUpHandler(bool isFirstOne) {
 	this->setSelection(this->hoveredIndex);
 
 //	TRACE(<< "DropDownSelector::mouseButtonUpHandler(): selection set" << std::endl)
-
+	
 	morda::Morda::inst().postToUiThread([dds, oc](){
 //		TRACE(<< "DropDownSelector::mouseButtonUpHandler(): hiding context menu" << std::endl)
 		oc->hideContextMenu();
@@ -210,34 +293,28 @@ DropDownSelector::DropDownSelector(const stob::Node* chain) :
 		if(!b.isPressed()){
 			return;
 		}
-
+		
 		this->showDropdownMenu();
 	};
-
+	
 	if(!chain){
 		return;
 	}
-
+	
 	const stob::Node* n = chain->thisOrNextNonProperty().node();
-
+	
 	if(!n){
 		return;
 	}
-
-	std::shared_ptr<StaticProvider> p = std::make_shared<StaticProvider>();
-
-	for(; n; n = n->nextNonProperty().node()){
-		p->add(n->clone());
-	}
-
-	this->setItemsProvider(std::move(p));
+	
+	this->setItemsProvider(std::make_shared<StaticProvider>(morda::Morda::inst().inflater.compile(*n)));
 }
 
 void DropDownSelector::setItemsProvider(std::shared_ptr<ItemsProvider> provider){
 	if(provider && provider->dd){
 		throw Exc("DropDownSelector::setItemsProvider(): given provider is already set to some DropDownSelector");
 	}
-
+	
 	if(this->provider){
 		this->provider->dd = nullptr;
 	}
@@ -256,36 +333,39 @@ void DropDownSelector::ItemsProvider::notifyDataSetChanged(){
 
 void DropDownSelector::handleDataSetChanged(){
 	this->selectionContainer.removeAll();
-
+	
 	if(!this->provider){
 		return;
 	}
 	if(this->selectedItem_v >= this->provider->count()){
 		return;
 	}
-
+	
 	this->selectionContainer.add(this->provider->getWidget(this->selectedItem_v));
 }
 
 void DropDownSelector::setSelection(size_t i){
 	this->selectedItem_v = i;
-
+	
 	this->handleDataSetChanged();
 }
 
-std::shared_ptr<Widget> DropDownSelector::wrapItem(std::shared_ptr<Widget>&& w, size_t index) {
-	auto wd = std::dynamic_pointer_cast<Pile>(morda::Morda::inst().inflater.inflate(*stob::parse(itemLayout_c)));
+std::shared_ptr<Widget> DropDownSelector::wrapItem(std::shared_ptr<Pile>&& wd, std::shared_ptr<Widget>&& w, size_t index) {
+	if(!wd){
+		wd = std::dynamic_pointer_cast<Pile>(morda::Morda::inst().inflater.inflate(itemLayout_c));
+	}
 	ASSERT(wd)
-
+	
 	auto mp = wd->findByIdAs<MouseProxy>("morda_dropdown_mouseproxy");
 	ASSERT(mp)
-
+	
 	auto cl = wd->findByIdAs<Color>("morda_dropdown_color");
 	ASSERT(cl)
+	cl->setVisible(false);
 	auto clWeak = utki::makeWeak(cl);
-
+	
 	wd->add(w);
-
+	
 	mp->hoverChanged = [this, clWeak, index](Widget& w, unsigned id){
 		if(auto c = clWeak.lock()){
 			c->setVisible(w.isHovered());
@@ -298,6 +378,6 @@ std::shared_ptr<Widget> DropDownSelector::wrapItem(std::shared_ptr<Widget>&& w,
 			}
 		}
 	};
-
-	return wd;
+	
+	return std::move(wd);
 }
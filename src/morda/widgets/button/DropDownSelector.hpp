@@ -101,7 +101,9 @@ public:
 private:
 	void handleDataSetChanged();
 	
-	std::shared_ptr<Widget> wrapItem(std::shared_ptr<Widget>&& w, size_t index);
+	class ListProvider;
+	
+	std::shared_ptr<Widget> wrapItem(std::shared_ptr<Pile>&& wrapper, std::shared_ptr<Widget>&& w, size_t index);
 	
 	void showDropdownMenu();
 	
@@ -27,7 +27,7 @@ RadioButton::RadioButton(const stob::Node* chain) :
 		Button(chain),
 		ToggleButton(chain),
 		ChoiceButton(chain),
-		Pile(stob::parse(D_Layout).get())
+		Pile(morda::Morda::inst().inflater.compile(D_Layout)->chain())
 {
 	this->checkWidget = *this->children().rbegin();
 	ASSERT(this->checkWidget)
@@ -24,6 +24,7 @@ Tabs::Tabs(const stob::Node* chain) :
 void Tabs::setFiller(std::shared_ptr<ResImage> filler) {
 	this->filler = std::move(filler);
 	this->fillerTexture = this->filler->get();
+	this->setRedrawNeeded();
 }
 
 
@@ -58,6 +59,7 @@ morda::Vec2r Tabs::measure(const morda::Vec2r& quotum) const {
 			}
 		}
 		
+		M_MORDA_PROFILE_SCOPE("measure", typeid(*c), c->id)
 		d = c->measure(d);
 		
 		length += d.x;
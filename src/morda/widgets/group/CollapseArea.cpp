@@ -52,7 +52,7 @@ const char* layout_c = R"qwertyuiop(
 
 CollapseArea::CollapseArea(const stob::Node* chain) :
 		Widget(chain),
-		Column(stob::parse(layout_c).get())
+		Column(morda::Morda::inst().inflater.compile(layout_c)->chain())
 {
 	this->contentArea = this->findByIdAs<Pile>("content");
 	ASSERT(this->contentArea)
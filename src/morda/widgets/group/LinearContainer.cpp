@@ -105,6 +105,7 @@ void LinearContainer::layOut(){
 						d[transIndex] = lp.dim[transIndex];
 					}
 					if(d.x < 0 || d.y < 0){
+						M_MORDA_PROFILE_SCOPE("measure", typeid(**i), (*i)->id)
 						Vec2r md = (*i)->measure(d);
 						for(unsigned i = 0; i != md.size(); ++i){
 							if(d[i] < 0){
@@ -190,6 +191,7 @@ morda::Vec2r LinearContainer::measure(const morda::Vec2r& quotum)const{
 				d[longIndex] = lp.dim[longIndex];
 			}
 
+			M_MORDA_PROFILE_SCOPE("measure", typeid(**i), (*i)->id)
 			d = (*i)->measure(d);
 			info->measuredDim = d;
 
@@ -271,6 +273,7 @@ morda::Vec2r LinearContainer::measure(const morda::Vec2r& quotum)const{
 				d[transIndex] = lp.dim[transIndex];
 			}
 			
+			M_MORDA_PROFILE_SCOPE("measure", typeid(**i), (*i)->id)
 			d = (*i)->measure(d);
 			if(quotum[transIndex] < 0){
 				utki::clampBottom(height, d[transIndex]);
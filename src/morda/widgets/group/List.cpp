@@ -12,8 +12,17 @@ using namespace morda;
 namespace{
 
 class StaticProvider : public List::ItemsProvider{
-	std::vector<std::unique_ptr<stob::Node>> widgets;
+	std::shared_ptr<const Inflater::Prototype> prototype;
+	
+	std::vector<const stob::Node*> widgets;
 public:
+	StaticProvider(std::shared_ptr<const Inflater::Prototype> prototype) :
+			prototype(std::move(prototype))
+	{
+		for(auto n = this->prototype->chain(); n; n = n->nextNonProperty().node()){
+			this->widgets.push_back(n);
+		}
+	}
 
 	size_t count() const noexcept override{
 		return this->widgets.size();
@@ -28,11 +37,6 @@ public:
 	void recycle(size_t index, std::shared_ptr<Widget> w)override{
 //		TRACE(<< "StaticProvider::recycle(): index = " << index << std::endl)
 	}
-
-	
-	void add(std::unique_ptr<stob::Node> w){
-		this->widgets.push_back(std::move(w));
-	}
 };
 
 }
@@ -42,7 +46,8 @@ public:
 
 List::List(const stob::Node* chain, bool vertical):
 		Widget(chain),
-		OrientedWidget(nullptr, vertical)
+		OrientedWidget(nullptr, vertical),
+		KineticScrollWidget(chain)
 {
 	if(!chain){
 		return;
@@ -54,13 +59,7 @@ List::List(const stob::Node* chain, bool vertical):
 		return;
 	}
 	
-	std::shared_ptr<StaticProvider> p = std::make_shared<StaticProvider>();
-	
-	for(; n; n = n->nextNonProperty().node()){
-		p->add(n->clone());
-	}
-	
-	this->setItemsProvider(std::move(p));
+	this->setItemsProvider(std::make_shared<StaticProvider>(morda::Morda::inst().inflater.compile(*n)));
 }
 
 
@@ -308,7 +307,7 @@ void List::updateTailItemsInfo(){
 	for(size_t i = this->provider->count(); i != 0 && dim > 0; --i){
 		++this->numTailItems;
 		
-		auto w = this->provider->getWidget(i - 1);
+		auto w = this->provider->getMeasureWidget(i - 1);
 		ASSERT(w)
 		
 		auto& lp = this->getLayoutParamsAs<LayoutParams>(*w);
@@ -353,7 +352,7 @@ void List::scrollBy(real delta) {
 		
 		if(delta > 0){
 			ASSERT_INFO(
-					this->posIndex > this->addedIndex + this->children().size(),
+					this->posIndex >= this->addedIndex + this->children().size(),
 					"this->posIndex = " << this->posIndex
 					<< " this->addedIndex = " << this->addedIndex
 					<< " this->children().size() = " << this->children().size()
@@ -400,6 +399,155 @@ void List::scrollBy(real delta) {
 	this->updateChildrenList();
 }
 
+void List::scrollToItem(size_t index){
+	if(!this->provider || index >= this->provider->count()){
+		return;
+	}
+	
+	unsigned longIndex = this->getLongIndex();
+	
+	if(index < this->posIndex || (index == this->posIndex && this->posOffset > 0)){
+		this->posIndex = index;
+		this->posOffset = 0;
+		this->updateChildrenList();
+		return;
+	}
+	
+	if(this->addedIndex <= index && index < this->addedIndex + this->children().size()){
+		auto& w = *this->childrenArray()[index - this->addedIndex];
+		real end = w.rect().p[longIndex] + w.rect().d[longIndex];
+		if(end > this->rect().d[longIndex]){
+			this->scrollBy(std::min(end - this->rect().d[longIndex], w.rect().p[longIndex]));
+		}
+		return;
+	}
+	
+	//item is below the visible area, find first item to show so that the requested item is the last one
+	real d = this->rect().d[longIndex];
+	real sum = 0;
+	size_t i = index + 1;
+	for(; i != 0;){
+		--i;
+		auto w = this->provider->getMeasureWidget(i);
+		auto& lp = this->getLayoutParamsAs<LayoutParams>(*w);
+		sum += this->dimForWidget(*w, lp)[longIndex];
+		if(sum >= d){
+			break;
+		}
+	}
+	
+	this->posIndex = i;
+	this->posOffset = sum > d ? sum - d : 0;
+	
+	if(i == index){
+		//item is bigger than the list, show its beginning
+		this->posOffset = 0;
+	}
+	
+	this->updateChildrenList();
+}
+
+Vec2r List::kineticScrollBy(const Vec2r& delta){
+	unsigned longIndex = this->getLongIndex();
+	
+	real d = delta[longIndex];
+	
+	if(this->translateChildren(d)){
+		return Vec2r(0);
+	}
+	
+	size_t oldPosIndex = this->posIndex;
+	real oldPosOffset = this->posOffset;
+	
+	this->scrollBy(d);
+	
+	Vec2r ret(0);
+	
+	//NOTE: exact amount of the scroll delta which has not been applied is not known,
+	//      so consider the whole delta as not applied if scroll position has not changed.
+	if(d != 0 && this->posIndex == oldPosIndex && this->posOffset == oldPosOffset){
+		ret[longIndex] = d;
+	}
+	
+	return ret;
+}
+
+bool List::translateChildren(real delta){
+	if(delta == 0 || this->children().size() == 0 || this->addedIndex != this->posIndex || this->numTailItems == 0){
+		return false;
+	}
+	
+	unsigned longIndex = this->getLongIndex();
+	
+	real newOffset = this->posOffset + delta;
+	
+	//first item has to stay visible
+	if(newOffset < 0 || newOffset >= this->children().front()->rect().d[longIndex]){
+		return false;
+	}
+	
+	//scroll boundary
+	if(this->posIndex == this->firstTailItemIndex && newOffset > this->firstTailItemOffset){
+		return false;
+	}
+	
+	//added items have to cover the whole list
+	auto& last = *this->children().back();
+	if(last.rect().p[longIndex] + last.rect().d[longIndex] - delta < this->rect().d[longIndex]){
+		return false;
+	}
+	
+	this->posOffset = newOffset;
+	
+	for(auto& c : this->children()){
+		Vec2r p = c->rect().p;
+		p[longIndex] -= delta;
+		c->moveTo(p);
+	}
+	
+	this->setRedrawNeeded();
+	
+	return true;
+}
+
+void List::onKineticDragStarted(unsigned pointerID){
+	this->unhoverChildren(pointerID);
+}
+
+Vec2r List::kineticSnapDelta()const{
+	Vec2r ret(0);
+	
+	if(this->children().size() == 0){
+		return ret;
+	}
+	
+	unsigned longIndex = this->getLongIndex();
+	
+	real d = this->children().front()->rect().d[longIndex];
+	
+	if(this->posOffset * 2 < d){
+		ret[longIndex] = -this->posOffset;
+	}else{
+		ret[longIndex] = d - this->posOffset;
+	}
+	
+	return ret;
+}
+
+Vec2r List::childrenOffset()const noexcept{
+	return -this->overscroll().rounded();
+}
+
+bool List::onMouseButton(bool isDown, const morda::Vec2r& pos, MouseButton_e button, unsigned pointerID){
+	bool ret = this->Container::onMouseButton(isDown, pos, button, pointerID);
+	return this->handleKineticMouseButton(isDown, pos, button, pointerID) || ret;
+}
+
+bool List::onMouseMove(const morda::Vec2r& pos, unsigned pointerID){
+	bool dragging = this->handleKineticMouseMove(pos, pointerID);
+	return this->Container::onMouseMove(pos, pointerID) || dragging;
+}
+
 morda::Vec2r List::measure(const morda::Vec2r& quotum) const {
 	unsigned longIndex = this->getLongIndex();
 	unsigned transIndex = this->getTransIndex();
@@ -445,3 +593,153 @@ void List::handleDataSetChanged() {
 		this->dataSetChanged(*this);
 	}
 }
+
+
+
+void List::AsyncItemsProvider::request(size_t index){
+	if(this->items.find(index) != this->items.end()){
+		return;
+	}
+	this->items.insert(std::make_pair(index, Item()));
+	this->fetch(index);
+}
+
+void List::AsyncItemsProvider::dropFarItems(){
+	size_t farDistance = 2 * this->pageSize;
+	
+	for(auto i = this->items.begin(); i != this->items.end();){
+		size_t index = i->first;
+		size_t distance = index > this->lastIndex ? index - this->lastIndex : this->lastIndex - index;
+		
+		if(i->second.shown || distance <= farDistance){
+			++i;
+			continue;
+		}
+		
+		if(!i->second.widget){
+			this->cancel(index);
+		}
+		i = this->items.erase(i);
+	}
+}
+
+std::shared_ptr<Widget> List::AsyncItemsProvider::getWidget(size_t index){
+	bool forward = index >= this->lastIndex;
+	this->lastIndex = index;
+	
+	this->request(index);
+	
+	std::shared_ptr<Widget> ret;
+	{
+		auto i = this->items.find(index);
+		ASSERT(i != this->items.end())
+		auto& item = i->second;
+		
+		item.shown = true;
+		
+		if(item.widget){
+			ret = item.widget;
+		}else{
+			if(!item.placeholder){
+				item.placeholder = this->getPlaceholder(index);
+			}
+			ret = item.placeholder;
+		}
+	}
+	
+	//prefetch next page in the scroll direction
+	if(forward){
+		for(size_t i = index + 1; i <= index + this->pageSize && i < this->count(); ++i){
+			this->request(i);
+		}
+	}else{
+		for(size_t i = index; i != 0 && index - i < this->pageSize;){
+			--i;
+			this->request(i);
+		}
+	}
+	
+	this->dropFarItems();
+	
+	return ret;
+}
+
+std::shared_ptr<Widget> List::AsyncItemsProvider::getMeasureWidget(size_t index){
+	//item is not requested and not marked as shown, so measuring does not affect prefetching and dropping of items
+	auto i = this->items.find(index);
+	if(i != this->items.end()){
+		if(i->second.widget){
+			return i->second.widget;
+		}
+		if(i->second.placeholder){
+			return i->second.placeholder;
+		}
+	}
+	return this->getPlaceholder(index);
+}
+
+void List::AsyncItemsProvider::recycle(size_t index, std::shared_ptr<Widget> w){
+	auto i = this->items.find(index);
+	if(i == this->items.end()){
+		return;
+	}
+	
+	i->second.shown = false;
+	
+	this->dropFarItems();
+}
+
+void List::AsyncItemsProvider::fulfil(size_t index, std::function<std::shared_ptr<Widget>()>&& makeWidget){
+	auto p = utki::makeWeak(this->sharedFromThis(this));
+	
+	unsigned generation = this->generation.load();
+	
+	auto mw = std::make_shared<std::function<std::shared_ptr<Widget>()>>(std::move(makeWidget));
+	
+	Morda::inst().postToUiThread(
+		[p, index, generation, mw](){
+			auto provider = p.lock();
+			if(!provider || provider->generation != generation){
+				return;
+			}
+			
+			auto i = provider->items.find(index);
+			if(i == provider->items.end() || i->second.widget){
+				//item was cancelled or already fulfilled
+				return;
+			}
+			
+			auto& item = i->second;
+			
+			ASSERT(*mw)
+			item.widget = (*mw)();
+			
+			auto placeholder = std::move(item.placeholder);
+			
+			if(placeholder && placeholder->parent() && item.widget){
+				placeholder->replaceBy(item.widget);
+			}
+			
+			//tail items are measured using placeholders, re-measure them with the actual widget
+			if(auto list = provider->list){
+				if(list->numTailItems != 0 && index >= list->firstTailItemIndex){
+					list->numTailItems = 0;
+					list->setRelayoutNeeded();
+				}
+			}
+		}
+	);
+}
+
+void List::AsyncItemsProvider::notifyDataSetChanged(){
+	for(auto& i : this->items){
+		if(!i.second.widget){
+			this->cancel(i.first);
+		}
+	}
+	this->items.clear();
+	
+	++this->generation;
+	
+	this->ItemsProvider::notifyDataSetChanged();
+}
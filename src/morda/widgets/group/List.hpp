@@ -1,22 +1,29 @@
 #pragma once
 
+#include <map>
+#include <atomic>
+
 #include "../Widget.hpp"
 #include "../Container.hpp"
 
 #include "../base/OrientedWidget.hpp"
+#include "../base/KineticScrollWidget.hpp"
 
 namespace morda{
 
 /**
  * @brief Scrollable list widget.
  * This is a base class for vertical and horizontal lists.
+ * List supports kinetic scrolling, see KineticScrollWidget. Snap points of the List are
+ * at item boundaries.
  */
 class List :
 		//NOTE: order of virtual public and private declarations here matters for clang due to some bug,
 		//      see http://stackoverflow.com/questions/42427145/clang-cannot-cast-to-private-base-while-there-is-a-public-virtual-inheritance
 		virtual public Widget,
 		private Container,
-		protected OrientedWidget
+		protected OrientedWidget,
+		public KineticScrollWidget
 {
 	//index of the first item added to container as child
 	size_t addedIndex = size_t(-1);
@@ -30,6 +37,12 @@ class List :
 	
 protected:
 	List(const stob::Node* chain, bool vertical);
+	
+	Vec2r kineticScrollBy(const Vec2r& delta)override;
+	
+	Vec2r kineticSnapDelta()const override;
+	
+	void onKineticDragStarted(unsigned pointerID)override;
 public:
 	List(const List&) = delete;
 	List& operator=(const List&) = delete;
@@ -58,6 +71,18 @@ public:
 		 */
 		virtual std::shared_ptr<Widget> getWidget(size_t index) = 0;
 		
+		/**
+		 * @brief Get widget for item to measure it.
+		 * List calls this function to find out size of the item without showing it,
+		 * the returned widget is not added to the list and is not recycled.
+		 * Default implementation calls getWidget().
+		 * @param index - index of item to get widget for.
+		 * @return Widget for the requested item.
+		 */
+		virtual std::shared_ptr<Widget> getMeasureWidget(size_t index){
+			return this->getWidget(index);
+		}
+		
 		/**
 		 * @brief Recycle widget of item.
 		 * @param index - index of item to recycle widget of.
@@ -65,7 +90,98 @@ public:
 		 */
 		virtual void recycle(size_t index, std::shared_ptr<Widget> w){}
 		
-		void notifyDataSetChanged();
+		/**
+		 * @brief Notify about data set change.
+		 * The list will re-create all its item widgets on UI thread.
+		 * Overrides should call the base implementation.
+		 */
+		virtual void notifyDataSetChanged();
+	};
+		
+	/**
+	 * @brief Asynchronous list items provider.
+	 * Items provider for slow data sources, like database queries or file listings.
+	 * Instead of building the item widget synchronously, it returns a lightweight placeholder
+	 * widget right away and requests the actual item to be fetched. When the item's data is ready
+	 * the user calls fulfil() and the placeholder gets replaced by the actual item widget on UI thread.
+	 * Items ahead of the scroll direction are prefetched by pages of given size.
+	 * Fetches of items which have scrolled away before being fulfilled are cancelled.
+	 */
+	class AsyncItemsProvider : public ItemsProvider{
+		struct Item{
+			std::shared_ptr<Widget> widget;//nullptr if not yet fulfilled
+			std::shared_ptr<Widget> placeholder;//nullptr if item was requested as prefetch
+			bool shown = false;
+		};
+		
+		std::map<size_t, Item> items;
+		
+		const size_t pageSize;
+		
+		size_t lastIndex = 0;
+		
+		//incremented on every data set change to drop fulfilments of outdated fetches,
+		//read by fulfil() which can be called from any thread
+		std::atomic<unsigned> generation;
+		
+		void request(size_t index);
+		
+		void dropFarItems();
+	protected:
+		/**
+		 * @brief Constructor.
+		 * @param pageSize - number of items to prefetch ahead of the scroll direction.
+		 */
+		AsyncItemsProvider(size_t pageSize = 10) :
+				pageSize(pageSize),
+				generation(0)
+		{}
+		
+		/**
+		 * @brief Get placeholder widget for item.
+		 * Placeholder is shown in the list until the item is fulfilled.
+		 * For correct scrolling the placeholder should be of about the same size as the actual item widget.
+		 * @param index - index of the item to get placeholder for.
+		 * @return Placeholder widget.
+		 */
+		virtual std::shared_ptr<Widget> getPlaceholder(size_t index) = 0;
+		
+		/**
+		 * @brief Start fetching of item.
+		 * Called on UI thread. The implementation is supposed to start fetching of the item's data
+		 * asynchronously and call fulfil() when it is ready.
+		 * @param index - index of the item to fetch.
+		 */
+		virtual void fetch(size_t index) = 0;
+		
+		/**
+		 * @brief Cancel fetching of item.
+		 * Called on UI thread when the item which is being fetched is not needed anymore.
+		 * Calling fulfil() for cancelled item is allowed, it will be ignored.
+		 * @param index - index of the item to cancel fetching of.
+		 */
+		virtual void cancel(size_t index){}
+	public:
+		/**
+		 * @brief Fulfil the item.
+		 * This function is thread-safe.
+		 * @param index - index of the item to fulfil.
+		 * @param makeWidget - function which creates the item widget, it will be called on UI thread.
+		 */
+		void fulfil(size_t index, std::function<std::shared_ptr<Widget>()>&& makeWidget);
+		
+		/**
+		 * @brief Notify about data set change.
+		 * Cancels all pending fetches and drops all fetched items.
+		 * Should be called from UI thread.
+		 */
+		void notifyDataSetChanged()override;
+		
+		std::shared_ptr<Widget> getWidget(size_t index)override;
+		
+		std::shared_ptr<Widget> getMeasureWidget(size_t index)override;
+		
+		void recycle(size_t index, std::shared_ptr<Widget> w)override;
 	};
 	
 	void setItemsProvider(std::shared_ptr<ItemsProvider> provider = nullptr);
@@ -75,6 +191,12 @@ public:
 	
 	morda::Vec2r measure(const morda::Vec2r& quotum) const override;
 	
+	Vec2r childrenOffset()const noexcept override;
+	
+	bool onMouseButton(bool isDown, const morda::Vec2r& pos, MouseButton_e button, unsigned pointerID)override;
+	
+	bool onMouseMove(const morda::Vec2r& pos, unsigned pointerID)override;
+	
 	/**
 	 * @brief Get number of items currently visible.
 	 * @return Number of items which are currently visible, i.e. are not completely out of List's boundaries.
@@ -101,6 +223,15 @@ public:
 	 */
 	void scrollBy(real delta);
 	
+	/**
+	 * @brief Scroll the list to make item visible.
+	 * If the item is above the visible area it becomes the first visible item,
+	 * if it is below the visible area it becomes the last visible item.
+	 * Does nothing if the item is already fully visible.
+	 * @param index - index of the item to make visible.
+	 */
+	void scrollToItem(size_t index);
+	
 	/**
 	 * @brief Data set changed signal.
 	 * Emitted when list widget contents have actually been updated due to change in provider's model data set.
@@ -116,6 +247,9 @@ private:
 	
 	void updateTailItemsInfo();
 	
+	//scrolls by moving the added children if no items need to be added or removed, returns false otherwise
+	bool translateChildren(real delta);
+	
 	void handleDataSetChanged();
 };
 
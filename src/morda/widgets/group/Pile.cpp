@@ -56,6 +56,7 @@ morda::Vec2r Pile::measure(const morda::Vec2r& quotum)const{
 			}
 		}
 		
+		M_MORDA_PROFILE_SCOPE("measure", typeid(**i), (*i)->id)
 		d = (*i)->measure(d);
 		
 		for(unsigned j = 0; j != d.size(); ++j){
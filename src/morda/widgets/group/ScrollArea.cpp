@@ -11,32 +11,31 @@ using namespace morda;
 
 ScrollArea::ScrollArea(const stob::Node* chain) :
 		Widget(chain),
-		Container(chain)
+		Container(chain),
+		KineticScrollWidget(chain)
 {}
 
 
 
 bool ScrollArea::onMouseButton(bool isDown, const morda::Vec2r& pos, MouseButton_e button, unsigned pointerID) {
-	Vec2r d = -this->curScrollPos;
-	return this->Container::onMouseButton(isDown, pos - d, button, pointerID);
+	Vec2r d = -this->curScrollPos.rounded();
+	bool ret = this->Container::onMouseButton(isDown, pos - d, button, pointerID);
+	return this->handleKineticMouseButton(isDown, pos, button, pointerID) || ret;
 }
 
 
 
 bool ScrollArea::onMouseMove(const morda::Vec2r& pos, unsigned pointerID) {
-	Vec2r d = -this->curScrollPos;
-	return this->Container::onMouseMove(pos - d, pointerID);
+	bool dragging = this->handleKineticMouseMove(pos, pointerID);
+	
+	Vec2r d = -this->curScrollPos.rounded();
+	return this->Container::onMouseMove(pos - d, pointerID) || dragging;
 }
 
 
 
-void ScrollArea::render(const morda::Matr4r& matrix) const {
-	Vec2r d = -this->curScrollPos;
-	
-	Matr4r matr(matrix);
-	matr.translate(d);
-	
-	this->Container::render(matr);
+Vec2r ScrollArea::childrenOffset() const noexcept{
+	return -(this->curScrollPos + this->overscroll()).rounded();
 }
 
 void ScrollArea::clampScrollPos() {
@@ -56,6 +55,62 @@ void ScrollArea::setScrollPos(const Vec2r& newScrollPos) {
 	
 	this->clampScrollPos();
 	this->updateScrollFactor();
+	this->setRedrawNeeded();
+}
+
+
+
+Vec2r ScrollArea::kineticScrollBy(const Vec2r& delta){
+	Vec2r newScrollPos = this->curScrollPos + delta;
+	
+	Vec2r ret(0);
+	
+	for(unsigned i = 0; i != 2; ++i){
+		real maxPos = std::max(this->effectiveDim[i], real(0));
+		
+		if(newScrollPos[i] < 0){
+			ret[i] = newScrollPos[i];
+			newScrollPos[i] = 0;
+		}else if(newScrollPos[i] > maxPos){
+			ret[i] = newScrollPos[i] - maxPos;
+			newScrollPos[i] = maxPos;
+		}
+	}
+	
+	//NOTE: scroll position is not rounded here to allow slow scrolling, it is rounded when rendering
+	this->curScrollPos = newScrollPos;
+	this->updateScrollFactor();
+	this->setRedrawNeeded();
+	
+	return ret;
+}
+
+
+
+void ScrollArea::onKineticDragStarted(unsigned pointerID){
+	this->unhoverChildren(pointerID);
+}
+
+
+
+Vec2r ScrollArea::kineticSnapDelta()const{
+	Vec2r ret;
+	
+	for(unsigned i = 0; i != 2; ++i){
+		real page = this->rect().d[i];
+		
+		if(page <= 0 || this->effectiveDim[i] <= 0){
+			ret[i] = 0;
+			continue;
+		}
+		
+		real snapPos = std::round(this->curScrollPos[i] / page) * page;
+		utki::clampTop(snapPos, this->effectiveDim[i]);
+		
+		ret[i] = snapPos - this->curScrollPos[i];
+	}
+	
+	return ret;
 }
 
 
@@ -96,6 +151,7 @@ Vec2r ScrollArea::dimForWidget(const Widget& w, const LayoutParams& lp)const{
 		}
 	}
 	if(d.x < 0 || d.y < 0){
+		M_MORDA_PROFILE_SCOPE("measure", typeid(w), w.id)
 		Vec2r md = w.measure(d);
 		for(unsigned i = 0; i != md.size(); ++i){
 			if(d[i] < 0){
@@ -112,7 +168,7 @@ Vec2r ScrollArea::dimForWidget(const Widget& w, const LayoutParams& lp)const{
 
 void ScrollArea::arrangeWidgets() {
 	for(auto i = this->children().begin(); i != this->children().end(); ++i){
-		auto& lp = this->getLayoutParams(**i);
+		auto& lp = this->getLayoutParamsAs<Container::LayoutParams>(**i);
 		
 		auto d = this->dimForWidget(**i, lp);
 		
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Container.hpp"
+#include "../base/KineticScrollWidget.hpp"
 
 #include <functional>
 
@@ -16,8 +17,13 @@ namespace morda{
  * except 'max' value. If layout dimension is specified as 'max' then child widget will be stretched to the
  * parent (ScrollArea) size in case child's minimal size is less than ScrollArea size, otherwise child will be assigned
  * its minimal size.
+ * ScrollArea supports kinetic scrolling, see KineticScrollWidget. Snap points of the ScrollArea
+ * are at multiples of its own size, i.e. scrolling snaps to pages.
  */
-class ScrollArea : public Container{
+class ScrollArea :
+		public Container,
+		public KineticScrollWidget
+{
 	//offset from top left corner
 	Vec2r curScrollPos = Vec2r(0);
 	
@@ -30,6 +36,12 @@ class ScrollArea : public Container{
 protected:
 	Vec2r dimForWidget(const Widget& w, const LayoutParams& lp)const;
 
+	Vec2r kineticScrollBy(const Vec2r& delta)override;
+
+	Vec2r kineticSnapDelta()const override;
+	
+	void onKineticDragStarted(unsigned pointerID)override;
+
 public:
 	ScrollArea(const stob::Node* chain);
 	
@@ -41,7 +53,7 @@ public:
 	
 	bool onMouseMove(const morda::Vec2r& pos, unsigned pointerID)override;
 	
-	void render(const morda::Matr4r& matrix) const override;
+	Vec2r childrenOffset() const noexcept override;
 
 	morda::Vec2r measure(const morda::Vec2r& quotum) const override{
 		return this->Widget::measure(quotum);
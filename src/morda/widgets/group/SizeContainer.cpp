@@ -12,7 +12,7 @@ void SizeContainer::layOut() {
 	BlockedFlagGuard blockedFlagGuard(this->isBlocked);
 	for(auto& w : this->children()){
 		if(w->needsRelayout()){
-			auto d = this->dimForWidget(*w, this->getLayoutParams(*w));
+			auto d = this->dimForWidget(*w, this->getLayoutParamsAs<Container::LayoutParams>(*w));
 			w->resize(d);
 		}
 	}
@@ -418,7 +418,7 @@ public:
 		void uncollapse(const std::vector<size_t>& path);
 		void collapse(const std::vector<size_t>& path);
 		
-		void notifyDataSetChanged();
+		void notifyDataSetChanged()override;
 		
 		void notifyItemChanged(){
 			this->List::ItemsProvider::notifyDataSetChanged();
@@ -158,7 +158,7 @@ void morda::Window::setBackground(std::shared_ptr<Widget> w) {
 
 morda::Window::Window(const stob::Node* chain) :
 		Widget(chain),
-		Pile(stob::parse(windowDesc_c).get())
+		Pile(morda::Morda::inst().inflater.compile(windowDesc_c)->chain())
 {
 	this->setupWidgets();
 
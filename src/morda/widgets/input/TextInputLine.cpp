@@ -55,11 +55,18 @@ void TextInputLine::render(const morda::Matr4r& matrix) const{
 		
 		matr.translate(-this->textBoundingBox().p.x + this->xOffset, round((this->font().height() + this->font().ascender() - this->font().descender()) / 2));
 		
-		ASSERT(this->firstVisibleCharIndex <= this->getText().size())
+		ASSERT(this->firstVisibleCharIndex <= this->text().size())
+		
+		//only render characters which fit into the widget
+		size_t lastVisibleCharIndex = this->posToIndex(this->rect().d.x);
+		if(lastVisibleCharIndex != this->text().size()){
+			++lastVisibleCharIndex;
+		}
+		
 		this->font().renderString(
 				matr,
 				morda::colorToVec4f(this->color()),
-				this->getText().substr(this->firstVisibleCharIndex, this->getText().size() - this->firstVisibleCharIndex)
+				this->text().substr(this->firstVisibleCharIndex, lastVisibleCharIndex - this->firstVisibleCharIndex)
 			);
 	}
 	
@@ -118,7 +125,7 @@ Vec2r TextInputLine::measure(const morda::Vec2r& quotum)const noexcept{
 void TextInputLine::setCursorIndex(size_t index, bool selection){
 	this->cursorIndex = index;
 	
-	utki::clampTop(this->cursorIndex, this->getText().size());
+	utki::clampTop(this->cursorIndex, this->text().size());
 	
 	if(!selection){
 		this->selectionStartIndex = this->cursorIndex;
@@ -142,82 +149,57 @@ void TextInputLine::setCursorIndex(size_t index, bool selection){
 		return;
 	}
 	
-	ASSERT(this->firstVisibleCharIndex <= this->getText().size())
+	ASSERT(this->firstVisibleCharIndex <= this->text().size())
 	ASSERT(this->cursorIndex > this->firstVisibleCharIndex)
-	this->cursorPos = this->font().stringAdvance(
-			std::u32string(this->getText(), this->firstVisibleCharIndex, this->cursorIndex - this->firstVisibleCharIndex)
-		) + this->xOffset;
+	this->cursorPos = this->text().advance(this->font(), this->cursorIndex)
+			- this->text().advance(this->font(), this->firstVisibleCharIndex)
+			+ this->xOffset;
 	
 	ASSERT(this->cursorPos >= 0)
 	
 	if(this->cursorPos > this->rect().d.x - cursorWidth_c * morda::inst().units.dotsPerDp()){
 		this->cursorPos = this->rect().d.x - cursorWidth_c * morda::inst().units.dotsPerDp();
 		
-		this->xOffset = this->cursorPos;//start from rightmost cursor position
-		this->firstVisibleCharIndex = this->cursorIndex;
+		//find the first character which is at least partially visible when cursor is at the rightmost position
+		real firstVisiblePos = this->text().advance(this->font(), this->cursorIndex) - this->cursorPos;
 		
-		//calculate advance backwards
-		for(auto i = this->getText().rbegin() + (this->getText().size() - this->cursorIndex);
-				this->xOffset > 0;
-				++i
-			)
-		{
-			ASSERT(i != this->getText().rend())
-			this->xOffset -= this->font().charAdvance(*i);
-			ASSERT(this->firstVisibleCharIndex > 0)
+		this->firstVisibleCharIndex = this->text().indexAt(this->font(), firstVisiblePos);
+		if(this->firstVisibleCharIndex != 0 && this->text().advance(this->font(), this->firstVisibleCharIndex) > firstVisiblePos){
 			--this->firstVisibleCharIndex;
 		}
+		ASSERT(this->firstVisibleCharIndex <= this->cursorIndex)
+		
+		this->xOffset = this->text().advance(this->font(), this->firstVisibleCharIndex) - firstVisiblePos;
+		ASSERT(this->xOffset <= 0)
 	}
 }
 
 
 
 real TextInputLine::indexToPos(size_t index){
-	ASSERT(this->firstVisibleCharIndex <= this->getText().size())
+	ASSERT(this->firstVisibleCharIndex <= this->text().size())
 	
 	if(index <= this->firstVisibleCharIndex){
 		return 0;
 	}
 	
-	utki::clampTop(index, this->getText().size());
+	real ret = this->text().advance(this->font(), index)
+			- this->text().advance(this->font(), this->firstVisibleCharIndex)
+			+ this->xOffset;
 	
-	real ret = this->xOffset;
-	
-	for(auto i = this->getText().begin() + this->firstVisibleCharIndex;
-			i != this->getText().end() && index != this->firstVisibleCharIndex;
-			++i, --index
-		)
-	{
-		ret += this->font().charAdvance(*i);
-		if(ret >= this->rect().d.x){
-			ret = this->rect().d.x;
-			break;
-		}
-	}
+	utki::clampTop(ret, this->rect().d.x);
 	
 	return ret;
 }
 
 
-size_t TextInputLine::posToIndex(real pos){
-	size_t index = this->firstVisibleCharIndex;
-	real p = this->xOffset;
+size_t TextInputLine::posToIndex(real pos)const{
+	size_t index = this->text().indexAt(
+			this->font(),
+			pos - this->xOffset + this->text().advance(this->font(), this->firstVisibleCharIndex)
+		);
 	
-	for(auto i = this->getText().begin() + this->firstVisibleCharIndex; i != this->getText().end(); ++i){
-		real w = this->font().charAdvance(*i);
-		
-		if(pos < p + w){
-			if(pos < p + w / 2){
-				break;
-			}
-			p += w;
-			++index;
-			break;
-		}
-		
-		p += w;
-		++index;
-	}
+	utki::clampBottom(index, this->firstVisibleCharIndex);
 	
 	return index;
 }
@@ -225,6 +207,7 @@ size_t TextInputLine::posToIndex(real pos){
 
 void TextInputLine::update(std::uint32_t dt){
 	this->cursorBlinkVisible = !this->cursorBlinkVisible;
+	this->setRedrawNeeded();
 }
 
 void TextInputLine::onFocusChanged(){
@@ -234,6 +217,7 @@ void TextInputLine::onFocusChanged(){
 		this->startCursorBlinking();
 	}else{
 		this->stopUpdating();
+		this->setRedrawNeeded();
 	}
 }
 
@@ -246,6 +230,7 @@ void TextInputLine::onResize(){
 void TextInputLine::startCursorBlinking(){
 	this->stopUpdating();
 	this->cursorBlinkVisible = true;
+	this->setRedrawNeeded();
 	this->startUpdating(cursorBlinkPeriod_c);
 }
 
@@ -270,12 +255,12 @@ void TextInputLine::onCharacterInput(const std::u32string& unicode, Key_e key){
 		case Key_e::ENTER:
 			break;
 		case Key_e::RIGHT:
-			if(this->cursorIndex != this->getText().size()){
+			if(this->cursorIndex != this->text().size()){
 				size_t newIndex;
 				if(this->ctrlPressed){
 					bool spaceSkipped = false;
 					newIndex = this->cursorIndex;
-					for(auto i = this->getText().begin() + this->cursorIndex; i != this->getText().end(); ++i, ++newIndex){
+					for(auto i = this->text().iteratorAt(this->cursorIndex); i != this->text().end(); ++i, ++newIndex){
 						if(*i == std::uint32_t(' ')){
 							if(spaceSkipped){
 								break;
@@ -297,8 +282,8 @@ void TextInputLine::onCharacterInput(const std::u32string& unicode, Key_e key){
 				if(this->ctrlPressed){
 					bool spaceSkipped = false;
 					newIndex = this->cursorIndex;
-					for(auto i = this->getText().rbegin() + (this->getText().size() - this->cursorIndex);
-							i != this->getText().rend();
+					for(auto i = TextStorage::const_reverse_iterator(this->text().iteratorAt(this->cursorIndex));
+							i != this->text().rend();
 							++i, --newIndex
 						)
 					{
@@ -317,7 +302,7 @@ void TextInputLine::onCharacterInput(const std::u32string& unicode, Key_e key){
 			}
 			break;
 		case Key_e::END:
-			this->setCursorIndex(this->getText().size(), this->shiftPressed);
+			this->setCursorIndex(this->text().size(), this->shiftPressed);
 			break;
 		case Key_e::HOME:
 			this->setCursorIndex(0, this->shiftPressed);
@@ -327,10 +312,7 @@ void TextInputLine::onCharacterInput(const std::u32string& unicode, Key_e key){
 				this->setCursorIndex(this->deleteSelection());
 			}else{
 				if(this->cursorIndex != 0){
-					auto t = this->getText();
-					this->clear();
-					t.erase(t.begin() + (this->cursorIndex - 1));
-					this->setText(std::move(t));
+					this->eraseText(this->cursorIndex - 1, 1);
 					this->setCursorIndex(this->cursorIndex - 1);
 				}
 			}
@@ -339,11 +321,8 @@ void TextInputLine::onCharacterInput(const std::u32string& unicode, Key_e key){
 			if(this->thereIsSelection()){
 				this->setCursorIndex(this->deleteSelection());
 			}else{
-				if(this->cursorIndex < this->getText().size()){
-					auto t = this->getText();
-					this->clear();
-					t.erase(t.begin() + this->cursorIndex);
-					this->setText(std::move(t));
+				if(this->cursorIndex < this->text().size()){
+					this->eraseText(this->cursorIndex, 1);
 				}
 			}
 			this->startCursorBlinking();
@@ -354,7 +333,7 @@ void TextInputLine::onCharacterInput(const std::u32string& unicode, Key_e key){
 		case Key_e::A:
 			if(this->ctrlPressed){
 				this->selectionStartIndex = 0;
-				this->setCursorIndex(this->getText().size(), true);
+				this->setCursorIndex(this->text().size(), true);
 				break;
 			}
 			//fall through
@@ -364,10 +343,7 @@ void TextInputLine::onCharacterInput(const std::u32string& unicode, Key_e key){
 					this->cursorIndex = this->deleteSelection();
 				}
 				
-				auto t = this->getText();
-				this->clear();
-				t.insert(t.begin() + this->cursorIndex, unicode.begin(), unicode.end());
-				this->setText(std::move(t));
+				this->insertText(this->cursorIndex, unicode);
 				
 				this->setCursorIndex(this->cursorIndex + unicode.size());
 			}
@@ -392,10 +368,7 @@ size_t TextInputLine::deleteSelection(){
 		end = this->cursorIndex;
 	}
 	
-	auto t = this->getText();
-	this->clear();
-	t.erase(t.begin() + start, t.begin() + end);
-	this->setText(std::move(t));
+	this->eraseText(start, end - start);
 	
 	return start;
 }
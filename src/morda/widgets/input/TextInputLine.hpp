@@ -68,7 +68,7 @@ private:
 	
 	void startCursorBlinking();
 	
-	size_t posToIndex(real pos);
+	size_t posToIndex(real pos)const;
 	
 	real indexToPos(size_t index);
 	
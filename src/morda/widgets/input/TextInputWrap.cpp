@@ -1,16 +1,741 @@
 #include "TextInputWrap.hpp"
 
+#include "../../Morda.hpp"
 #include "../../util/util.hpp"
 
+
+#if M_OS == M_OS_WINDOWS
+#	ifdef DELETE
+#		undef DELETE
+#	endif
+#endif
+
+
 using namespace morda;
 
 
+
+namespace{
+const std::uint32_t cursorBlinkPeriod_c = 500; //milliseconds
+
+const real cursorWidth_c = real(1.0);
+
+const auto lineLayout_c = stob::parse("layout{dx{fill}}");
+}
+
+
+
+class TextInputWrap::LineWidget : public Widget{
+	friend class TextInputWrap;
+	
+	const TextInputWrap& owner;
+public:
+	size_t line;
+	
+	LineWidget(const TextInputWrap& owner, size_t line) :
+			Widget(lineLayout_c.get()),
+			owner(owner),
+			line(line)
+	{}
+	
+	Vec2r measure(const Vec2r& quotum)const override{
+		Vec2r ret(0);
+		
+		if(this->line < this->owner.numLines()){
+			ret.y = this->owner.wrapLine(this->line).size() * this->owner.font().height();
+		}
+		
+		for(unsigned i = 0; i != ret.size(); ++i){
+			if(quotum[i] >= 0){
+				ret[i] = quotum[i];
+			}
+		}
+		
+		return ret;
+	}
+	
+	void render(const Matr4r& matrix)const override;
+};
+
+
+
+class TextInputWrap::Provider : public List::ItemsProvider{
+	const TextInputWrap& owner;
+public:
+	//line widgets, those which are not in use are reused
+	std::vector<std::shared_ptr<LineWidget>> widgets;
+	
+	Provider(const TextInputWrap& owner) :
+			owner(owner)
+	{}
+	
+	size_t count()const noexcept override{
+		return this->owner.numLines();
+	}
+	
+	std::shared_ptr<Widget> getWidget(size_t index)override{
+		for(auto& w : this->widgets){
+			if(w.use_count() == 1 && !w->parent()){
+				w->line = index;
+				return w;
+			}
+		}
+		
+		auto w = std::make_shared<LineWidget>(this->owner, index);
+		this->widgets.push_back(w);
+		return w;
+	}
+};
+
+
+
 TextInputWrap::TextInputWrap(const stob::Node* chain) :
 		Widget(chain),
 		TextWidget(chain),
-		List(nullptr, true)
+		List(nullptr, true),
+		provider(std::make_shared<Provider>(*this))
 {
+	this->setClip(true);
+	
+	this->lines.emplace_back(0);
+	this->rebuildLineTree();
+	
+	this->List::setItemsProvider(this->provider);
+	
 	if(auto p = getProperty(chain, "text")){
 		this->setText(unikod::toUtf32(p->value()));
 	}
 }
+
+
+
+void TextInputWrap::rebuildLineTree(){
+	size_t n = this->lines.size();
+	
+	this->lineTree.assign(n + 1, 0);
+	
+	for(size_t i = 1; i <= n; ++i){
+		this->lineTree[i] += this->lines[i - 1].length + 1;
+		size_t j = i + (i & (~i + 1));
+		if(j <= n){
+			this->lineTree[j] += this->lineTree[i];
+		}
+	}
+}
+
+
+
+size_t TextInputWrap::lineStart(size_t line)const noexcept{
+	ASSERT(line < this->lines.size())
+	
+	size_t ret = 0;
+	for(size_t i = line; i != 0; i -= i & (~i + 1)){
+		ret += this->lineTree[i];
+	}
+	return ret;
+}
+
+
+
+size_t TextInputWrap::lineOf(size_t index)const noexcept{
+	size_t n = this->lines.size();
+	
+	size_t step = 1;
+	for(; step * 2 <= n; step *= 2){}
+	
+	//find number of lines which start at or before the index
+	size_t pos = 0;
+	for(; step != 0; step /= 2){
+		if(pos + step <= n && this->lineTree[pos + step] <= index){
+			pos += step;
+			index -= this->lineTree[pos];
+		}
+	}
+	
+	if(pos == n){
+		--pos;
+	}
+	
+	return pos;
+}
+
+
+
+void TextInputWrap::onTextReplaced(size_t pos, size_t erased, size_t inserted){
+	//line index still describes the old text here
+	size_t first = this->lineOf(pos);
+	size_t last = this->lineOf(pos + erased);
+	
+	size_t regionStart = this->lineStart(first);
+	size_t regionEnd = this->lineStart(last) + this->lines[last].length - erased + inserted;
+	
+	//split the replaced region of the new text to lines
+	std::vector<Line> newLines;
+	{
+		size_t length = 0;
+		this->text().forEachSpan(regionStart, regionEnd - regionStart, [&newLines, &length](const char32_t* p, size_t n){
+			for(auto e = p + n; p != e; ++p){
+				if(*p == U'\n'){
+					newLines.emplace_back(length);
+					length = 0;
+				}else{
+					++length;
+				}
+			}
+		});
+		newLines.emplace_back(length);
+	}
+	
+	if(newLines.size() == last - first + 1){
+		for(size_t i = 0; i != newLines.size(); ++i){
+			size_t delta = newLines[i].length - this->lines[first + i].length;
+			this->lines[first + i] = std::move(newLines[i]);
+			
+			//unsigned arithmetic wraps around, so negative deltas work as well
+			for(size_t j = first + i + 1; j < this->lineTree.size(); j += j & (~j + 1)){
+				this->lineTree[j] += delta;
+			}
+		}
+	}else{
+		this->lines.erase(this->lines.begin() + first, this->lines.begin() + last + 1);
+		this->lines.insert(this->lines.begin() + first, std::make_move_iterator(newLines.begin()), std::make_move_iterator(newLines.end()));
+		this->rebuildLineTree();
+	}
+	
+	auto adjust = [pos, erased, inserted](size_t& index){
+		if(index >= pos + erased){
+			index = index - erased + inserted;
+		}else if(index > pos){
+			index = pos;
+		}
+	};
+	adjust(this->cursorIndex);
+	adjust(this->selectionStartIndex);
+}
+
+
+
+void TextInputWrap::onFontChanged(){
+	for(auto& l : this->lines){
+		l.wrapWidth = -1;
+	}
+	this->TextWidget::onFontChanged();
+}
+
+
+
+const std::vector<size_t>& TextInputWrap::wrapLine(size_t line)const{
+	ASSERT(line < this->lines.size())
+	
+	auto& l = this->lines[line];
+	
+	real width = this->rect().d.x;
+	
+	if(l.wrapWidth == width && !l.rowStarts.empty()){
+		return l.rowStarts;
+	}
+	
+	l.rowStarts.clear();
+	l.rowStarts.push_back(0);
+	l.wrapWidth = width;
+	
+	if(width <= 0){
+		return l.rowStarts;
+	}
+	
+	auto& font = this->font();
+	
+	size_t start = this->lineStart(line);
+	
+	real x = 0;
+	size_t rowStart = 0;
+	size_t breakPos = 0;//position after the last space in the row
+	
+	auto iter = this->text().iteratorAt(start);
+	for(size_t i = 0; i != l.length; ++i, ++iter){
+		char32_t c = *iter;
+		real advance = font.charAdvance(c);
+		if(i != rowStart){
+			x += font.kerning(*std::prev(iter), c);
+		}
+		
+		//spaces are allowed to go beyond the right edge
+		if(x + advance > width && i != rowStart && c != U' '){
+			rowStart = breakPos > rowStart ? breakPos : i;
+			l.rowStarts.push_back(rowStart);
+			
+			x = 0;
+			auto j = this->text().iteratorAt(start + rowStart);
+			for(size_t k = rowStart; k != i; ++k, ++j){
+				x += font.charAdvance(*j) + font.kerning(*j, *std::next(j));
+			}
+			breakPos = rowStart;
+		}
+		
+		x += advance;
+		
+		if(c == U' '){
+			breakPos = i + 1;
+		}
+	}
+	
+	return l.rowStarts;
+}
+
+
+
+real TextInputWrap::baseline()const{
+	return std::round((this->font().height() + this->font().ascender() - this->font().descender()) / 2);
+}
+
+
+
+std::pair<size_t, real> TextInputWrap::rowAndX(size_t line, size_t index)const{
+	auto& rows = this->wrapLine(line);
+	
+	size_t col = index - this->lineStart(line);
+	
+	auto r = std::upper_bound(rows.begin(), rows.end(), col);
+	ASSERT(r != rows.begin())
+	--r;
+	
+	return std::make_pair(
+			size_t(r - rows.begin()),
+			this->font().stringAdvance(this->text().substr(index - (col - *r), col - *r))
+		);
+}
+
+
+
+size_t TextInputWrap::indexInLine(size_t line, const Vec2r& pos)const{
+	auto& rows = this->wrapLine(line);
+	
+	size_t row = pos.y <= 0 ? 0 : size_t(pos.y / this->font().height());
+	utki::clampTop(row, rows.size() - 1);
+	
+	size_t start = this->lineStart(line);
+	
+	size_t index = start + rows[row];
+	size_t end = start + (row + 1 == rows.size() ? this->lines[line].length : rows[row + 1] - 1);
+	
+	real p = 0;
+	for(auto i = this->text().iteratorAt(index); index != end; ++i, ++index){
+		real w = this->font().charAdvance(*i);
+		if(index != start + rows[row]){
+			p += this->font().kerning(*std::prev(i), *i);
+		}
+		
+		if(pos.x < p + w / 2){
+			break;
+		}
+		p += w;
+	}
+	
+	return index;
+}
+
+
+
+size_t TextInputWrap::posToIndex(const Vec2r& pos)const{
+	//find the shown line widget nearest to the position
+	const LineWidget* nearest = nullptr;
+	real nearestDistance = 0;
+	
+	for(auto& w : this->provider->widgets){
+		if(!w->parent() || w->line >= this->numLines()){
+			continue;
+		}
+		
+		auto& r = w->rect();
+		real distance;
+		if(pos.y < r.p.y){
+			distance = r.p.y - pos.y;
+		}else if(pos.y >= r.p.y + r.d.y){
+			distance = pos.y - (r.p.y + r.d.y) + 1;
+		}else{
+			distance = 0;
+		}
+		
+		if(!nearest || distance < nearestDistance){
+			nearest = w.get();
+			nearestDistance = distance;
+		}
+	}
+	
+	if(!nearest){
+		return this->text().size();
+	}
+	
+	Vec2r p = pos - nearest->rect().p;
+	utki::clampRange(p.y, real(0), std::max(nearest->rect().d.y - 1, real(0)));
+	
+	return this->indexInLine(nearest->line, p);
+}
+
+
+
+void TextInputWrap::LineWidget::render(const Matr4r& matrix)const{
+	auto& o = this->owner;
+	
+	if(this->line >= o.numLines()){
+		return;
+	}
+	
+	auto& rows = o.wrapLine(this->line);
+	size_t start = o.lineStart(this->line);
+	size_t length = o.lines[this->line].length;
+	
+	real h = o.font().height();
+	
+	auto& r = morda::inst().renderer();
+	
+	auto rowEnd = [&rows, length](size_t row){
+		return row + 1 == rows.size() ? length : rows[row + 1];
+	};
+	
+	//render selection
+	if(o.thereIsSelection()){
+		size_t selBegin = std::min(o.cursorIndex, o.selectionStartIndex);
+		size_t selEnd = std::max(o.cursorIndex, o.selectionStartIndex);
+		
+		for(size_t i = 0; i != rows.size(); ++i){
+			size_t b = std::max(selBegin, start + rows[i]);
+			size_t e = std::min(selEnd, start + rowEnd(i));
+			
+			if(b >= e){
+				continue;
+			}
+			
+			real x = o.font().stringAdvance(o.text().substr(start + rows[i], b - start - rows[i]));
+			real w = o.font().stringAdvance(o.text().substr(b, e - b));
+			
+			Matr4r matr(matrix);
+			matr.translate(x, real(i) * h);
+			matr.scale(Vec2r(w, h));
+			r.shader->colorPos->render(matr, *r.posQuad01VAO, 0xff804040);
+		}
+	}
+	
+	//render text
+	for(size_t i = 0; i != rows.size(); ++i){
+		Matr4r matr(matrix);
+		matr.translate(0, real(i) * h + o.baseline());
+		
+		o.font().renderString(
+				matr,
+				morda::colorToVec4f(o.color()),
+				o.text().substr(start + rows[i], rowEnd(i) - rows[i])
+			);
+	}
+	
+	//render cursor
+	if(o.isFocused() && o.cursorBlinkVisible && o.lineOf(o.cursorIndex) == this->line){
+		auto rx = o.rowAndX(this->line, o.cursorIndex);
+		
+		Matr4r matr(matrix);
+		matr.translate(rx.second, real(rx.first) * h);
+		matr.scale(Vec2r(cursorWidth_c * morda::inst().units.dotsPerDp(), h));
+		
+		r.shader->colorPos->render(matr, *r.posQuad01VAO, o.color());
+	}
+}
+
+
+
+void TextInputWrap::setCursorIndex(size_t index, bool selection){
+	this->cursorIndex = index;
+	
+	utki::clampTop(this->cursorIndex, this->text().size());
+	
+	if(!selection){
+		this->selectionStartIndex = this->cursorIndex;
+	}
+	
+	this->cursorX = -1;
+	
+	if(!this->isFocused()){
+		this->focus();
+	}
+	this->startCursorBlinking();
+	
+	this->List::scrollToItem(this->lineOf(this->cursorIndex));
+}
+
+
+
+void TextInputWrap::moveCursorVertically(bool down){
+	size_t line = this->lineOf(this->cursorIndex);
+	
+	auto rx = this->rowAndX(line, this->cursorIndex);
+	
+	if(this->cursorX < 0){
+		this->cursorX = rx.second;
+	}
+	
+	size_t row;
+	
+	if(down){
+		if(rx.first + 1 < this->wrapLine(line).size()){
+			row = rx.first + 1;
+		}else if(line + 1 < this->numLines()){
+			++line;
+			row = 0;
+		}else{
+			this->setCursorIndex(this->text().size(), this->shiftPressed);
+			return;
+		}
+	}else{
+		if(rx.first != 0){
+			row = rx.first - 1;
+		}else if(line != 0){
+			--line;
+			row = this->wrapLine(line).size() - 1;
+		}else{
+			this->setCursorIndex(0, this->shiftPressed);
+			return;
+		}
+	}
+	
+	real x = this->cursorX;
+	this->setCursorIndex(
+			this->indexInLine(line, Vec2r(x, (real(row) + real(0.5)) * this->font().height())),
+			this->shiftPressed
+		);
+	this->cursorX = x;
+}
+
+
+
+bool TextInputWrap::onMouseButton(bool isDown, const morda::Vec2r& pos, MouseButton_e button, unsigned pointerId){
+	switch(button){
+		case MouseButton_e::LEFT:
+			this->leftMouseButtonDown = isDown;
+			if(isDown){
+				this->setCursorIndex(this->posToIndex(pos), this->shiftPressed);
+			}
+			return true;
+		case MouseButton_e::WHEEL_UP:
+		case MouseButton_e::WHEEL_DOWN:
+			if(isDown){
+				real delta = 3 * this->font().height();
+				this->List::scrollBy(button == MouseButton_e::WHEEL_UP ? -delta : delta);
+			}
+			return true;
+		default:
+			return this->List::onMouseButton(isDown, pos, button, pointerId);
+	}
+}
+
+
+
+bool TextInputWrap::onMouseMove(const morda::Vec2r& pos, unsigned pointerId){
+	if(!this->leftMouseButtonDown){
+		return this->List::onMouseMove(pos, pointerId);
+	}
+	
+	this->setCursorIndex(this->posToIndex(pos), true);
+	return true;
+}
+
+
+
+void TextInputWrap::update(std::uint32_t dt){
+	this->cursorBlinkVisible = !this->cursorBlinkVisible;
+	this->setRedrawNeeded();
+}
+
+
+
+void TextInputWrap::onFocusChanged(){
+	if(this->isFocused()){
+		this->ctrlPressed = false;
+		this->shiftPressed = false;
+		this->startCursorBlinking();
+	}else{
+		this->stopUpdating();
+		this->setRedrawNeeded();
+	}
+}
+
+
+
+void TextInputWrap::startCursorBlinking(){
+	this->stopUpdating();
+	this->cursorBlinkVisible = true;
+	this->setRedrawNeeded();
+	this->startUpdating(cursorBlinkPeriod_c);
+}
+
+
+
+bool TextInputWrap::onKey(bool isDown, Key_e keyCode){
+	switch(keyCode){
+		case Key_e::LEFT_CONTROL:
+		case Key_e::RIGHT_CONTROL:
+			this->ctrlPressed = isDown;
+			break;
+		case Key_e::LEFT_SHIFT:
+		case Key_e::RIGHT_SHIFT:
+			this->shiftPressed = isDown;
+			break;
+		default:
+			break;
+	}
+	return false;
+}
+
+
+
+void TextInputWrap::onCharacterInput(const std::u32string& unicode, Key_e key){
+	switch(key){
+		case Key_e::RIGHT:
+			if(this->cursorIndex != this->text().size()){
+				size_t newIndex;
+				if(this->ctrlPressed){
+					bool spaceSkipped = false;
+					newIndex = this->cursorIndex;
+					for(auto i = this->text().iteratorAt(this->cursorIndex); i != this->text().end(); ++i, ++newIndex){
+						if(*i == std::uint32_t(' ') || *i == std::uint32_t('\n')){
+							if(spaceSkipped){
+								break;
+							}
+						}else{
+							spaceSkipped = true;
+						}
+					}
+				}else{
+					newIndex = this->cursorIndex + 1;
+				}
+				this->setCursorIndex(newIndex, this->shiftPressed);
+			}
+			break;
+		case Key_e::LEFT:
+			if(this->cursorIndex != 0){
+				size_t newIndex;
+				if(this->ctrlPressed){
+					bool spaceSkipped = false;
+					newIndex = this->cursorIndex;
+					for(auto i = TextStorage::const_reverse_iterator(this->text().iteratorAt(this->cursorIndex));
+							i != this->text().rend();
+							++i, --newIndex
+						)
+					{
+						if(*i == std::uint32_t(' ') || *i == std::uint32_t('\n')){
+							if(spaceSkipped){
+								break;
+							}
+						}else{
+							spaceSkipped = true;
+						}
+					}
+				}else{
+					newIndex = this->cursorIndex - 1;
+				}
+				this->setCursorIndex(newIndex, this->shiftPressed);
+			}
+			break;
+		case Key_e::UP:
+			this->moveCursorVertically(false);
+			break;
+		case Key_e::DOWN:
+			this->moveCursorVertically(true);
+			break;
+		case Key_e::PAGE_UP:
+		case Key_e::PAGE_DOWN:
+			{
+				size_t line = this->lineOf(this->cursorIndex);
+				size_t page = std::max(this->List::visibleCount(), size_t(1));
+				if(key == Key_e::PAGE_UP){
+					line = line > page ? line - page : 0;
+				}else{
+					line = std::min(line + page, this->numLines() - 1);
+				}
+				
+				real x = this->cursorX < 0 ? this->rowAndX(this->lineOf(this->cursorIndex), this->cursorIndex).second : this->cursorX;
+				this->setCursorIndex(this->indexInLine(line, Vec2r(x, 0)), this->shiftPressed);
+				this->cursorX = x;
+			}
+			break;
+		case Key_e::END:
+			if(this->ctrlPressed){
+				this->setCursorIndex(this->text().size(), this->shiftPressed);
+			}else{
+				size_t line = this->lineOf(this->cursorIndex);
+				this->setCursorIndex(this->lineStart(line) + this->lines[line].length, this->shiftPressed);
+			}
+			break;
+		case Key_e::HOME:
+			if(this->ctrlPressed){
+				this->setCursorIndex(0, this->shiftPressed);
+			}else{
+				this->setCursorIndex(this->lineStart(this->lineOf(this->cursorIndex)), this->shiftPressed);
+			}
+			break;
+		case Key_e::BACKSPACE:
+			if(this->thereIsSelection()){
+				this->setCursorIndex(this->deleteSelection());
+			}else{
+				if(this->cursorIndex != 0){
+					size_t index = this->cursorIndex - 1;
+					this->eraseText(index, 1);
+					this->setCursorIndex(index);
+				}
+			}
+			break;
+		case Key_e::DELETE:
+			if(this->thereIsSelection()){
+				this->setCursorIndex(this->deleteSelection());
+			}else{
+				if(this->cursorIndex < this->text().size()){
+					this->eraseText(this->cursorIndex, 1);
+				}
+			}
+			this->startCursorBlinking();
+			break;
+		case Key_e::ESCAPE:
+			//do nothing
+			break;
+		case Key_e::A:
+			if(this->ctrlPressed){
+				this->selectionStartIndex = 0;
+				this->setCursorIndex(this->text().size(), true);
+				break;
+			}
+			//fall through
+		default:
+			{
+				std::u32string str = key == Key_e::ENTER ? std::u32string(U"\n") : unicode;
+				
+				if(str.size() != 0){
+					if(this->thereIsSelection()){
+						this->cursorIndex = this->deleteSelection();
+					}
+					
+					size_t index = this->cursorIndex;
+					this->insertText(index, str);
+					
+					this->setCursorIndex(index + str.size());
+				}
+			}
+			break;
+	}
+}
+
+
+
+size_t TextInputWrap::deleteSelection(){
+	ASSERT(this->cursorIndex != this->selectionStartIndex)
+	
+	size_t start, end;
+	if(this->cursorIndex < this->selectionStartIndex){
+		start = this->cursorIndex;
+		end = this->selectionStartIndex;
+	}else{
+		start = this->selectionStartIndex;
+		end = this->cursorIndex;
+	}
+	
+	this->eraseText(start, end - start);
+	
+	return start;
+}
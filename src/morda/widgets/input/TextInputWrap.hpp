@@ -4,21 +4,156 @@
 #include "../group/List.hpp"
 #include "../base/TextWidget.hpp"
 
+#include "../../Updateable.hpp"
+#include "../CharInputWidget.hpp"
+
 namespace morda{
 
+/**
+ * @brief Multi-line text input widget.
+ * Text is split to lines by newline characters, each line is wrapped to the width of the widget.
+ * The widget is virtualized, i.e. only the lines which are currently visible are wrapped and rendered,
+ * so it can handle texts with huge number of lines.
+ * From GUI script it can be instantiated as "TextInputWrap".
+ *
+ * @param text - initial text.
+ */
 class TextInputWrap :
 		public virtual Widget,
 		public TextWidget,
-		private List
+		private List,
+		private Updateable,
+		public CharInputWidget
 {
+	class LineWidget;
+	class Provider;
+	
+	struct Line{
+		//number of characters in the line, not counting the newline character
+		size_t length;
+		
+		//wrapping cache, offsets of the rows within the line
+		mutable std::vector<size_t> rowStarts;
+		mutable real wrapWidth = -1;
+		
+		Line(size_t length) :
+				length(length)
+		{}
+	};
+	
+	std::vector<Line> lines;
+	
+	//Fenwick tree over line lengths including newline characters, gives line start indices in O(log(lines))
+	std::vector<size_t> lineTree;
+	
+	std::shared_ptr<Provider> provider;
+	
+	size_t cursorIndex = 0;
+	
+	size_t selectionStartIndex = 0;
+	
+	//horizontal position to keep when moving cursor up and down, negative if not set
+	real cursorX = -1;
+	
+	bool cursorBlinkVisible = false;
+	
+	bool ctrlPressed = false;
+	bool shiftPressed = false;
+	
+	bool leftMouseButtonDown = false;
+
 public:
 	TextInputWrap(const stob::Node* chain);
 	
 	TextInputWrap(const TextInputWrap&) = delete;
 	TextInputWrap& operator=(const TextInputWrap&) = delete;
 	
-private:
+	/**
+	 * @brief Get number of lines.
+	 * @return Number of lines in the text, it is the number of newline characters plus one.
+	 */
+	size_t numLines()const noexcept{
+		return this->lines.size();
+	}
+	
+	/**
+	 * @brief Get index of the first character of the line.
+	 * @param line - line number.
+	 * @return Index of the first character of the line in the text.
+	 */
+	size_t lineStart(size_t line)const noexcept;
+	
+	/**
+	 * @brief Get line number containing the character.
+	 * @param index - index of the character in the text.
+	 * @return Number of the line which contains the character.
+	 */
+	size_t lineOf(size_t index)const noexcept;
+	
+	/**
+	 * @brief Set cursor position.
+	 * Scrolls the text to make cursor visible.
+	 * @param index - index of the character in the text to put cursor before.
+	 * @param selection - whether to extend the selection (true) or to drop it (false).
+	 */
+	void setCursorIndex(size_t index, bool selection = false);
+	
+	/**
+	 * @brief Get cursor position.
+	 * @return Index of the character in the text the cursor is before.
+	 */
+	size_t getCursorIndex()const noexcept{
+		return this->cursorIndex;
+	}
+	
+	using List::scrollBy;
+	using List::scrollFactor;
+	using List::setScrollPosAsFactor;
+	
+	bool onMouseButton(bool isDown, const morda::Vec2r& pos, MouseButton_e button, unsigned pointerId)override;
+	
+	bool onMouseMove(const morda::Vec2r& pos, unsigned pointerId)override;
+	
+	void onFocusChanged()override;
+	
+	bool onKey(bool isDown, Key_e keyCode)override;
+	
+	void update(std::uint32_t dt)override;
+	
+	void onCharacterInput(const std::u32string& unicode, Key_e key)override;
+	
+	void onFontChanged()override;
 
-};
+protected:
+	void onTextReplaced(size_t pos, size_t erased, size_t inserted)override;
 
+private:
+	void rebuildLineTree();
+	
+	//returns row starts of the line wrapped to current width
+	const std::vector<size_t>& wrapLine(size_t line)const;
+	
+	real baseline()const;
+	
+	//returns index of the character at given position within the line
+	size_t indexInLine(size_t line, const Vec2r& pos)const;
+	
+	//returns index of the character at given position within the widget
+	size_t posToIndex(const Vec2r& pos)const;
+	
+	//returns row of the line and horizontal position of the character within the row
+	std::pair<size_t, real> rowAndX(size_t line, size_t index)const;
+	
+	void moveCursorVertically(bool down);
+	
+	void startCursorBlinking();
+	
+	bool thereIsSelection()const noexcept{
+		return this->cursorIndex != this->selectionStartIndex;
+	}
+	
+	//returns new cursor index
+	size_t deleteSelection();
+};
+	
 }
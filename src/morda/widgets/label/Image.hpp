@@ -55,6 +55,7 @@ public:
 	void setRepeat(decltype(repeat_v) r){
 		this->repeat_v = r;
 		this->scaledImage.reset();
+		this->setRedrawNeeded();
 	}
 	
 	void setKeepAspectRatio(bool keepAspectRatio){
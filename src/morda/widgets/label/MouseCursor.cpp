@@ -22,6 +22,7 @@ void MouseCursor::setCursor(std::shared_ptr<const ResCursor> cursor) {
 	if(this->cursor){
 		this->quadTex = this->cursor->image().get();
 	}
+	this->setRedrawNeeded();
 }
 
 bool MouseCursor::onMouseMove(const morda::Vec2r& pos, unsigned pointerID) {
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <utki/util.hpp>
 #include <utki/types.hpp>
 
@@ -11,92 +13,14 @@
 using namespace morda;
 
 
-namespace{
-const char* ninePatchLayout_c = R"qwertyuiop(
-		Row{
-			layout{dx{fill}}
-			Image{
-				id{morda_lt}
-			}
-
-			Image{
-				layout{dx{0}weight{1}}
-				id{morda_t}
-			}
-
-			Image{
-				id{morda_rt}
-			}
-		}
-
-		Row{
-			layout{
-				dx{max}
-				weight{1}
-			}
-
-			Image{
-				id{morda_l}
-				layout{dy{fill}}
-			}
-
-			Pile{
-				id{morda_content}
-				layout{
-					weight{1}
-					dy{max}
-				}
-
-				Image{
-					id{morda_m}
-					layout{dx{fill}dy{fill}}
-				}
-			}
-			Image{
-				id{morda_r}
-				layout{dy{fill}}
-			}
-		}
-
-		Row{
-			layout{dx{fill}}
-			Image{
-				id{morda_lb}
-			}
-
-			Image{
-				layout{dx{0}weight{1}}
-				id{morda_b}
-			}
-
-			Image{
-				id{morda_rb}
-			}
-		}
-	)qwertyuiop";
-}
-
-
 NinePatch::NinePatch(const stob::Node* chain) :
 		Widget(chain),
 		BlendingWidget(chain),
-		Column(stob::parse(ninePatchLayout_c).get())
+		Container(nullptr),
+		content_v(std::make_shared<Pile>())
 {
-	this->imageMatrix_v[0][0] = this->findByIdAs<Image>("morda_lt");
-	this->imageMatrix_v[0][1] = this->findByIdAs<Image>("morda_t");
-	this->imageMatrix_v[0][2] = this->findByIdAs<Image>("morda_rt");
-
-	this->imageMatrix_v[1][0] = this->findByIdAs<Image>("morda_l");
-	this->imageMatrix_v[1][1] = this->findByIdAs<Image>("morda_m");
-	this->imageMatrix_v[1][2] = this->findByIdAs<Image>("morda_r");
-
-	this->imageMatrix_v[2][0] = this->findByIdAs<Image>("morda_lb");
-	this->imageMatrix_v[2][1] = this->findByIdAs<Image>("morda_b");
-	this->imageMatrix_v[2][2] = this->findByIdAs<Image>("morda_rb");
-
-	this->onBlendingChanged();
-
-	this->content_v = this->findByIdAs<Pile>("morda_content");
+	this->content_v->id = "morda_content";
+	this->Container::add(this->content_v);
 
 	if(auto n = getProperty(chain, "left")){
 		this->borders.left() = dimValueFromSTOB(*n);//'min' is by default, but not allowed to specify explicitly, as well as 'max' and 'fill'
@@ -126,7 +50,6 @@ NinePatch::NinePatch(const stob::Node* chain) :
 		this->setCenterVisible(n->asBool());
 	}
 
-	//this should go after setting up border widgets
 	if(const stob::Node* n = getProperty(chain, "image")){
 		this->setNinePatch(morda::Morda::inst().resMan.load<ResNinePatch>(n->value()));
 	}
@@ -136,22 +59,154 @@ NinePatch::NinePatch(const stob::Node* chain) :
 	}
 }
 
+
+
 void NinePatch::render(const morda::Matr4r& matrix) const {
-	this->Column::render(matrix);
+	if(this->scaledImage){
+		if(!this->vao){
+			this->makeVao();
+		}
+
+		this->applyBlending();
+
+		this->scaledImage->tex().render(matrix, *this->vao);
+	}
+
+	this->Container::render(matrix);
+}
+
+
+
+void NinePatch::makeVao()const{
+	ASSERT(this->scaledImage)
+
+	auto b = this->getActualBorders();
+	auto& d = this->rect().d;
+
+	//vertex grid lines along each axis, the middle ones are clamped to not go outside of the widget
+	std::array<real, 4> x = {{0, std::min(b.left(), d.x), 0, d.x}};
+	x[2] = std::max(x[1], d.x - b.right());
+
+	std::array<real, 4> y = {{0, std::min(b.top(), d.y), 0, d.y}};
+	y[2] = std::max(y[1], d.y - b.bottom());
+
+	//texture coordinates of the grid lines, same as the nine-patch parts were cut out from the texture
+	auto& texDim = this->scaledImage->tex().dim();
+	auto& texBorders = this->scaledImage->borders();
+
+	std::array<real, 4> u = {{0, texBorders.left(), std::round(texDim.x - texBorders.right()), texDim.x}};
+	std::array<real, 4> v = {{0, texBorders.top(), std::round(texDim.y - texBorders.bottom()), texDim.y}};
+
+	std::array<Vec2r, 16> pos;
+	std::array<Vec2r, 16> texCoords;
+
+	for(unsigned i = 0; i != 4; ++i){
+		for(unsigned j = 0; j != 4; ++j){
+			pos[i * 4 + j] = Vec2r(x[j], y[i]);
+			texCoords[i * 4 + j] = Vec2r(u[j], v[i]).compDiv(texDim);
+		}
+	}
+
+	//two triangles per each of the 9 parts
+	std::array<std::uint16_t, 9 * 6> indices;
+	auto idx = indices.begin();
+	for(unsigned i = 0; i != 3; ++i){
+		for(unsigned j = 0; j != 3; ++j){
+			if(i == 1 && j == 1 && !this->centerVisible_v){
+				continue;
+			}
+			std::uint16_t lt = i * 4 + j;
+			std::uint16_t lb = lt + 4;
+			*idx++ = lt;
+			*idx++ = lb;
+			*idx++ = lb + 1;
+			*idx++ = lt;
+			*idx++ = lb + 1;
+			*idx++ = lt + 1;
+		}
+	}
+
+	auto& r = morda::inst().renderer();
+	this->vao = r.factory->createVertexArray(
+			{
+				r.factory->createVertexBuffer(utki::wrapBuf(pos)),
+				r.factory->createVertexBuffer(utki::wrapBuf(texCoords))
+			},
+			r.factory->createIndexBuffer(utki::Buf<std::uint16_t>(&*indices.begin(), idx - indices.begin())),
+			VertexArray::Mode_e::TRIANGLES
+		);
+}
+
+
+
+morda::Vec2r NinePatch::measure(const morda::Vec2r& quotum)const{
+	auto b = this->getActualBorders();
+	Vec2r bordersDim(b.left() + b.right(), b.top() + b.bottom());
+
+	Vec2r contentQuotum;
+	for(unsigned i = 0; i != contentQuotum.size(); ++i){
+		if(quotum[i] >= 0){
+			contentQuotum[i] = std::max(quotum[i] - bordersDim[i], real(0));
+		}else{
+			contentQuotum[i] = -1;
+		}
+	}
+
+	M_MORDA_PROFILE_SCOPE("measure", typeid(*this->content_v), this->content_v->id)
+	Vec2r ret = this->content_v->measure(contentQuotum) + bordersDim;
+
+	for(unsigned i = 0; i != ret.size(); ++i){
+		if(quotum[i] >= 0){
+			ret[i] = quotum[i];
+		}
+	}
+
+	return ret;
+}
+
+
+
+void NinePatch::layOut(){
+	auto b = this->getActualBorders();
+
+	this->content_v->moveTo(Vec2r(b.left(), b.top()));
+	this->content_v->resize(this->rect().d - Vec2r(b.left() + b.right(), b.top() + b.bottom()));
+}
+
+
+
+void NinePatch::onResize(){
+	this->vao.reset();
+	this->Widget::onResize();
 }
 
 
+
 void NinePatch::setNinePatch(std::shared_ptr<const ResNinePatch> np){
+	auto oldBorders = this->getActualBorders();
+
 	this->image = std::move(np);
-	this->scaledImage.reset();
 
 	this->applyImages();
 
+	//pressing a nine-patch button changes the nine-patch, avoid relayout if borders stay the same
+	if(this->getActualBorders() != oldBorders){
+		this->setRelayoutNeeded();
+	}
+
 	this->clearCache();
 }
 
 
 
+void NinePatch::setBorders(Sidesr borders){
+	this->borders = borders;
+	this->applyImages();
+	this->setRelayoutNeeded();
+}
+
+
+
 Sidesr NinePatch::getActualBorders() const noexcept{
 	Sidesr ret;
 
@@ -171,96 +226,21 @@ Sidesr NinePatch::getActualBorders() const noexcept{
 
 
 void NinePatch::applyImages(){
+	this->vao.reset();
+
 	if(!this->image){
-		for(auto& i : this->imageMatrix_v){
-			for(auto& j : i){
-				j->setImage(nullptr);
-			}
-		}
+		this->scaledImage.reset();
 		return;
 	}
 
-	auto& minBorders = this->image->borders();
-//		TRACE(<< "minBorders = " << minBorders << std::endl)
-
-	{
-		//non-const call to getLayoutParams requests relayout which is not necessarily needed, so try to avoid it if possible
-		auto& layoutParams = utki::makePtrToConst(this->imageMatrix_v[0][0].get())->getLayoutParams();
-
-		if(this->borders.left() == LayoutParams::min_c){
-			if(layoutParams.dim.x != minBorders.left()){
-				auto& lp = this->imageMatrix_v[0][0].get()->getLayoutParams();
-				lp.dim.x = minBorders.left();
-			}
-		}else{
-			if(layoutParams.dim.x != this->borders.left()){
-				auto& lp = this->imageMatrix_v[0][0].get()->getLayoutParams();
-				lp.dim.x = this->borders.left();
-			}
-		}
-
-		if(this->borders.top() == LayoutParams::min_c){
-			if(layoutParams.dim.y != minBorders.top()){
-				auto& lp = this->imageMatrix_v[0][0].get()->getLayoutParams();
-				lp.dim.y = minBorders.top();
-			}
-		}else{
-			if(layoutParams.dim.y != this->borders.top()){
-				auto& lp = this->imageMatrix_v[0][0].get()->getLayoutParams();
-				lp.dim.y = this->borders.top();
-			}
-		}
-//			TRACE(<< "layoutParams.dim = " << layoutParams.dim << std::endl)
-	}
-	{
-		//non-const call to getLayoutParams requests relayout which is not necessarily needed, so try to avoid it if possible
-		auto& layoutParams = utki::makePtrToConst(this->imageMatrix_v[2][2].get())->getLayoutParams();
-
-		if(this->borders.right() == LayoutParams::min_c){
-			if(layoutParams.dim.x != minBorders.right()){
-				auto& lp = this->imageMatrix_v[2][2]->getLayoutParams();
-				lp.dim.x = minBorders.right();
-			}
-		}else{
-			if(layoutParams.dim.x != this->borders.right()){
-				auto& lp = this->imageMatrix_v[2][2]->getLayoutParams();
-				lp.dim.x = this->borders.right();
-			}
-		}
-
-		if(this->borders.bottom() == LayoutParams::min_c){
-			if(layoutParams.dim.y != minBorders.bottom()){
-				auto& lp = this->imageMatrix_v[2][2]->getLayoutParams();
-				lp.dim.y = minBorders.bottom();
-			}
-		}else{
-			if(layoutParams.dim.y != this->borders.bottom()){
-				auto& lp = this->imageMatrix_v[2][2]->getLayoutParams();
-				lp.dim.y = this->borders.bottom();
-			}
-		}
-//			TRACE(<< "lp.dim = " << lp.dim << std::endl)
-	}
-//		TRACE(<< "this->borders = " << this->borders << std::endl)
-
 	this->scaledImage = this->image->get(this->borders);
-
-	for(unsigned i = 0; i != 3; ++i){
-		for(unsigned j = 0; j != 3; ++j){
-			this->imageMatrix_v[i][j]->setImage(this->scaledImage->images()[i][j]);
-		}
-	}
 }
 
 void NinePatch::setCenterVisible(bool visible){
-	ASSERT(this->imageMatrix_v[1][1])
-	this->imageMatrix_v[1][1]->setVisible(visible);
-}
-
-void NinePatch::onBlendingChanged(){
-	for(unsigned i = 0; i != 3; ++i){
-		for(unsigned j = 0; j != 3; ++j){
-			this->imageMatrix_v[i][j]->setBlendingParams(this->blendingParams());
-		}
+	if(this->centerVisible_v == visible){
+		return;
 	}
+	this->centerVisible_v = visible;
+	this->vao.reset();
+	this->setRedrawNeeded();
 }
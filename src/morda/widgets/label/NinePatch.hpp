@@ -5,9 +5,6 @@
 #include "../../res/ResNinePatch.hpp"
 
 #include "../group/Pile.hpp"
-#include "../group/Column.hpp"
-
-#include "Image.hpp"
 
 #include "../base/BlendingWidget.hpp"
 
@@ -18,6 +15,8 @@ namespace morda{
  * @brief Nine patch widget.
  * Nine patch widget displays a nine-patch and can hold child widgets in its central area.
  * From GUI script it can be instantiated as "NinePatch".
+ * The nine-patch frame is rendered as a single mesh of 16 vertices, so it costs one draw call
+ * regardless of the borders and the widget size.
  * 
  * @param left - width of left border, in length units.
  * @param right - width of right border, in length units.
@@ -29,15 +28,18 @@ namespace morda{
 class NinePatch :
 		public virtual Widget,
 		public BlendingWidget,
-		private Column
+		private Container
 {
 	std::shared_ptr<const ResNinePatch> image;
 	
-	std::shared_ptr<ResNinePatch::ImageMatrix> scaledImage;
+	std::shared_ptr<ResNinePatch::ScaledImage> scaledImage;
 	
 	Sidesr borders;
 	
-	std::array<std::array<std::shared_ptr<Image>, 3>, 3> imageMatrix_v;
+	bool centerVisible_v = true;
+	
+	//nine-patch mesh, recreated when the widget is resized or the nine-patch changes
+	mutable std::shared_ptr<VertexArray> vao;
 	
 	std::shared_ptr<Pile> content_v;
 	
@@ -59,21 +61,33 @@ public:
 	
 	void render(const morda::Matr4r& matrix) const override;
 	
+	morda::Vec2r measure(const morda::Vec2r& quotum)const override;
+	
+	void layOut()override;
+	
+	void onResize()override;
+	
 	/**
 	 * @brief Show/hide central part of nine-patch.
 	 * @param visible - show (true) or hide (false) central part of the nine-patch.
 	 */
 	void setCenterVisible(bool visible);
 	
+	/**
+	 * @brief Check if central part of nine-patch is visible.
+	 * @return true if central part is shown.
+	 * @return false otherwise.
+	 */
+	bool isCenterVisible()const noexcept{
+		return this->centerVisible_v;
+	}
+	
 	/**
 	 * @brief Set border settings.
 	 * Border values are in pixels or min_c.
 	 * @param borders - border values to set.
 	 */
-	void setBorders(Sidesr borders){
-		this->borders = borders;
-		this->applyImages();
-	}
+	void setBorders(Sidesr borders);
 	
 	/**
 	 * @brief Get current border settings.
@@ -86,11 +100,10 @@ public:
 	
 	Sidesr getActualBorders()const noexcept;
 	
-	void onBlendingChanged() override;
-
-	
 private:
 	void applyImages();
+	
+	void makeVao()const;
 };
 
 }
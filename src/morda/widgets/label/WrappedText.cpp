@@ -0,0 +1,85 @@
+#include "WrappedText.hpp"
+
+#include <cmath>
+
+#include "../../Morda.hpp"
+#include "../../util/util.hpp"
+
+
+using namespace morda;
+
+
+
+WrappedText::WrappedText(const stob::Node* chain) :
+		Widget(chain),
+		TextWidget(chain)
+{
+	if(auto p = getProperty(chain, "text")){
+		this->setText(unikod::toUtf32(p->value()));
+	}
+	
+	if(auto p = getProperty(chain, "align")){
+		std::string a = p->value();
+		if(a == "left"){
+			this->align_v = ParagraphLayout::Align_e::LEFT;
+		}else if(a == "center"){
+			this->align_v = ParagraphLayout::Align_e::CENTER;
+		}else if(a == "right"){
+			this->align_v = ParagraphLayout::Align_e::RIGHT;
+		}else{
+			throw morda::Exc("WrappedText::WrappedText(): unknown align value");
+		}
+	}
+}
+
+
+
+morda::Vec2r WrappedText::measure(const morda::Vec2r& quotum)const{
+	Vec2r ret;
+	
+	if(quotum.x >= 0){
+		ret.x = quotum.x;
+	}else{
+		ret.x = std::ceil(this->layout.naturalWidth(this->text(), this->font()));
+	}
+	
+	if(quotum.y >= 0){
+		ret.y = quotum.y;
+	}else{
+		ret.y = real(this->layout.lines(this->text(), this->font(), ret.x).size()) * this->font().height();
+	}
+	
+	return ret;
+}
+
+
+
+void WrappedText::render(const morda::Matr4r& matrix)const{
+	auto& font = this->font();
+	
+	real h = font.height();
+	
+	using std::round;
+	
+	real baseline = round((h + font.ascender() - font.descender()) / 2);
+	
+	auto color = morda::colorToVec4f(this->color());
+	
+	auto& lines = this->lines();
+	for(size_t i = 0; i != lines.size(); ++i){
+		real y = real(i) * h;
+		if(y >= this->rect().d.y){
+			break;
+		}
+		
+		auto& l = lines[i];
+		if(l.begin == l.end){
+			continue;
+		}
+		
+		morda::Matr4r matr(matrix);
+		matr.translate(ParagraphLayout::lineOffset(l, this->rect().d.x, this->align_v), y + baseline);
+		
+		font.renderString(matr, color, this->text().substr(l.begin, l.end - l.begin));
+	}
+}
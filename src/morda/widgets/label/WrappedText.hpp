@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../Widget.hpp"
+#include "../base/TextWidget.hpp"
+
+#include "../../util/ParagraphLayout.hpp"
+
+
+namespace morda{
+
+/**
+ * @brief Multi-line text label widget.
+ * This widget shows text wrapped to the width of the widget.
+ * Lines are broken at newline characters and, when the line does not fit the width, at spaces,
+ * hyphens and around ideographic characters.
+ * From GUI script it can be instantiated as "WrappedText".
+ *
+ * @param text - text to show.
+ * @param align - horizontal alignment of the lines: 'left' (default), 'center' or 'right'.
+ */
+class WrappedText : public TextWidget{
+	ParagraphLayout layout;
+	
+	ParagraphLayout::Align_e align_v = ParagraphLayout::Align_e::LEFT;
+	
+public:
+	WrappedText(const stob::Node* chain = nullptr);
+	
+	WrappedText(const WrappedText&) = delete;
+	WrappedText& operator=(const WrappedText&) = delete;
+	
+	void render(const morda::Matr4r& matrix)const override;
+	
+	morda::Vec2r measure(const morda::Vec2r& quotum)const override;
+	
+	void onFontChanged()override{
+		//font can be replaced with another one at the same address, so do not rely on the layout detecting it
+		this->layout.invalidate();
+		this->TextWidget::onFontChanged();
+	}
+	
+	/**
+	 * @brief Set horizontal alignment of the lines.
+	 * @param align - alignment.
+	 */
+	void setAlign(ParagraphLayout::Align_e align){
+		if(this->align_v == align){
+			return;
+		}
+		this->align_v = align;
+		this->setRedrawNeeded();
+	}
+	
+	ParagraphLayout::Align_e align()const noexcept{
+		return this->align_v;
+	}
+	
+	/**
+	 * @brief Get lines of the text wrapped to current width of the widget.
+	 * @return Lines of the text.
+	 */
+	const std::vector<ParagraphLayout::Line>& lines()const{
+		return this->layout.lines(this->text(), this->font(), this->rect().d.x);
+	}
+	
+protected:
+	void onTextReplaced(size_t pos, size_t erased, size_t inserted)override{
+		this->layout.invalidate();
+	}
+};
+
+}
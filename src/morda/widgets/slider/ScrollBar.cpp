@@ -54,7 +54,7 @@ ScrollBar::ScrollBar(const stob::Node* chain, bool vertical) :
 		Widget(chain),
 		FractionBandWidget(nullptr),
 		OrientedWidget(nullptr, vertical),
-		Pile(stob::parse(DDescription).get()),
+		Pile(morda::Morda::inst().inflater.compile(DDescription)->chain()),
 		handle(*this->findById("morda_handle"))
 {
 	{
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <morda/render/ShaderColorTexture.hpp>
+
+#include "OpenGL2ShaderBase.hpp"
+
+namespace mordaren{	
+
+class OpenGL2ShaderColorPosTexSdf :
+		public morda::ShaderColorTexture,
+		public OpenGL2ShaderBase
+{
+	GLint colorUniform;
+public:
+	OpenGL2ShaderColorPosTexSdf();
+	
+	OpenGL2ShaderColorPosTexSdf(const OpenGL2ShaderColorPosTexSdf&) = delete;
+	OpenGL2ShaderColorPosTexSdf& operator=(const OpenGL2ShaderColorPosTexSdf&) = delete;
+	
+	void render(const kolme::Matr4f& m, const morda::VertexArray& va, kolme::Vec4f color, const morda::Texture2D& tex)const override;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "OpenGLES2ShaderColorPosTexSdf.hpp"
+
+#include "OpenGLES2Texture2D.hpp"
+
+using namespace mordaren;
+
+OpenGLES2ShaderColorPosTexSdf::OpenGLES2ShaderColorPosTexSdf() :
+		OpenGLES2ShaderBase(
+				R"qwertyuiop(
+						#ifndef GL_ES
+						#	define highp
+						#	define mediump
+						#	define lowp
+						#endif
+
+						attribute highp vec4 a0;
+
+						attribute highp vec2 a1;
+
+						uniform highp mat4 matrix;
+
+						varying highp vec2 tc0;
+
+						void main(void){
+							gl_Position = matrix * a0;
+							tc0 = a1;
+						}
+					)qwertyuiop",
+				R"qwertyuiop(
+						#ifdef GL_ES
+						#	extension GL_OES_standard_derivatives : enable
+						#else
+						#	define highp
+						#	define mediump
+						#	define lowp
+						#endif
+		
+						uniform sampler2D texture0;
+		
+						uniform highp vec4 uniformColor;
+		
+						varying highp vec2 tc0;
+		
+						void main(void){
+							//distance to glyph edge, 0.5 is on the edge
+							highp float d = texture2D(texture0, tc0).r;
+							
+							//antialias over one screen pixel
+							highp float w = fwidth(d);
+							
+							gl_FragColor = vec4(uniformColor.rgb, uniformColor.a * smoothstep(0.5 - w, 0.5 + w, d));
+						}
+					)qwertyuiop"
+			)
+{
+	this->colorUniform = this->getUniform("uniformColor");
+}
+
+void OpenGLES2ShaderColorPosTexSdf::render(const kolme::Matr4f& m, const morda::VertexArray& va, kolme::Vec4f color, const morda::Texture2D& tex)const {
+	ASSERT(dynamic_cast<const OpenGLES2Texture2D*>(&tex))
+	static_cast<const OpenGLES2Texture2D&>(tex).bind(0);
+	this->bind();
+	
+	this->setUniform4f(this->colorUniform, color.x, color.y, color.z, color.w);
+	
+	this->OpenGLES2ShaderBase::render(m, va);
+}
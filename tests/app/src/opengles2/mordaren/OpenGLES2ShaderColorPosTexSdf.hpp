@@ -0,0 +1,23 @@
+#pragma once
+
+#include <morda/render/ShaderColorTexture.hpp>
+
+#include "OpenGLES2ShaderBase.hpp"
+
+namespace mordaren{	
+
+class OpenGLES2ShaderColorPosTexSdf :
+		public morda::ShaderColorTexture,
+		public OpenGLES2ShaderBase
+{
+	GLint colorUniform;
+public:
+	OpenGLES2ShaderColorPosTexSdf();
+	
+	OpenGLES2ShaderColorPosTexSdf(const OpenGLES2ShaderColorPosTexSdf&) = delete;
+	OpenGLES2ShaderColorPosTexSdf& operator=(const OpenGLES2ShaderColorPosTexSdf&) = delete;
+	
+	void render(const kolme::Matr4f& m, const morda::VertexArray& va, kolme::Vec4f color, const morda::Texture2D& tex)const override;
+};
+
+}
\ No newline at end of file
@@ -13,11 +13,11 @@ public:
 	}
 	
 	std::unique_ptr<morda::RenderFactory::Shaders> createShaders() override{
-		return nullptr;
+		return utki::makeUnique<morda::RenderFactory::Shaders>();
 	}
 
 	std::shared_ptr<morda::Texture2D> createTexture2D(morda::Texture2D::TexType_e type, kolme::Vec2ui dim, const utki::Buf<std::uint8_t>& data) override{
-		return nullptr;
+		return std::make_shared<morda::Texture2D>(morda::Vec2r(dim.x, dim.y));
 	}
 
 	std::shared_ptr<morda::VertexArray> createVertexArray(
@@ -47,6 +47,9 @@ public:
 };
 
 class FakeRenderer : public morda::Renderer{
+	kolme::Recti scissor = kolme::Recti(0);
+	kolme::Recti viewport = kolme::Recti(0);
+	bool scissorEnabled = false;
 public:
 	FakeRenderer() :
 			morda::Renderer(utki::makeUnique<FakeFactory>(), Params())
@@ -54,18 +57,24 @@ public:
 	
 	void clearFramebuffer() override{}
 	kolme::Recti getScissorRect() const override{
-		return kolme::Recti(0);
+		return this->scissor;
 	}
 	kolme::Recti getViewport() const override{
-		return kolme::Recti(0);
+		return this->viewport;
 	}
 	bool isScissorEnabled() const override{
-		return false;
+		return this->scissorEnabled;
 	}
 	void setBlendEnabled(bool enable) override{}
 	void setBlendFunc(BlendFactor_e srcClr, BlendFactor_e dstClr, BlendFactor_e srcAlpha, BlendFactor_e dstAlpha) override{}
 	void setFramebufferInternal(morda::FrameBuffer* fb) override{}
-	void setScissorEnabled(bool enabled) override{}
-	void setScissorRect(kolme::Recti r) override{}
-	void setViewport(kolme::Recti r) override{}
+	void setScissorEnabled(bool enabled) override{
+		this->scissorEnabled = enabled;
+	}
+	void setScissorRect(kolme::Recti r) override{
+		this->scissor = r;
+	}
+	void setViewport(kolme::Recti r) override{
+		this->viewport = r;
+	}
 };
@@ -1,5 +1,22 @@
 #include "../../src/morda/Morda.hpp"
 #include "../../src/morda/widgets/group/Pile.hpp"
+#include "../../src/morda/widgets/group/List.hpp"
+#include "../../src/morda/widgets/button/ImagePushButton.hpp"
+#include "../../src/morda/util/TextStorage.hpp"
+#include "../../src/morda/widgets/input/TextInputWrap.hpp"
+#include "../../src/morda/widgets/label/WrappedText.hpp"
+#include "../../src/morda/util/ParagraphLayout.hpp"
+#include "../../src/morda/res/ResFont.hpp"
+#include "../../src/morda/widgets/group/Overlay.hpp"
+#include "../../src/morda/widgets/button/DropDownSelector.hpp"
+#include "../../src/morda/widgets/group/ScrollArea.hpp"
+
+#include <set>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+
+#include <papki/FSFile.hpp>
 
 #include "FakeRenderer.hpp"
 
@@ -12,7 +29,7 @@ int main(int argc, char** argv){
 			Container{
 				defs{
 					dims{dx{max} dy{123}}
-
+					
 					Cont{
 						Container{
 							layout{
@@ -21,17 +38,17 @@ int main(int argc, char** argv){
 						}
 					}
 				}
-
+				
 				Cont{
 					layout{
 						@{dims}
 					}
 				}
-
+				
 				Cont{}
 			}
 		)qwertyuiop"));
-
+		
 		ASSERT_ALWAYS(w)
 		auto c = std::dynamic_pointer_cast<morda::Container>(w);
 		ASSERT_ALWAYS(c)
@@ -56,7 +73,7 @@ int main(int argc, char** argv){
 						}
 					}
 				}
-
+				
 				Cont{
 					x{23}
 					dx{45}
@@ -64,11 +81,11 @@ int main(int argc, char** argv){
 						dx{max}
 					}
 				}
-
+				
 				Cont{}
 			}
 		)qwertyuiop"));
-
+		
 		ASSERT_ALWAYS(w)
 		auto c = std::dynamic_pointer_cast<morda::Container>(w);
 		ASSERT_ALWAYS(c)
@@ -98,7 +115,7 @@ int main(int argc, char** argv){
 						}
 					}
 				}
-
+				
 				Cont{
 					x{23}
 					dx{45}
@@ -106,11 +123,11 @@ int main(int argc, char** argv){
 						dx{max}
 					}
 				}
-
+				
 				Cont{}
 			}
 		)qwertyuiop"));
-
+		
 		ASSERT_ALWAYS(w)
 		auto c = std::dynamic_pointer_cast<morda::Container>(w);
 		ASSERT_ALWAYS(c)
@@ -147,7 +164,7 @@ int main(int argc, char** argv){
 						}
 					}
 				}
-
+				
 				Cont{
 					x{23} y{106}
 					dx{45}
@@ -155,11 +172,11 @@ int main(int argc, char** argv){
 						dx{max}
 					}
 				}
-
+				
 				Cont{}
 			}
 		)qwertyuiop"));
-
+		
 		ASSERT_ALWAYS(w)
 		auto c = std::dynamic_pointer_cast<morda::Container>(w);
 		ASSERT_ALWAYS(c)
@@ -195,7 +212,7 @@ int main(int argc, char** argv){
 						Container_{}
 					}
 				}
-
+				
 				Tmpl{
 					Container
 				}
@@ -204,7 +221,7 @@ int main(int argc, char** argv){
 				Tmpl
 			}
 		)qwertyuiop"));
-
+		
 		ASSERT_ALWAYS(w)
 		auto c = std::dynamic_pointer_cast<morda::Pile>(w);
 		ASSERT_ALWAYS(c)
@@ -225,11 +242,11 @@ int main(int argc, char** argv){
 						Tmpl1
 					}
 				}
-
+				
 				Tmpl
 			}
 		)qwertyuiop"));
-
+		
 		ASSERT_ALWAYS(w)
 		auto c = std::dynamic_pointer_cast<morda::Container>(w);
 		ASSERT_ALWAYS(c)
@@ -237,5 +254,1212 @@ int main(int argc, char** argv){
 		ASSERT_ALWAYS(std::dynamic_pointer_cast<morda::Pile>(c->children().front()))
 	}
 	
+	//test compiled prototype
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		auto p = m.inflater.compile(*stob::parse(R"qwertyuiop(
+			defs{
+				Cont{ x
+					Container{
+						x{@{x}}
+						@{children}
+					}
+				}
+			}
+			Cont{
+				x{13}
+				Cont{
+					x{14}
+					Pile
+				}
+			}
+		)qwertyuiop"));
+		
+		ASSERT_ALWAYS(p)
+		ASSERT_ALWAYS(p->chain())
+		
+		auto w1 = m.inflater.inflate(*p->chain());
+		auto w2 = m.inflater.inflate(*p->chain());
+		ASSERT_ALWAYS(w1 != w2)
+		
+		auto c = std::dynamic_pointer_cast<morda::Container>(w2);
+		ASSERT_ALWAYS(c)
+		ASSERT_ALWAYS(c->rect().p.x == 13)
+		ASSERT_ALWAYS(c->children().size() == 1)
+		auto cc = std::dynamic_pointer_cast<morda::Container>(c->children().front());
+		ASSERT_ALWAYS(cc)
+		ASSERT_ALWAYS(cc->rect().p.x == 14)
+		ASSERT_ALWAYS(cc->children().size() == 1)
+		ASSERT_ALWAYS(std::dynamic_pointer_cast<morda::Pile>(cc->children().front()))
+		
+		//compiling part of compiled prototype does not expand it again
+		auto sub = m.inflater.compile(*p->chain()->child()->thisOrNextNonProperty().node());
+		ASSERT_ALWAYS(sub->chain() == p->chain()->child()->thisOrNextNonProperty().node())
+		
+		//prototypes compiled from string are cached
+		const char* str = "Pile{Container}";
+		ASSERT_ALWAYS(m.inflater.compile(str) == m.inflater.compile(str))
+	}
+	
+	//test that first occurrence of property is used
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		auto w = m.inflater.inflate("Widget{x{10} y{20} x{30} id{a} visible{false}}");
+		
+		ASSERT_ALWAYS(w)
+		ASSERT_ALWAYS(w->rect().p.x == 10)
+		ASSERT_ALWAYS(w->rect().p.y == 20)
+		ASSERT_ALWAYS(w->id == "a")
+		ASSERT_ALWAYS(!w->isVisible())
+	}
+	
+	//test finding widgets by ID
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		auto w = m.inflater.inflate(*stob::parse(R"qwertyuiop(
+			Container{
+				Container{
+					Container{
+						Widget{id{a} x{3}}
+					}
+					Widget{id{b}}
+				}
+				Widget{id{a} x{1}}
+			}
+		)qwertyuiop"));
+		
+		auto c = std::dynamic_pointer_cast<morda::Container>(w);
+		ASSERT_ALWAYS(c)
+		
+		//closest to the root wins
+		auto a = c->findById("a");
+		ASSERT_ALWAYS(a)
+		ASSERT_ALWAYS(a->rect().p.x == 1)
+		
+		auto b = c->findById("b");
+		ASSERT_ALWAYS(b)
+		ASSERT_ALWAYS(!c->findById("c"))
+		
+		//removed widgets are not found
+		c->remove(*a);
+		a = c->findById("a");
+		ASSERT_ALWAYS(a)
+		ASSERT_ALWAYS(a->rect().p.x == 3)
+		
+		//widgets added to sub-hierarchy are found
+		auto inner = std::dynamic_pointer_cast<morda::Container>(c->children().front());
+		ASSERT_ALWAYS(inner)
+		inner->add(*stob::parse("Widget{id{c}}"));
+		ASSERT_ALWAYS(c->findById("c"))
+		
+		//ID changed after adding
+		b->id = "d";
+		ASSERT_ALWAYS(!c->findById("b"))
+		ASSERT_ALWAYS(c->findById("d") == b)
+		
+		ASSERT_ALWAYS(c->find<morda::Container>().size() == 2)
+		
+		unsigned numWidgets = 0;
+		c->visit<morda::Widget>([&numWidgets](morda::Widget&){++numWidgets;});
+		ASSERT_ALWAYS(numWidgets == 5)
+	}
+	
+	//test that children array follows children list
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		auto c = std::make_shared<morda::Container>();
+		
+		auto check = [&c](){
+			ASSERT_ALWAYS(c->children().size() == c->childrenArray().size())
+			size_t i = 0;
+			for(auto& w : c->children()){
+				ASSERT_ALWAYS(c->childrenArray()[i] == w.get())
+				ASSERT_ALWAYS(w->parentIndex() == i)
+				++i;
+			}
+		};
+		
+		c->add(*stob::parse("Widget{id{a}} Widget{id{b}} Widget{id{c}} Widget{id{d}}"));
+		check();
+		
+		auto& a = c->getById("a");
+		auto& d = c->getById("d");
+		
+		c->changeChildZPosition(a, c->children().end());
+		check();
+		ASSERT_ALWAYS(c->childrenArray().back() == &a)
+		
+		c->changeChildZPosition(d, c->children().begin());
+		check();
+		ASSERT_ALWAYS(c->childrenArray().front() == &d)
+		
+		c->remove(c->getById("b"));
+		check();
+		
+		c->add(m.inflater.inflate("Widget{id{e}}"), &a);
+		check();
+		ASSERT_ALWAYS(c->childrenArray()[c->childrenArray().size() - 2]->id == "e")
+		
+		for(unsigned i = 0; i != 1000; ++i){
+			c->add(m.inflater.inflate("Widget{id{f}}"));
+		}
+		check();
+		
+		//removing all children also removes them from ID indices of the ancestors
+		auto root = std::make_shared<morda::Container>();
+		root->add(*stob::parse("Widget{id{f}}"));
+		auto& outside = root->getById("f");
+		root->add(c);
+		ASSERT_ALWAYS(root->findById("a"))
+		
+		std::vector<std::shared_ptr<morda::Widget>> removed(c->children().begin(), c->children().end());
+		c->removeAll();
+		check();
+		ASSERT_ALWAYS(c->children().size() == 0)
+		ASSERT_ALWAYS(!c->findById("a"))
+		ASSERT_ALWAYS(!c->findById("f"))
+		ASSERT_ALWAYS(!root->findById("a"))
+		ASSERT_ALWAYS(root->findById("f").get() == &outside)
+		for(auto& w : removed){
+			ASSERT_ALWAYS(!w->parent())
+		}
+		
+		//removed widgets can be added again
+		c->add(removed.front());
+		check();
+		ASSERT_ALWAYS(root->findById(removed.front()->id) == removed.front())
+	}
+	
+	//test asynchronous list items provider
+	{
+		std::vector<std::function<void()>> uiQueue;
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [&uiQueue](std::function<void()>&& f){uiQueue.push_back(std::move(f));});
+		
+		auto runUiQueue = [&uiQueue](){
+			auto q = std::move(uiQueue);
+			uiQueue.clear();
+			for(auto& f : q){
+				f();
+			}
+		};
+		
+		class Provider : public morda::List::AsyncItemsProvider{
+		public:
+			std::set<size_t> fetched;
+			std::set<size_t> cancelled;
+			
+			Provider() :
+					morda::List::AsyncItemsProvider(5)
+			{}
+			
+			size_t count()const noexcept override{
+				return 100;
+			}
+			
+			std::shared_ptr<morda::Widget> getPlaceholder(size_t index)override{
+				return morda::Morda::inst().inflater.inflate("Widget{layout{dy{10}}}");
+			}
+			
+			void fetch(size_t index)override{
+				this->fetched.insert(index);
+			}
+			
+			void cancel(size_t index)override{
+				this->cancelled.insert(index);
+				this->fetched.erase(index);
+			}
+		};
+		
+		auto provider = std::make_shared<Provider>();
+		auto list = std::make_shared<morda::VList>(nullptr);
+		list->setItemsProvider(provider);
+		runUiQueue();
+		list->resize(morda::Vec2r(100, 50));
+		
+		//visible items and next page are fetched, measuring tail items does not fetch them
+		ASSERT_ALWAYS(list->visibleCount() == 5)
+		ASSERT_ALWAYS(provider->fetched.size() != 0)
+		ASSERT_INFO_ALWAYS(*provider->fetched.rbegin() < 20, "last fetched = " << *provider->fetched.rbegin())
+		ASSERT_ALWAYS(provider->cancelled.size() == 0)
+		
+		//fulfil everything fetched, actual items are bigger than placeholders
+		std::vector<std::shared_ptr<morda::Widget>> items(provider->count());
+		auto fulfilAll = [&provider, &items](){
+			for(auto i : provider->fetched){
+				provider->fulfil(i, [i, &items](){
+					items[i] = morda::Morda::inst().inflater.inflate("Widget{layout{dy{20}}}");
+					return items[i];
+				});
+			}
+			provider->fetched.clear();
+		};
+		fulfilAll();
+		runUiQueue();
+		list->resize(morda::Vec2r(100, 50));
+		ASSERT_ALWAYS(items[0] && items[0]->parent())
+		ASSERT_ALWAYS(list->visibleCount() == 3)
+		
+		//scroll to the end, tail items are re-measured once actual items are delivered
+		list->setScrollPosAsFactor(1);
+		fulfilAll();
+		runUiQueue();
+		list->resize(morda::Vec2r(100, 50));
+		list->setScrollPosAsFactor(1);
+		auto& last = items.back();
+		ASSERT_ALWAYS(last && last->parent())
+		ASSERT_INFO_ALWAYS(last->rect().p.y + last->rect().d.y == 50, "last item bottom = " << last->rect().p.y + last->rect().d.y)
+		
+		//items far from the scroll position are dropped
+		ASSERT_ALWAYS(provider->cancelled.size() == 0)
+		ASSERT_ALWAYS(!items[0]->parent())
+		
+		//outdated fulfilments are ignored
+		provider->fetched.insert(0);
+		provider->notifyDataSetChanged();
+		fulfilAll();
+		items[0].reset();
+		runUiQueue();
+		ASSERT_ALWAYS(!items[0])
+	}
+	
+	//test updateables
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		
+		std::vector<unsigned> order;
+		
+		class U : public morda::Updateable{
+		public:
+			unsigned id;
+			std::vector<unsigned>& order;
+			std::function<void(U&)> onUpdate;
+			
+			U(unsigned id, std::vector<unsigned>& order) :
+					id(id),
+					order(order)
+			{}
+			
+			void update(std::uint32_t dt)override{
+				this->order.push_back(this->id);
+				if(this->onUpdate){
+					this->onUpdate(*this);
+				}
+			}
+		};
+		
+		std::vector<std::shared_ptr<U>> u;
+		for(unsigned i = 0; i != 5; ++i){
+			u.push_back(std::make_shared<U>(i, order));
+		}
+		
+		//updateables are updated in order of their due time
+		u[0]->startUpdating(40);
+		u[1]->startUpdating(10);
+		u[2]->startUpdating(30);
+		u[3]->startUpdating(20);
+		std::this_thread::sleep_for(std::chrono::milliseconds(60));
+		m.update();
+		ASSERT_ALWAYS(order == std::vector<unsigned>({1, 3, 2, 0}))
+		for(auto& i : u){
+			i->stopUpdating();
+		}
+		
+		//updateable stopped by another one during update is not updated
+		order.clear();
+		u[0]->onUpdate = [&u](U&){
+			u[1]->stopUpdating();
+		};
+		u[0]->startUpdating(0);
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		u[1]->startUpdating(0);
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		m.update();
+		ASSERT_ALWAYS(order == std::vector<unsigned>({0}))
+		ASSERT_ALWAYS(!u[1]->isUpdating())
+		ASSERT_ALWAYS(u[0]->isUpdating())
+		
+		//updateable which stops itself during update is not updated anymore
+		order.clear();
+		u[0]->onUpdate = [](U& self){
+			self.stopUpdating();
+		};
+		m.update();
+		ASSERT_ALWAYS(order == std::vector<unsigned>({0}))
+		ASSERT_ALWAYS(!u[0]->isUpdating())
+		order.clear();
+		m.update();
+		ASSERT_ALWAYS(order.size() == 0)
+		
+		//updateable re-added during update is updated once per update cycle
+		u[0]->onUpdate = [](U& self){
+			self.stopUpdating();
+			self.startUpdating(0);
+		};
+		u[0]->startUpdating(0);
+		m.update();
+		m.update();
+		ASSERT_ALWAYS(order == std::vector<unsigned>({0, 0}))
+		ASSERT_ALWAYS(u[0]->isUpdating())
+		
+		//stopping and starting again before update
+		order.clear();
+		u[0]->onUpdate = nullptr;
+		u[0]->stopUpdating();
+		u[0]->startUpdating(0);
+		bool thrown = false;
+		try{
+			u[0]->startUpdating(0);
+		}catch(morda::Updateable::Exc&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+		m.update();
+		ASSERT_ALWAYS(order == std::vector<unsigned>({0}))
+		
+		//destroyed updateables are removed from the updater, the rest are still updated
+		order.clear();
+		for(auto& i : u){
+			if(!i->isUpdating()){
+				i->startUpdating(0);
+			}
+		}
+		m.update();
+		order.clear();
+		u[2].reset();
+		u[4].reset();
+		m.update();
+		std::sort(order.begin(), order.end());
+		ASSERT_ALWAYS(order == std::vector<unsigned>({0, 1, 3}))
+	}
+	
+	//test updateables in frame clock mode
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		
+		//pairs of updateable id and dt it was updated with
+		std::vector<std::pair<unsigned, std::uint32_t>> updates;
+		
+		class U : public morda::Updateable{
+		public:
+			unsigned id;
+			std::vector<std::pair<unsigned, std::uint32_t>>& updates;
+			
+			U(unsigned id, std::vector<std::pair<unsigned, std::uint32_t>>& updates) :
+					id(id),
+					updates(updates)
+			{}
+			
+			void update(std::uint32_t dt)override{
+				this->updates.push_back(std::make_pair(this->id, dt));
+			}
+		};
+		
+		auto a = std::make_shared<U>(0, updates);
+		auto b = std::make_shared<U>(1, updates);
+		auto c = std::make_shared<U>(2, updates);
+		
+		//nothing to animate
+		ASSERT_ALWAYS(m.updateFrame(32) == std::uint32_t(-1))
+		
+		a->startUpdating(0);
+		b->startUpdating(8);
+		c->startUpdating(1000);
+		
+		//updateables due before the middle of the next frame period are updated in this frame
+		ASSERT_ALWAYS(m.updateFrame(32) == 0)
+		ASSERT_INFO_ALWAYS(updates.size() == 2, "updates.size() = " << updates.size())
+		ASSERT_ALWAYS(updates[0].first == 0)
+		ASSERT_ALWAYS(updates[1].first == 1)
+		
+		//updateable b is updated ahead of time, at the frame time
+		ASSERT_INFO_ALWAYS(updates[1].second < 8, "dt = " << updates[1].second)
+		
+		//updated updateables are re-added with the frame time as their start time, so they are batched in next frames as well
+		updates.clear();
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		m.updateFrame(32);
+		ASSERT_INFO_ALWAYS(updates.size() == 2, "updates.size() = " << updates.size())
+		ASSERT_ALWAYS(updates[0].first == 0)
+		ASSERT_ALWAYS(updates[1].first == 1)
+		ASSERT_INFO_ALWAYS(updates[0].second == updates[1].second, "dt0 = " << updates[0].second << ", dt1 = " << updates[1].second)
+		ASSERT_ALWAYS(updates[0].second >= 20)
+		
+		//when nothing is due within next frame, the returned time to wait is counted after next frame
+		a->stopUpdating();
+		b->stopUpdating();
+		updates.clear();
+		auto wait = m.updateFrame(32);
+		ASSERT_ALWAYS(updates.size() == 0)
+		ASSERT_INFO_ALWAYS(wait != 0 && wait <= 1000 - 32, "wait = " << wait)
+		
+		c->stopUpdating();
+		ASSERT_ALWAYS(m.updateFrame(32) == std::uint32_t(-1))
+	}
+	
+	//test cache of prototypes compiled from strings
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		
+		std::weak_ptr<const morda::Inflater::Prototype> first = m.inflater.compile("Widget{id{0}}");
+		auto recent = m.inflater.compile("Widget{id{recent}}");
+		ASSERT_ALWAYS(!first.expired())
+		
+		for(unsigned i = 1; i != 1000; ++i){
+			std::string str = "Widget{id{" + std::to_string(i) + "}}";
+			auto w = m.inflater.inflate(str.c_str());
+			ASSERT_ALWAYS(w && w->id == std::to_string(i))
+			
+			//keep using one prototype, so it is not dropped
+			ASSERT_ALWAYS(m.inflater.compile("Widget{id{recent}}") == recent)
+		}
+		
+		//least recently used prototypes are dropped
+		ASSERT_ALWAYS(first.expired())
+	}
+	
+	//test that definitions preceding the first widget are applied globally
+	{
+		std::vector<std::function<void()>> uiQueue;
+		std::mutex uiQueueMutex;
+		morda::Morda m(
+				std::make_shared<FakeRenderer>(),
+				0,
+				0,
+				[&uiQueue, &uiQueueMutex](std::function<void()>&& f){
+					std::lock_guard<std::mutex> lock(uiQueueMutex);
+					uiQueue.push_back(std::move(f));
+				}
+			);
+		
+		auto w = m.inflater.inflate("defs{A{Pile}} A");
+		ASSERT_ALWAYS(std::dynamic_pointer_cast<morda::Pile>(w))
+		ASSERT_ALWAYS(std::dynamic_pointer_cast<morda::Pile>(m.inflater.inflate("A")))
+		
+		auto p = m.inflater.compile("defs{B{Pile}} B");
+		ASSERT_ALWAYS(std::dynamic_pointer_cast<morda::Pile>(m.inflater.inflate(*p->chain())))
+		ASSERT_ALWAYS(std::dynamic_pointer_cast<morda::Pile>(m.inflater.inflate("B")))
+		
+		//GUI scripts with definitions are not cached
+		ASSERT_ALWAYS(m.inflater.compile("defs{B{Pile}} B") != m.inflater.compile("defs{B{Pile}} B"))
+		
+		//cached prototypes compiled before the definitions are dropped
+		m.inflater.inflate("defs{C{Widget}}");
+		auto c = m.inflater.compile("C");
+		ASSERT_ALWAYS(!std::dynamic_pointer_cast<morda::Pile>(m.inflater.inflate("C")))
+		ASSERT_ALWAYS(m.inflater.compile("C") == c)
+		m.inflater.inflate("defs{C{Pile}}");
+		ASSERT_ALWAYS(m.inflater.compile("C") != c)
+		ASSERT_ALWAYS(std::dynamic_pointer_cast<morda::Pile>(m.inflater.inflate("C")))
+		
+		std::shared_ptr<morda::Widget> asyncWidget;
+		m.inflater.inflateAsync(
+				std::string("defs{D{Pile}} D"),
+				[&asyncWidget](std::shared_ptr<morda::Widget> w){
+					asyncWidget = std::move(w);
+				}
+			);
+		for(;;){
+			std::function<void()> f;
+			{
+				std::lock_guard<std::mutex> lock(uiQueueMutex);
+				if(uiQueue.size() != 0){
+					f = std::move(uiQueue.front());
+					uiQueue.erase(uiQueue.begin());
+				}
+			}
+			if(f){
+				f();
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		ASSERT_ALWAYS(std::dynamic_pointer_cast<morda::Pile>(asyncWidget))
+		ASSERT_ALWAYS(std::dynamic_pointer_cast<morda::Pile>(m.inflater.inflate("D")))
+	}
+	
+	//test that pressing a retained image button re-records its render list
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		
+		struct FakeImage : morda::ResImage{
+			morda::Vec2r dim(morda::real dpi)const noexcept override{
+				return morda::Vec2r(10);
+			}
+			std::shared_ptr<const QuadTexture> get(morda::Vec2r forDim)const override{
+				return nullptr;
+			}
+		};
+		
+		struct CountingButton : morda::ImagePushButton{
+			mutable unsigned numRenders = 0;
+			
+			CountingButton() :
+					morda::Widget(nullptr),
+					morda::Button(nullptr),
+					morda::ImagePushButton(nullptr)
+			{}
+			
+			void render(const morda::Matr4r& matrix)const override{
+				++this->numRenders;
+			}
+		};
+		
+		auto b = std::make_shared<CountingButton>();
+		b->setUnpressedImage(std::make_shared<FakeImage>());
+		b->setPressedImage(std::make_shared<FakeImage>());
+		b->setRetain(true);
+		
+		m.setViewportSize(morda::Vec2r(100, 100));
+		m.setRootWidget(b);
+		
+		m.render();
+		ASSERT_INFO_ALWAYS(b->numRenders == 1, "b->numRenders = " << b->numRenders)
+		
+		m.render();
+		ASSERT_INFO_ALWAYS(b->numRenders == 1, "b->numRenders = " << b->numRenders)
+		
+		b->setPressed(true);
+		ASSERT_ALWAYS(!b->needsRelayout())
+		m.render();
+		ASSERT_INFO_ALWAYS(b->numRenders == 2, "b->numRenders = " << b->numRenders)
+		
+		m.render();
+		ASSERT_INFO_ALWAYS(b->numRenders == 2, "b->numRenders = " << b->numRenders)
+		
+		b->setPressed(false);
+		m.render();
+		ASSERT_INFO_ALWAYS(b->numRenders == 3, "b->numRenders = " << b->numRenders)
+	}
+	
+	//test text storage editing, iterating and accessing across chunk boundaries
+	{
+		//the storage is checked against a plain string after every edit
+		std::u32string ref;
+		morda::TextStorage ts;
+		
+		auto makeText = [](size_t size, char32_t first){
+			std::u32string ret;
+			for(size_t i = 0; i != size; ++i){
+				ret.push_back(first + char32_t(i % 26));
+			}
+			return ret;
+		};
+		
+		auto check = [&ts, &ref](){
+			ASSERT_INFO_ALWAYS(ts.size() == ref.size(), "ts.size() = " << ts.size() << ", ref.size() = " << ref.size())
+			ASSERT_ALWAYS(ts.empty() == ref.empty())
+			ASSERT_ALWAYS(ts.str() == ref)
+			
+			//forward iteration
+			{
+				size_t n = 0;
+				for(auto i = ts.begin(); i != ts.end(); ++i, ++n){
+					ASSERT_ALWAYS(n < ref.size())
+					ASSERT_INFO_ALWAYS(*i == ref[n], "n = " << n)
+					ASSERT_INFO_ALWAYS(i.index() == n, "n = " << n << ", i.index() = " << i.index())
+				}
+				ASSERT_ALWAYS(n == ref.size())
+				ASSERT_ALWAYS(ts.end().index() == ref.size())
+			}
+			
+			//backward iteration
+			ASSERT_ALWAYS(std::equal(ts.rbegin(), ts.rend(), ref.rbegin()))
+			ASSERT_ALWAYS(size_t(std::distance(ts.rbegin(), ts.rend())) == ref.size())
+			
+			//random access, including the chunk boundaries
+			for(size_t i = 0; i != ref.size(); ++i){
+				auto it = ts.iteratorAt(i);
+				ASSERT_INFO_ALWAYS(it.index() == i, "i = " << i << ", it.index() = " << it.index())
+				ASSERT_INFO_ALWAYS(*it == ref[i], "i = " << i)
+				ASSERT_ALWAYS(ts[i] == ref[i])
+				if(i != 0){
+					--it;
+					ASSERT_INFO_ALWAYS(it.index() == i - 1, "i = " << i)
+					ASSERT_ALWAYS(*it == ref[i - 1])
+				}
+			}
+			ASSERT_ALWAYS(ts.iteratorAt(ref.size()) == ts.end())
+			ASSERT_ALWAYS(ts.iteratorAt(ref.size() + 10) == ts.end())
+			
+			//parts of the text, spanning several chunks and clamped to the end
+			for(size_t pos = 0; pos <= ref.size(); pos += 257){
+				for(size_t n : {size_t(0), size_t(1), size_t(511), size_t(1025), size_t(3000), std::u32string::npos}){
+					ASSERT_INFO_ALWAYS(ts.substr(pos, n) == ref.substr(pos, n), "pos = " << pos << ", n = " << n)
+					
+					std::u32string spans;
+					ts.forEachSpan(pos, n, [&spans](const char32_t* p, size_t len){
+						ASSERT_ALWAYS(len != 0)
+						spans.append(p, len);
+					});
+					ASSERT_INFO_ALWAYS(spans == ref.substr(pos, n), "pos = " << pos << ", n = " << n)
+				}
+			}
+		};
+		
+		check();
+		ASSERT_ALWAYS(ts.begin() == ts.end())
+		
+		//grow by inserting to the end, beginning and middle, so that chunks get split
+		ts.insert(0, makeText(100, U'a'));
+		ref.insert(0, makeText(100, U'a'));
+		check();
+		
+		ts.insert(ts.size(), makeText(3000, U'A'));
+		ref.insert(ref.size(), makeText(3000, U'A'));
+		check();
+		
+		ts.insert(0, makeText(1500, U'a'));
+		ref.insert(0, makeText(1500, U'a'));
+		check();
+		
+		ts.insert(2000, makeText(700, U'0'));
+		ref.insert(2000, makeText(700, U'0'));
+		check();
+		
+		//insert position is clamped to size of the text
+		ts.insert(ts.size() + 100, U"end");
+		ref.append(U"end");
+		check();
+		
+		//insert right at the chunk boundaries
+		for(size_t pos : {size_t(512), size_t(1024), size_t(1536), size_t(2048)}){
+			ts.insert(pos, U"|");
+			ref.insert(pos, U"|");
+			check();
+		}
+		
+		//erase within a chunk, across several chunks and past the end
+		ts.erase(10, 5);
+		ref.erase(10, 5);
+		check();
+		
+		ts.erase(500, 1700);
+		ref.erase(500, 1700);
+		check();
+		
+		ts.erase(ref.size() - 10, 100);
+		ref.erase(ref.size() - 10);
+		check();
+		
+		ts.erase(0, 600);
+		ref.erase(0, 600);
+		check();
+		
+		ts.replace(100, 1000, makeText(2500, U'a'));
+		ref.replace(100, 1000, makeText(2500, U'a'));
+		check();
+		
+		//a series of small edits spread through the text
+		{
+			std::uint32_t seed = 1;
+			auto rnd = [&seed](size_t max){
+				seed = seed * 1103515245 + 12345;
+				return size_t((seed >> 8) % (max + 1));
+			};
+			
+			for(unsigned i = 0; i != 100; ++i){
+				size_t pos = rnd(ref.size());
+				if(i % 3 == 0){
+					size_t n = rnd(300);
+					ts.erase(pos, n);
+					ref.erase(pos, std::min(n, ref.size() - pos));
+				}else{
+					auto str = makeText(rnd(200) + 1, U'a' + char32_t(i % 26));
+					ts.insert(pos, str);
+					ref.insert(pos, str);
+				}
+				if(i % 10 == 0){
+					check();
+				}
+			}
+			check();
+		}
+		
+		//erase everything
+		ts.erase(0, ts.size());
+		ref.clear();
+		check();
+		ASSERT_ALWAYS(ts.begin() == ts.end())
+		
+		ts.assign(makeText(5000, U'a'));
+		ref = makeText(5000, U'a');
+		check();
+		
+		ts.clear();
+		ref.clear();
+		check();
+	}
+	
+	//test line index of multi-line text input
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		m.resMan.mountResPack(papki::FSFile("../../res/morda_res/fonts/"));
+		
+		auto t = std::make_shared<morda::TextInputWrap>(nullptr);
+		
+		//compare line index against line starts found by scanning the text
+		auto check = [&t](){
+			auto text = t->getText();
+			
+			std::vector<size_t> starts;
+			starts.push_back(0);
+			for(size_t i = 0; i != text.size(); ++i){
+				if(text[i] == U'\n'){
+					starts.push_back(i + 1);
+				}
+			}
+			
+			ASSERT_INFO_ALWAYS(t->numLines() == starts.size(), "t->numLines() = " << t->numLines() << ", expected " << starts.size())
+			
+			for(size_t l = 0; l != starts.size(); ++l){
+				ASSERT_INFO_ALWAYS(t->lineStart(l) == starts[l], "l = " << l << ", t->lineStart(l) = " << t->lineStart(l) << ", expected " << starts[l])
+			}
+			
+			//the index equal to text size is the position after the last character, it belongs to the last line
+			size_t line = 0;
+			for(size_t i = 0; i <= text.size(); ++i){
+				if(line + 1 != starts.size() && starts[line + 1] == i){
+					++line;
+				}
+				ASSERT_INFO_ALWAYS(t->lineOf(i) == line, "i = " << i << ", t->lineOf(i) = " << t->lineOf(i) << ", expected " << line)
+			}
+		};
+		
+		check();
+		
+		t->setText(U"ab\ncd\n\nef");
+		check();
+		
+		//insert at line start, in the middle and at line end, without adding lines
+		t->insertText(3, U"xy");
+		check();
+		t->insertText(4, U"z");
+		check();
+		t->insertText(2, U"q");
+		check();
+		
+		//insert newlines at line start, line end and into the last line
+		t->insertText(t->lineStart(1), U"\n");
+		check();
+		t->insertText(t->lineStart(2) - 1, U"\n\n");
+		check();
+		t->insertText(t->lineStart(t->numLines() - 1) + 1, U"\n");
+		check();
+		
+		//append to the end of the last line, with and without newlines
+		t->insertText(t->getText().size(), U"gh");
+		check();
+		t->insertText(t->getText().size(), U"\n");
+		check();
+		t->insertText(t->getText().size(), U"ij\nkl");
+		check();
+		
+		//delete the newline at line start, joining the line with the previous one
+		t->eraseText(t->lineStart(2) - 1, 1);
+		check();
+		
+		//delete the newline at line end, joining the line with the next one
+		{
+			size_t l = 1;
+			size_t end = t->lineStart(l + 1) - 1;
+			t->eraseText(end, 1);
+			check();
+		}
+		
+		//delete characters at line start and line end without joining lines
+		t->eraseText(t->lineStart(1), 1);
+		check();
+		t->eraseText(t->lineStart(2) - 2, 1);
+		check();
+		
+		//delete within the last line, then the whole last line with its newline
+		{
+			size_t lastStart = t->lineStart(t->numLines() - 1);
+			t->eraseText(lastStart, 1);
+			check();
+			
+			lastStart = t->lineStart(t->numLines() - 1);
+			t->eraseText(lastStart - 1, t->getText().size() - lastStart + 1);
+			check();
+		}
+		
+		//delete across several lines
+		t->eraseText(1, t->lineStart(3));
+		check();
+		
+		//replace keeping the number of lines and changing line lengths
+		t->replaceText(0, t->getText().size(), U"a\nbb\nccc");
+		check();
+		t->replaceText(2, 4, U"dddd\ne");
+		check();
+		
+		//many lines, so that the tree has several levels
+		{
+			std::u32string text;
+			for(unsigned i = 0; i != 100; ++i){
+				text.append(i % 7, U'a');
+				text.push_back(U'\n');
+			}
+			t->setText(std::move(text));
+			check();
+			
+			for(size_t l : {size_t(0), size_t(1), size_t(31), size_t(32), size_t(63), size_t(64), size_t(99), size_t(100)}){
+				t->insertText(t->lineStart(l), U"bb");
+				check();
+				t->insertText(t->lineStart(l), U"\n");
+				check();
+				t->eraseText(t->lineStart(l + 1) - 1, 1);
+				check();
+				if(l + 1 != t->numLines()){
+					//delete the newline at the end of the line and put it back
+					size_t end = t->lineStart(l + 1) - 1;
+					t->eraseText(end, 1);
+					check();
+					t->insertText(end, U"\n");
+					check();
+				}
+			}
+		}
+		
+		t->setText(std::u32string());
+		check();
+	}
+	
+	//test paragraph layout line breaking
+	{
+		//monospace font without kerning
+		class FakeFont : public morda::Font{
+		public:
+			morda::real advance;
+			
+			FakeFont(morda::real advance) :
+					advance(advance)
+			{
+				this->height_v = advance;
+				this->ascender_v = advance;
+				this->descender_v = 0;
+			}
+			
+			morda::real charAdvance(char32_t c)const override{
+				return this->advance;
+			}
+		
+		protected:
+			morda::real renderStringInternal(const morda::Matr4r& matrix, kolme::Vec4f color, const std::u32string& str)const override{
+				return this->stringAdvanceInternal(str);
+			}
+			
+			morda::real stringAdvanceInternal(const std::u32string& str)const override{
+				return morda::real(str.size()) * this->advance;
+			}
+			
+			morda::Rectr stringBoundingBoxInternal(const std::u32string& str)const override{
+				return morda::Rectr(0, -this->advance, this->stringAdvanceInternal(str), this->advance);
+			}
+		};
+		
+		FakeFont font(10);
+		
+		struct ExpectedLine{
+			size_t begin;
+			size_t end;
+			morda::real width;
+		};
+		
+		auto check = [&font](const std::u32string& str, morda::real width, std::vector<ExpectedLine> expected){
+			morda::TextStorage text(str);
+			morda::ParagraphLayout layout;
+			
+			auto& lines = layout.lines(text, font, width);
+			
+			ASSERT_INFO_ALWAYS(lines.size() == expected.size(), "width = " << width << ", lines.size() = " << lines.size() << ", expected " << expected.size())
+			for(size_t i = 0; i != lines.size(); ++i){
+				ASSERT_INFO_ALWAYS(
+						lines[i].begin == expected[i].begin && lines[i].end == expected[i].end && lines[i].width == expected[i].width,
+						"width = " << width << ", line " << i << " = (" << lines[i].begin << ", " << lines[i].end << ", " << lines[i].width << ")"
+					)
+			}
+		};
+		
+		const morda::real wide = 1000;
+		
+		//mandatory breaks
+		check(U"ab\ncd", wide, {{0, 2, 20}, {3, 5, 20}});
+		check(U"ab\n\ncd", wide, {{0, 2, 20}, {3, 3, 0}, {4, 6, 20}});
+		check(U"a\u2028b", wide, {{0, 1, 10}, {2, 3, 10}});
+		
+		//CR LF is one line break, lone CR is a line break too
+		check(U"ab\r\ncd", wide, {{0, 2, 20}, {4, 6, 20}});
+		check(U"ab\rcd", wide, {{0, 2, 20}, {3, 5, 20}});
+		check(U"ab\r\n", wide, {{0, 2, 20}, {4, 4, 0}});
+		
+		//empty text and empty last line
+		check(U"", wide, {{0, 0, 0}});
+		check(U"\n", wide, {{0, 0, 0}, {1, 1, 0}});
+		check(U"ab\n", wide, {{0, 2, 20}, {3, 3, 0}});
+		
+		//break after spaces, trailing spaces are not counted to the line width
+		check(U"ab cd", 30, {{0, 2, 20}, {3, 5, 20}});
+		check(U"ab   cd", 30, {{0, 2, 20}, {5, 7, 20}});
+		check(U"x ab cd", 50, {{0, 4, 40}, {5, 7, 20}});
+		
+		//no break at no-break space
+		check(U"x ab\u00a0cd", 50, {{0, 1, 10}, {2, 7, 50}});
+		
+		//break after hyphen, but not between minus sign and digit
+		check(U"ab-cd", 40, {{0, 3, 30}, {3, 5, 20}});
+		check(U"ab-12", 40, {{0, 4, 40}, {4, 5, 10}});
+		check(U"x -1", 30, {{0, 1, 10}, {2, 4, 20}});
+		
+		//break between ideographs, but not before closing punctuation
+		check(U"\u4e00\u4e8c\u4e09", 20, {{0, 2, 20}, {2, 3, 10}});
+		check(U"\u4e00\u4e8c\u3002", 20, {{0, 1, 10}, {1, 3, 20}});
+		check(U"ab\u4e00cd", 30, {{0, 3, 30}, {3, 5, 20}});
+		
+		//segments which do not fit the width are broken between characters
+		check(U"abcdefg", 30, {{0, 3, 30}, {3, 6, 30}, {6, 7, 10}});
+		check(U"abc", 5, {{0, 1, 10}, {1, 2, 10}, {2, 3, 10}});
+		check(U"x abcdefg", 30, {{0, 1, 10}, {2, 5, 30}, {5, 8, 30}, {8, 9, 10}});
+		
+		//natural width and layouts for different widths from the same measurements
+		{
+			morda::TextStorage text(U"ab cd\nefgh");
+			morda::ParagraphLayout layout;
+			
+			ASSERT_ALWAYS(layout.naturalWidth(text, font) == 50)
+			ASSERT_ALWAYS(layout.lines(text, font, wide).size() == 2)
+			ASSERT_ALWAYS(layout.lines(text, font, 30).size() == 4)
+			ASSERT_ALWAYS(layout.lines(text, font, wide).size() == 2)
+			
+			//changed font metrics are picked up after invalidation
+			font.advance = 20;
+			layout.invalidate();
+			ASSERT_ALWAYS(layout.naturalWidth(text, font) == 100)
+			font.advance = 10;
+		}
+		
+		//setting a font to the wrapped text widget drops the measurements, even if the font object is at the same address
+		{
+			morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+			m.resMan.mountResPack(papki::FSFile("../../res/morda_res/fonts/"));
+			
+			std::unique_ptr<FakeFont> fakeFont(new FakeFont(10));
+			auto& f = *fakeFont;
+			auto resFont = std::make_shared<morda::ResFont>(std::move(fakeFont));
+			
+			morda::WrappedText w;
+			w.setText(U"abcd");
+			w.setFont(resFont);
+			ASSERT_ALWAYS(w.measure(morda::Vec2r(-1)).x == 40)
+			
+			f.advance = 20;
+			w.setFont(resFont);
+			ASSERT_INFO_ALWAYS(w.measure(morda::Vec2r(-1)).x == 80, "x = " << w.measure(morda::Vec2r(-1)).x)
+		}
+	}
+	
+	//test that dropdown selector popup only creates widgets for the items which fit the screen
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		{
+			papki::FSFile fi("../../res/morda_res/");
+			m.initStandardWidgets(fi);
+		}
+		
+		class Provider : public morda::DropDownSelector::ItemsProvider{
+		public:
+			size_t count()const noexcept override{
+				return 1000;
+			}
+			
+			std::shared_ptr<morda::Widget> getWidget(size_t index)override{
+				return morda::Morda::inst().inflater.inflate("Widget{layout{dx{10}dy{20}}}");
+			}
+		};
+		
+		auto w = m.inflater.inflate(R"(
+				Overlay{
+					layout{dx{fill}dy{fill}}
+					Pile{
+						layout{dx{fill}dy{fill}}
+						DropDownSelector{
+							id{dds}
+							layout{dx{100}dy{20}}
+						}
+					}
+				}
+			)");
+		m.setViewportSize(morda::Vec2r(300, 400));
+		m.setRootWidget(w);
+		
+		auto dds = w->findByIdAs<morda::DropDownSelector>("dds");
+		ASSERT_ALWAYS(dds)
+		dds->setItemsProvider(std::make_shared<Provider>());
+		
+		//open the popup
+		//the selector is in the center of the pile
+		w->onMouseButton(true, morda::Vec2r(150, 200), morda::MouseButton_e::LEFT, 0);
+		
+		auto list = w->findByIdAs<morda::VList>("morda_contextmenu_content");
+		ASSERT_ALWAYS(list)
+		
+		//about (400 - 210) / 20 items fit below the selector
+		ASSERT_INFO_ALWAYS(list->visibleCount() != 0 && list->visibleCount() <= 25, "list->visibleCount() = " << list->visibleCount())
+	}
+	
+	//test that damage reported by a child of scrolled ScrollArea is shifted by the scroll position
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		
+		auto w = m.inflater.inflate(R"(
+				ScrollArea{
+					Widget{
+						layout{dx{300}dy{300}}
+					}
+					Widget{
+						id{small}
+						layout{dx{10}dy{10}}
+					}
+				}
+			)");
+		m.setViewportSize(morda::Vec2r(100, 100));
+		m.setRootWidget(w);
+		
+		auto sa = std::dynamic_pointer_cast<morda::ScrollArea>(w);
+		ASSERT_ALWAYS(sa)
+		
+		auto small = w->findById("small");
+		ASSERT_ALWAYS(small)
+		small->moveTo(morda::Vec2r(50, 60));
+		
+		sa->setScrollPos(morda::Vec2r(20, 30));
+		
+		m.renderDamaged();
+		
+		small->setRedrawNeeded();
+		
+		auto damage = m.renderDamaged();
+		ASSERT_INFO_ALWAYS(damage.size() == 1, "damage.size() = " << damage.size())
+		ASSERT_INFO_ALWAYS(damage[0].p == morda::Vec2r(30, 30), "damage[0].p = " << damage[0].p)
+		ASSERT_INFO_ALWAYS(damage[0].d == morda::Vec2r(10, 10), "damage[0].d = " << damage[0].d)
+	}
+	
+	//test that retained render list is replayed within scissor rectangle of a different damaged region, without re-recording
+	{
+		morda::Morda m(std::make_shared<FakeRenderer>(), 0, 0, [](std::function<void()>&&){});
+		m.renderer().setViewport(kolme::Recti(0, 0, 100, 100));
+		
+		struct CountingWidget : morda::Widget{
+			mutable unsigned numRenders = 0;
+			
+			CountingWidget() :
+					morda::Widget(nullptr)
+			{}
+			
+			void render(const morda::Matr4r& matrix)const override{
+				++this->numRenders;
+			}
+		};
+		
+		auto w = m.inflater.inflate(R"(
+				Pile{
+					Widget{
+						id{other}
+						layout{dx{10}dy{10}}
+					}
+				}
+			)");
+		auto pile = std::dynamic_pointer_cast<morda::Pile>(w);
+		ASSERT_ALWAYS(pile)
+		
+		auto retained = std::make_shared<CountingWidget>();
+		retained->setRetain(true);
+		pile->add(retained);
+		pile->getLayoutParams(*retained).dim = morda::Vec2r(50);
+		
+		m.setViewportSize(morda::Vec2r(100, 100));
+		m.setRootWidget(w);
+		
+		m.renderDamaged();
+		ASSERT_INFO_ALWAYS(retained->numRenders == 1, "retained->numRenders = " << retained->numRenders)
+		
+		w->findById("other")->setRedrawNeeded();
+		auto damage = m.renderDamaged();
+		ASSERT_INFO_ALWAYS(damage.size() == 1 && damage[0].d == morda::Vec2r(10), "damage.size() = " << damage.size())
+		ASSERT_INFO_ALWAYS(retained->numRenders == 1, "retained->numRenders = " << retained->numRenders)
+	}
+	
+	//test that asynchronous inflation applies leading definitions and that its results are dropped after Morda is destroyed
+	{
+		std::vector<std::function<void()>> uiQueue;
+		std::mutex uiQueueMutex;
+		
+		auto waitUiQueue = [&uiQueue, &uiQueueMutex](size_t size){
+			for(;;){
+				{
+					std::lock_guard<std::mutex> lock(uiQueueMutex);
+					if(uiQueue.size() >= size){
+						return;
+					}
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		};
+		
+		unsigned numDone = 0;
+		
+		{
+			morda::Morda m(
+					std::make_shared<FakeRenderer>(),
+					0,
+					0,
+					[&uiQueue, &uiQueueMutex](std::function<void()>&& f){
+						std::lock_guard<std::mutex> lock(uiQueueMutex);
+						uiQueue.push_back(std::move(f));
+					}
+				);
+			
+			std::shared_ptr<morda::Widget> asyncWidget;
+			m.inflater.inflateAsync(
+					std::string("defs{E{Pile}} E"),
+					[&asyncWidget, &numDone](std::shared_ptr<morda::Widget> w){
+						++numDone;
+						asyncWidget = std::move(w);
+					}
+				);
+			
+			//definitions are applied on UI thread
+			waitUiQueue(1);
+			{
+				bool thrown = false;
+				try{
+					m.inflater.inflate("E");
+				}catch(morda::Inflater::Exc&){
+					thrown = true;
+				}
+				ASSERT_ALWAYS(thrown)
+			}
+			
+			uiQueue.front()();
+			uiQueue.clear();
+			ASSERT_ALWAYS(numDone == 1)
+			ASSERT_ALWAYS(std::dynamic_pointer_cast<morda::Pile>(asyncWidget))
+			ASSERT_ALWAYS(std::dynamic_pointer_cast<morda::Pile>(m.inflater.inflate("E")))
+			
+			m.inflater.inflateAsync(
+					std::string("Widget"),
+					[&numDone](std::shared_ptr<morda::Widget> w){
+						++numDone;
+					}
+				);
+			waitUiQueue(1);
+		}
+		
+		//Morda is destroyed, the result posted to UI thread is dropped
+		ASSERT_ALWAYS(uiQueue.size() == 1)
+		uiQueue.front()();
+		ASSERT_ALWAYS(numDone == 1)
+	}
+	
 	return 0;
 }